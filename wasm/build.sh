@@ -70,7 +70,9 @@ fi
 if [[ "$CMAKE_DIR" == "cmake.desktop" ]]; then
     cmake -S "$CMAKE_DIR" -B "$BUILD_DIR" && make -C "$BUILD_DIR"
 elif [[ "$CMAKE_DIR" == "cmake.wasm" ]]; then
-    emcmake cmake -S "$CMAKE_DIR" -B "$BUILD_DIR" && make -C "$BUILD_DIR"
+    # the asset packer runs on the host, build it and the archive first
+    cmake -S tools -B build.tools && make -C build.tools &&
+        emcmake cmake -S "$CMAKE_DIR" -B "$BUILD_DIR" && make -C "$BUILD_DIR"
 fi
 
 # Check for errors
@@ -668,29 +668,29 @@ namespace tinyxml2 {
 		TIXMLASSERT(sizeof(XMLComment) == sizeof(XMLDeclaration)); // use same memory pool
 		XMLNode* returnNode = 0;
 		if (XMLUtil::StringEqual(p, xmlHeader, xmlHeaderLen)) {
-			returnNode                = CreateUnlinkedNode<XMLDeclaration>(_commentPool);
+			returnNode                = CreateUnlinkedNode<XMLDeclaration>(_arena->_commentPool);
 			returnNode->_parseLineNum = _parseCurLineNum;
 			p += xmlHeaderLen;
 		} else if (XMLUtil::StringEqual(p, commentHeader, commentHeaderLen)) {
-			returnNode                = CreateUnlinkedNode<XMLComment>(_commentPool);
+			returnNode                = CreateUnlinkedNode<XMLComment>(_arena->_commentPool);
 			returnNode->_parseLineNum = _parseCurLineNum;
 			p += commentHeaderLen;
 		} else if (XMLUtil::StringEqual(p, cdataHeader, cdataHeaderLen)) {
-			XMLText* text             = CreateUnlinkedNode<XMLText>(_textPool);
+			XMLText* text             = CreateUnlinkedNode<XMLText>(_arena->_textPool);
 			returnNode                = text;
 			returnNode->_parseLineNum = _parseCurLineNum;
 			p += cdataHeaderLen;
 			text->SetCData(true);
 		} else if (XMLUtil::StringEqual(p, dtdHeader, dtdHeaderLen)) {
-			returnNode                = CreateUnlinkedNode<XMLUnknown>(_commentPool);
+			returnNode                = CreateUnlinkedNode<XMLUnknown>(_arena->_commentPool);
 			returnNode->_parseLineNum = _parseCurLineNum;
 			p += dtdHeaderLen;
 		} else if (XMLUtil::StringEqual(p, elementHeader, elementHeaderLen)) {
-			returnNode                = CreateUnlinkedNode<XMLElement>(_elementPool);
+			returnNode                = CreateUnlinkedNode<XMLElement>(_arena->_elementPool);
 			returnNode->_parseLineNum = _parseCurLineNum;
 			p += elementHeaderLen;
 		} else {
-			returnNode                = CreateUnlinkedNode<XMLText>(_textPool);
+			returnNode                = CreateUnlinkedNode<XMLText>(_arena->_textPool);
 			returnNode->_parseLineNum = _parseCurLineNum; // Report line of first non-whitespace character
 			p                         = start;            // Back it up, all the text counts.
 			_parseCurLineNum          = startLine;
@@ -1727,10 +1727,11 @@ namespace tinyxml2 {
 	}
 
 	XMLAttribute* XMLElement::CreateAttribute() {
-		TIXMLASSERT(sizeof(XMLAttribute) == _document->_attributePool.ItemSize());
-		XMLAttribute* attrib = new (_document->_attributePool.Alloc()) XMLAttribute();
+		MemPoolT<sizeof(XMLAttribute)>& pool = _document->_arena->_attributePool;
+		TIXMLASSERT(sizeof(XMLAttribute) == pool.ItemSize());
+		XMLAttribute* attrib = new (pool.Alloc()) XMLAttribute();
 		TIXMLASSERT(attrib);
-		attrib->_memPool = &_document->_attributePool;
+		attrib->_memPool = &pool;
 		attrib->_memPool->SetTracked();
 		return attrib;
 	}
@@ -1859,10 +1860,10 @@ namespace tinyxml2 {
 	                                                         "XML_NO_TEXT_NODE",
 	                                                         "XML_ELEMENT_DEPTH_EXCEEDED"};
 
-	XMLDocument::XMLDocument(bool processEntities, Whitespace whitespaceMode)
+	XMLDocument::XMLDocument(bool processEntities, Whitespace whitespaceMode, XMLArena* arena)
 	    : XMLNode(0), _writeBOM(false), _processEntities(processEntities), _errorID(XML_SUCCESS),
-	      _whitespaceMode(whitespaceMode), _errorStr(), _errorLineNum(0), _charBuffer(0), _parseCurLineNum(0),
-	      _parsingDepth(0), _unlinked(), _elementPool(), _attributePool(), _textPool(), _commentPool() {
+	      _whitespaceMode(whitespaceMode), _errorStr(), _errorLineNum(0), _charBuffer(0), _ownsCharBuffer(true),
+	      _parseCurLineNum(0), _parsingDepth(0), _unlinked(), _ownArena(), _arena(arena ? arena : &_ownArena) {
 		// avoid VC++ C4355 warning about 'this' in initializer list (C4355 is off by default in VS2012+)
 		_document = this;
 	}
@@ -1894,23 +1895,27 @@ namespace tinyxml2 {
 #endif
 		ClearError();
 
-		delete[] _charBuffer;
-		_charBuffer   = 0;
-		_parsingDepth = 0;
+		if (_ownsCharBuffer) {
+			delete[] _charBuffer;
+		}
+		_charBuffer     = 0;
+		_ownsCharBuffer = true;
+		_parsingDepth   = 0;
 
 #if 0
-    _textPool.Trace( "text" );
-    _elementPool.Trace( "element" );
-    _commentPool.Trace( "comment" );
-    _attributePool.Trace( "attribute" );
+    _arena->_textPool.Trace( "text" );
+    _arena->_elementPool.Trace( "element" );
+    _arena->_commentPool.Trace( "comment" );
+    _arena->_attributePool.Trace( "attribute" );
 #endif
 
 #ifdef TINYXML2_DEBUG
-		if (!hadError) {
-			TIXMLASSERT(_elementPool.CurrentAllocs() == _elementPool.Untracked());
-			TIXMLASSERT(_attributePool.CurrentAllocs() == _attributePool.Untracked());
-			TIXMLASSERT(_textPool.CurrentAllocs() == _textPool.Untracked());
-			TIXMLASSERT(_commentPool.CurrentAllocs() == _commentPool.Untracked());
+		// a shared arena also counts the nodes of the other documents
+		if (!hadError && _arena == &_ownArena) {
+			TIXMLASSERT(_ownArena._elementPool.CurrentAllocs() == _ownArena._elementPool.Untracked());
+			TIXMLASSERT(_ownArena._attributePool.CurrentAllocs() == _ownArena._attributePool.Untracked());
+			TIXMLASSERT(_ownArena._textPool.CurrentAllocs() == _ownArena._textPool.Untracked());
+			TIXMLASSERT(_ownArena._commentPool.CurrentAllocs() == _ownArena._commentPool.Untracked());
 		}
 #endif
 	}
@@ -1928,31 +1933,31 @@ namespace tinyxml2 {
 	}
 
 	XMLElement* XMLDocument::NewElement(const char* name) {
-		XMLElement* ele = CreateUnlinkedNode<XMLElement>(_elementPool);
+		XMLElement* ele = CreateUnlinkedNode<XMLElement>(_arena->_elementPool);
 		ele->SetName(name);
 		return ele;
 	}
 
 	XMLComment* XMLDocument::NewComment(const char* str) {
-		XMLComment* comment = CreateUnlinkedNode<XMLComment>(_commentPool);
+		XMLComment* comment = CreateUnlinkedNode<XMLComment>(_arena->_commentPool);
 		comment->SetValue(str);
 		return comment;
 	}
 
 	XMLText* XMLDocument::NewText(const char* str) {
-		XMLText* text = CreateUnlinkedNode<XMLText>(_textPool);
+		XMLText* text = CreateUnlinkedNode<XMLText>(_arena->_textPool);
 		text->SetValue(str);
 		return text;
 	}
 
 	XMLDeclaration* XMLDocument::NewDeclaration(const char* str) {
-		XMLDeclaration* dec = CreateUnlinkedNode<XMLDeclaration>(_commentPool);
+		XMLDeclaration* dec = CreateUnlinkedNode<XMLDeclaration>(_arena->_commentPool);
 		dec->SetValue(str ? str : "xml version=\"1.0\" encoding=\"UTF-8\"");
 		return dec;
 	}
 
 	XMLUnknown* XMLDocument::NewUnknown(const char* str) {
-		XMLUnknown* unk = CreateUnlinkedNode<XMLUnknown>(_commentPool);
+		XMLUnknown* unk = CreateUnlinkedNode<XMLUnknown>(_arena->_commentPool);
 		unk->SetValue(str);
 		return unk;
 	}
@@ -2054,7 +2059,7 @@ namespace tinyxml2 {
 
 		_charBuffer[size] = 0;
 
-		Parse();
+		ParseCharBuffer(size);
 		return _errorID;
 	}
 
@@ -2099,18 +2104,110 @@ namespace tinyxml2 {
 		memcpy(_charBuffer, xml, nBytes);
 		_charBuffer[nBytes] = 0;
 
+		ParseCharBuffer(nBytes);
+		return _errorID;
+	}
+
+	XMLError XMLDocument::ParseInSitu(char* xml, size_t nBytes) {
+		Clear();
+
+		if (nBytes == 0 || !xml) {
+			SetError(XML_ERROR_EMPTY_DOCUMENT, 0, 0);
+			return _errorID;
+		}
+		if (nBytes == static_cast<size_t>(-1)) {
+			nBytes = strlen(xml);
+		} else {
+			xml[nBytes] = 0;
+		}
+		if (!*xml) {
+			SetError(XML_ERROR_EMPTY_DOCUMENT, 0, 0);
+			return _errorID;
+		}
+
+		TIXMLASSERT(_charBuffer == 0);
+		_charBuffer     = xml;
+		_ownsCharBuffer = false;
+
+		ParseCharBuffer(nBytes);
+		return _errorID;
+	}
+
+	void XMLDocument::ParseCharBuffer(size_t nBytes) {
+		_arena->Reserve(_charBuffer, nBytes);
+
 		Parse();
 		if (Error()) {
 			// clean up now essentially dangling memory.
 			// and the parse fail can put objects in the
 			// pools that are dead and inaccessible.
+			// A shared arena may hold other documents, see XMLArena::Clear().
 			DeleteChildren();
-			_elementPool.Clear();
-			_attributePool.Clear();
-			_textPool.Clear();
-			_commentPool.Clear();
+			if (_arena == &_ownArena) {
+				_ownArena.Clear();
+			}
 		}
-		return _errorID;
+	}
+
+	// --------- XMLArena ----------- //
+
+	void XMLArena::Clear() {
+		_elementPool.Clear();
+		_attributePool.Clear();
+		_textPool.Clear();
+		_commentPool.Clear();
+	}
+
+	void XMLArena::Reserve(int elements, int attributes, int texts, int comments) {
+		_elementPool.Reserve(elements);
+		_attributePool.Reserve(attributes);
+		_textPool.Reserve(texts);
+		_commentPool.Reserve(comments);
+	}
+
+	void XMLArena::Reserve(const char* xml, size_t nBytes) {
+		// Every '<' opens an element, a comment, a declaration or an end
+		// tag, every '=' is an attribute unless it sits in text. Text
+		// nodes are guessed from the elements, documents made of
+		// elements with attributes only have few.
+		int tags       = 0;
+		int endTags    = 0;
+		int comments   = 0;
+		int attributes = 0;
+		for (const char* p = xml; p < xml + nBytes; ++p) {
+			if (*p == '<') {
+				++tags;
+				if (p + 1 < xml + nBytes) {
+					endTags += p[1] == '/';
+					comments += p[1] == '!' || p[1] == '?';
+				}
+			} else if (*p == '=') {
+				++attributes;
+			}
+		}
+		const int elements = tags - endTags - comments;
+		Reserve(elements, attributes, elements / 4, comments);
+	}
+
+	XMLArenaStats XMLArena::Stats() const {
+		XMLArenaStats stats;
+		stats.nodes = _elementPool.CurrentAllocs() + _attributePool.CurrentAllocs() + _textPool.CurrentAllocs() +
+		              _commentPool.CurrentAllocs();
+		stats.peakNodes =
+		    _elementPool.MaxAllocs() + _attributePool.MaxAllocs() + _textPool.MaxAllocs() + _commentPool.MaxAllocs();
+		stats.totalAllocs = _elementPool.TotalAllocs() + _attributePool.TotalAllocs() + _textPool.TotalAllocs() +
+		                    _commentPool.TotalAllocs();
+		stats.heapAllocs = _elementPool.ChunkAllocs() + _attributePool.ChunkAllocs() + _textPool.ChunkAllocs() +
+		                   _commentPool.ChunkAllocs();
+		stats.bytesUsed = static_cast<size_t>(_elementPool.CurrentAllocs()) * _elementPool.ItemSize() +
+		                  static_cast<size_t>(_attributePool.CurrentAllocs()) * _attributePool.ItemSize() +
+		                  static_cast<size_t>(_textPool.CurrentAllocs()) * _textPool.ItemSize() +
+		                  static_cast<size_t>(_commentPool.CurrentAllocs()) * _commentPool.ItemSize();
+		stats.bytesHeld = static_cast<size_t>(_elementPool.Items()) * _elementPool.ItemSize() +
+		                  static_cast<size_t>(_attributePool.Items()) * _attributePool.ItemSize() +
+		                  static_cast<size_t>(_textPool.Items()) * _textPool.ItemSize() +
+		                  static_cast<size_t>(_commentPool.Items()) * _commentPool.ItemSize();
+		return stats;
 	}
 
 	void XMLDocument::Print(XMLPrinter* streamer) const {
@@ -336,37 +336,48 @@ namespace tinyxml2 {
 	template<int ITEM_SIZE>
 	class MemPoolT: public MemPool {
 	  public:
-		MemPoolT(): _blockPtrs(), _root(0), _currentAllocs(0), _nAllocs(0), _maxAllocs(0), _nUntracked(0) {}
+		MemPoolT()
+		    : _chunkPtrs(), _root(0), _nItems(0), _currentAllocs(0), _nAllocs(0), _maxAllocs(0), _nUntracked(0),
+		      _nChunkAllocs(0) {}
 		~MemPoolT() { MemPoolT<ITEM_SIZE>::Clear(); }
 
 		void Clear() {
-			// Delete the blocks.
-			while (!_blockPtrs.Empty()) {
-				Block* lastBlock = _blockPtrs.Pop();
-				delete lastBlock;
+			// Delete the chunks.
+			while (!_chunkPtrs.Empty()) {
+				Item* lastChunk = _chunkPtrs.Pop();
+				delete[] lastChunk;
 			}
 			_root          = 0;
+			_nItems        = 0;
 			_currentAllocs = 0;
 			_nAllocs       = 0;
 			_maxAllocs     = 0;
 			_nUntracked    = 0;
 		}
 
+		/**
+		    Makes sure 'count' more items can be allocated without
+		    going to the heap, the missing ones come in a single chunk.
+		*/
+		void Reserve(int count) {
+			const int available = _nItems - _currentAllocs;
+			if (count > available) {
+				AddChunk(count - available);
+			}
+		}
+
 		virtual int ItemSize() const { return ITEM_SIZE; }
 		int         CurrentAllocs() const { return _currentAllocs; }
+		int         MaxAllocs() const { return _maxAllocs; }
+		int         TotalAllocs() const { return _nAllocs; }
+		int         Items() const { return _nItems; }
+		int         Chunks() const { return _chunkPtrs.Size(); }
+		int         ChunkAllocs() const { return _nChunkAllocs; }
 
 		virtual void* Alloc() {
 			if (!_root) {
-				// Need a new block.
-				Block* block = new Block();
-				_blockPtrs.Push(block);
-
-				Item* blockItems = block->items;
-				for (int i = 0; i < ITEMS_PER_BLOCK - 1; ++i) {
-					blockItems[i].next = &(blockItems[i + 1]);
-				}
-				blockItems[ITEMS_PER_BLOCK - 1].next = 0;
-				_root                                = blockItems;
+				// Need a new chunk.
+				AddChunk(ITEMS_PER_BLOCK);
 			}
 			Item* const result = _root;
 			TIXMLASSERT(result != 0);
@@ -394,14 +405,14 @@ namespace tinyxml2 {
 			_root      = item;
 		}
 		void Trace(const char* name) {
-			printf("Mempool %s watermark=%d [%dk] current=%d size=%d nAlloc=%d blocks=%d\n",
+			printf("Mempool %s watermark=%d [%dk] current=%d size=%d nAlloc=%d chunks=%d\n",
 			       name,
 			       _maxAllocs,
 			       _maxAllocs * ITEM_SIZE / 1024,
 			       _currentAllocs,
 			       ITEM_SIZE,
 			       _nAllocs,
-			       _blockPtrs.Size());
+			       _chunkPtrs.Size());
 		}
 
 		void SetTracked() { --_nUntracked; }
@@ -419,6 +430,7 @@ namespace tinyxml2 {
 		//		64k:	4000	21000
 		// Declared public because some compilers do not accept to use ITEMS_PER_BLOCK
 		// in private part if ITEMS_PER_BLOCK is private
+		// Chunks made by Reserve() hold as many items as asked instead.
 		enum { ITEMS_PER_BLOCK = (4 * 1024) / ITEM_SIZE };
 
 	  private:
@@ -429,16 +441,29 @@ namespace tinyxml2 {
 			Item* next;
 			char  itemData[ITEM_SIZE];
 		};
-		struct Block {
-			Item items[ITEMS_PER_BLOCK];
-		};
-		DynArray<Block*, 10> _blockPtrs;
-		Item*                _root;
 
+		void AddChunk(int count) {
+			Item* chunk = new Item[count];
+			_chunkPtrs.Push(chunk);
+			++_nChunkAllocs;
+
+			for (int i = 0; i < count - 1; ++i) {
+				chunk[i].next = &(chunk[i + 1]);
+			}
+			chunk[count - 1].next = _root;
+			_root                 = chunk;
+			_nItems += count;
+		}
+
+		DynArray<Item*, 10> _chunkPtrs;
+		Item*               _root;
+
+		int _nItems;
 		int _currentAllocs;
 		int _nAllocs;
 		int _maxAllocs;
 		int _nUntracked;
+		int _nChunkAllocs; // not reset by Clear(), the heap allocations over the pool's life
 	};
 
 	/**
@@ -1555,6 +1580,66 @@ namespace tinyxml2 {
 
 	enum Whitespace { PRESERVE_WHITESPACE, COLLAPSE_WHITESPACE };
 
+	/// Allocation statistics of an XMLArena, see XMLArena::Stats().
+	struct XMLArenaStats {
+		int    nodes;       ///< Nodes and attributes in use.
+		int    peakNodes;   ///< Sum of the most nodes of each kind in use at once.
+		int    totalAllocs; ///< Nodes and attributes allocated since the last Clear().
+		int    heapAllocs;  ///< Chunks taken from the heap over the arena's life.
+		size_t bytesUsed;   ///< Memory held by the nodes and attributes in use.
+		size_t bytesHeld;   ///< Memory held by the chunks.
+	};
+
+	/** Holds the nodes and attributes of documents.
+
+	    A document makes its own arena unless it is given one. An arena
+	    given to several documents, one after the other or at the same
+	    time, keeps its memory between them: the nodes of a cleared or
+	    deleted document are reused by the next ones, and everything is
+	    freed at once by Clear() or the destructor.
+
+	    Parse() reserves room for the nodes it expects from a quick scan
+	    of the text, so a new arena grows in a few large chunks and a
+	    reused one does not allocate at all.
+
+	    The arena must outlive the documents using it. It is not thread
+	    safe, nor are the documents.
+	*/
+	class TINYXML2_LIB XMLArena {
+		friend class XMLDocument;
+		friend class XMLElement;
+
+	  public:
+		XMLArena() {}
+
+		/**
+		    Frees every chunk in one go. No document may be using the
+		    arena anymore. A failed parse leaves its nodes in the arena
+		    until then.
+		*/
+		void Clear();
+
+		/// Makes room for that many more nodes and attributes.
+		void Reserve(int elements, int attributes, int texts, int comments);
+
+		/**
+		    Makes room for the nodes of a document from a quick scan
+		    of its text, which counts the markup characters.
+		*/
+		void Reserve(const char* xml, size_t nBytes);
+
+		XMLArenaStats Stats() const;
+
+	  private:
+		XMLArena(const XMLArena&);       // not supported
+		void operator=(const XMLArena&); // not supported
+
+		MemPoolT<sizeof(XMLElement)>   _elementPool;
+		MemPoolT<sizeof(XMLAttribute)> _attributePool;
+		MemPoolT<sizeof(XMLText)>      _textPool;
+		MemPoolT<sizeof(XMLComment)>   _commentPool;
+	};
+
 	/** A Document binds together all the functionality.
 	    It can be saved, loaded, and printed to the screen.
 	    All Nodes are connected and allocated to a Document.
@@ -1571,8 +1656,8 @@ namespace tinyxml2 {
 		friend class XMLUnknown;
 
 	  public:
-		/// constructor
-		XMLDocument(bool processEntities = true, Whitespace whitespaceMode = PRESERVE_WHITESPACE);
+		/// constructor, the nodes come from 'arena' when given, see XMLArena.
+		XMLDocument(bool processEntities = true, Whitespace whitespaceMode = PRESERVE_WHITESPACE, XMLArena* arena = 0);
 		~XMLDocument();
 
 		virtual XMLDocument* ToDocument() {
@@ -1596,6 +1681,23 @@ namespace tinyxml2 {
 		*/
 		XMLError Parse(const char* xml, size_t nBytes = static_cast<size_t>(-1));
 
+		/**
+		    Parse an XML buffer in place, without copying it.
+		    Returns XML_SUCCESS (0) on success, or
+		    an errorID.
+
+		    The buffer is tokenized where it is: names, values and
+		    text are null terminated and have their entities decoded
+		    in 'xml' itself, and the nodes point into it. It must be
+		    writable, hold at least 'nBytes' + 1 bytes (a null is
+		    written at xml[nBytes]) and outlive the document or its
+		    next Parse / Clear.
+
+		    If 'nBytes' is not specified, 'xml' must already be a
+		    null terminated string.
+		*/
+		XMLError ParseInSitu(char* xml, size_t nBytes = static_cast<size_t>(-1));
+
 		/**
 		    Load an XML file from disk.
 		    Returns XML_SUCCESS (0) on success, or
@@ -1762,6 +1864,7 @@ namespace tinyxml2 {
 		mutable StrPair _errorStr;
 		int             _errorLineNum;
 		char*           _charBuffer;
+		bool            _ownsCharBuffer; // false for a buffer given to ParseInSitu
 		int             _parseCurLineNum;
 		int             _parsingDepth;
 		// Memory tracking does add some overhead.
@@ -1772,14 +1875,13 @@ namespace tinyxml2 {
 		// and the performance is the same.
 		DynArray<XMLNode*, 10> _unlinked;
 
-		MemPoolT<sizeof(XMLElement)>   _elementPool;
-		MemPoolT<sizeof(XMLAttribute)> _attributePool;
-		MemPoolT<sizeof(XMLText)>      _textPool;
-		MemPoolT<sizeof(XMLComment)>   _commentPool;
+		XMLArena  _ownArena;
+		XMLArena* _arena;
 
 		static const char* _errorNames[XML_ERROR_COUNT];
 
 		void Parse();
+		void ParseCharBuffer(size_t nBytes);
 
 		void SetError(XMLError error, int lineNum, const char* format, ...);
 
@@ -26,6 +26,8 @@ class AnimationController {
 
 	bool has_animations() { return !_animations.empty(); }
 
+	std::map<std::string, Animation>& get_animations() { return _animations; }
+
 	void play(const std::string& name = "") {
 		if (_animations.empty()) return;
 		if (_current_animation_name == name) return;
@@ -45,22 +47,10 @@ class AnimationController {
 
 	void update(float delta_time);
 
-	friend std::ostream& operator<<(std::ostream& os, const AnimationController& controller) {
-		os << "{\n";
-		// os << "  \"animations\": [\n";
-		// for (auto it = controller._animations.begin(); it != controller._animations.end(); ++it) {
-		// 	os << "    \"" << it->first << "\": " << it->second << ",\n";
-		// }
-		// os << "  ],\n";
-		os << "  \"current_animation_name\": \"" << controller._current_animation_name << "\",\n";
-		os << "  \"animation_count\": " << controller._animations.size() << ",\n";
-		os << "  \"speed\": " << std::setprecision(2) << std::fixed << controller.speed << ",\n";
-		os << "  \"current_frame_index\": " << controller.current_frame_index << ",\n";
-		os << "  \"timer\": " << std::setprecision(2) << std::fixed << controller._timer << ",\n";
-		os << "  \"is_playing\": " << std::boolalpha << controller._is_playing << "\n";
-		os << "}";
-		return os;
-	}
+	const std::string& get_current_animation_name() const { return _current_animation_name; }
+	int                get_current_frame_index() const { return current_frame_index; }
+	float              get_timer() const { return _timer; }
+	bool               get_is_playing() const { return _is_playing; }
 
   private:
 	std::map<std::string, Animation> _animations;
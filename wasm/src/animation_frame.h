@@ -5,10 +5,12 @@
 struct AnimationFrame {
 	SDL_Rect              rect;
 	int                   duration;
-	bool                  is_flipped;
+	bool                  is_flipped; // drawn mirrored horizontally
 	std::function<void()> callback;
 	int                   loop_count         = 0;
 	int                   current_loop_count = 0;
+	SDL_Texture*          texture            = nullptr; // atlas page, nullptr means the sprite's own texture
+	SDL_Rect              trim               = {0, 0, 0, 0}; // offset of rect in the unflipped frame and its size
 
 	AnimationFrame() {}
 
@@ -24,7 +26,8 @@ struct AnimationFrame {
 
 	AnimationFrame(const AnimationFrame& other)
 	    : rect(other.rect), duration(other.duration), is_flipped(other.is_flipped), loop_count(other.loop_count),
-	      current_loop_count(other.current_loop_count), callback(other.callback) {}
+	      current_loop_count(other.current_loop_count), callback(other.callback), texture(other.texture),
+	      trim(other.trim) {}
 
 	// overload the ostream operator<< to print the callback
 	friend std::ostream& operator<<(std::ostream& os, const AnimationFrame& animation_frame) {
@@ -5,6 +5,7 @@ Application::Application() {}
 Application::~Application() {
 	//? NOTE: window and renderer are smart pointers, so they will be destroyed
 	// automatically
+	if (_overlay_texture != nullptr) SDL_DestroyTexture(_overlay_texture);
 
 	SDL_Quit();
 	TTF_Quit();
@@ -35,6 +36,7 @@ int Application::run() {
 		    Application *app = static_cast<Application *>(arg);
 		    app->on_loop_start();
 		    app->handle_events();
+		    app->process_input_events();
 		    app->handle_input();
 		    app->update_delta_time();
 		    app->update();
@@ -47,6 +49,7 @@ int Application::run() {
 	while (app->_running) {
 		app->on_loop_start();
 		app->handle_events();
+		app->process_input_events();
 		app->handle_input();
 		app->update_delta_time();
 		app->update();
@@ -84,6 +87,13 @@ bool Application::init() {
 		return false;
 	}
 
+	// without an archive the assets are read from the source tree
+	if (!AssetArchive::open(ASSET_ARCHIVE_PATH)) {
+		printf("No asset archive, loading loose files from %s\n", ASSET_ROOT);
+	}
+
+	register_stats();
+
 	_running = true;
 
 	printf("SDL initialised successfully\n");
@@ -92,7 +102,34 @@ bool Application::init() {
 }
 
 bool Application::load_assets() {
-	if (!AssetManager::load_texture("../src/assets/images/characters_no_bg.png")) return false;
+	// decoded in the background, the textures stay transparent until uploaded
+	_background_texture = AssetManager::load_texture_async(ASSET_ROOT "tiled/zoo_1.png");
+	_player_texture     = AssetManager::load_texture_async(ASSET_ROOT "images/characters_no_bg.png");
+	//? NOTE: the pokemon sheet is streamed per species, see spawn_pokemon()
+
+	_overlay_font = AssetManager::load_font(ASSET_ROOT "fonts/Roboto/Roboto-Regular.ttf", 16);
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	if (!AssetManager::load_tile_map(ZOO_MAP_PATH, _map)) {
+		return false;
+	}
+	printf("Loaded %s: %dx%d tiles, %zu layers in %.2f ms\n",
+	       ZOO_MAP_PATH,
+	       _map.get_width(),
+	       _map.get_height(),
+	       _map.get_layers().size(),
+	       (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+
+	_colliders.build(_map.get_objects(), MAP_COLLIDER_GROUP);
+	_enclosures.build(_map.get_objects(), MAP_ENCLOSURE_GROUP);
+	printf("Indexed %zu colliders and %zu enclosures\n",
+	       _colliders.get_object_count(),
+	       _enclosures.get_object_count());
+
+	PathFinder::set_map(&_map);
+
+	// drawn every frame, never worth evicting
+	AssetManager::pin_texture(_background_texture);
 
 	return true;
 }
@@ -100,18 +137,41 @@ bool Application::load_assets() {
 void Application::handle_events() {
 	SDL_Event event;
 
+	// input events are queued with their timestamp, process_input_events() applies them
 	while (SDL_PollEvent(&event)) {
 		switch (event.type) {
 			case SDL_QUIT:
 				quit();
 				break;
 			case SDL_KEYDOWN:
-				handle_key_down(event.key.keysym.sym);
+				if (event.key.repeat) break;
+				InputQueue::push(event);
 				break;
 			case SDL_KEYUP:
-				handle_key_up(event.key.keysym.sym);
+			case SDL_MOUSEMOTION:
+			case SDL_MOUSEBUTTONDOWN:
+			case SDL_MOUSEBUTTONUP:
+			case SDL_MOUSEWHEEL:
+				InputQueue::push(event);
+				break;
+			case SDL_RENDER_TARGETS_RESET:
+				DynamicAtlas::restore();
+				break;
+		}
+	}
+}
+
+void Application::process_input_events() {
+	SDL_Event event;
+
+	while (InputQueue::pop(event)) {
+		switch (event.type) {
+			case SDL_KEYDOWN:
+				handle_key_down(event.key.keysym);
+				break;
+			case SDL_KEYUP:
+				handle_key_up(event.key.keysym);
 				break;
-			// mouse events
 			case SDL_MOUSEMOTION:
 				handle_mouse_motion(event.motion.x, event.motion.y);
 				break;
@@ -126,6 +186,10 @@ void Application::handle_events() {
 				break;
 		}
 	}
+
+	// every event of the frame is in, derive the transitions from them
+	InputHandler::update_key_states();
+	InputHandler::update_mouse_states();
 }
 
 bool Application::init_entities() {
@@ -135,24 +199,16 @@ bool Application::init_entities() {
 		bool is_zekrom = rand() % 2;
 		int  start_x   = is_zekrom ? 512 : 0;
 
-		Sprite new_entity =
-		    Sprite(AssetManager::get_texture("../src/assets/images/spritesheets/pokemons/pokemons_4th_gen.png"),
-		           {start_x, 2272, CHARACTER_SIZE, CHARACTER_SIZE},
-		           {rand() % _window_width, rand() % _window_height, 128, 128});
-
-		Animation idle = Animation("idle", {start_x, 2272, 64, 64}, 1, 8, AnimationDirection::LOOP, 100);
-		new_entity.get_animation_controller().add_animation("idle", idle);
-
-		new_entity.get_animation_controller().play("idle");
-
-		Application::add_entity(new_entity);
+		spawn_pokemon(start_x, rand() % _window_width, rand() % _window_height, rand() % POKEMON_SHINY_ODDS == 0);
 	}
 	printf("%zu Entities created !\n", Application::get_entities().size());
 
 	_player =
-	    std::make_unique<Character>(Character(AssetManager::get_texture("../src/assets/images/characters_no_bg.png"),
+	    std::make_unique<Character>(Character(_player_texture,
 	                                          (SDL_Rect) {0, 0, CHARACTER_SIZE, CHARACTER_SIZE},
 	                                          (SDL_Rect) {0, 0, CHARACTER_SIZE, CHARACTER_SIZE}));
+	// only the feet collide, the head and the shoulders can overlap what is behind
+	_player->set_hitbox({CHARACTER_SIZE / 4, CHARACTER_SIZE / 2, CHARACTER_SIZE / 2, CHARACTER_SIZE / 2});
 
 	Animation idle_up_animation    = Animation("idle_up", {0, 0, CHARACTER_SIZE, CHARACTER_SIZE}, 1, 1);
 	Animation idle_down_animation  = Animation("idle_down", {0, CHARACTER_SIZE, CHARACTER_SIZE, CHARACTER_SIZE}, 1, 1);
@@ -281,6 +337,13 @@ bool Application::init_entities() {
 
 	_player->set_position(_window_width / 2 - 16, _window_height / 2 - 16);
 
+	// pack every frame used above into shared pages, one texture bind for the player
+	SpriteAtlas::add_animations(ASSET_ROOT "images/characters_no_bg.png", _player->get_animation_controller());
+
+	if (!SpriteAtlas::build(_renderer.get())) {
+		printf("Failed to build the sprite atlas, sprites keep their own textures\n");
+	}
+
 	return true;
 }
 
@@ -290,26 +353,108 @@ void Application::add_entity(const Sprite &sprite) {
 	app->get_entities().push_back(std::make_unique<Sprite>(sprite));
 }
 
+void Application::spawn_pokemon(int start_x, int x, int y, bool shiny) {
+	Sprite new_entity = Sprite(TextureHandle(), {start_x, 2272, CHARACTER_SIZE, CHARACTER_SIZE}, {x, y, 128, 128});
+
+	Animation idle = Animation("idle", {start_x, 2272, 64, 64}, 1, 8, AnimationDirection::LOOP, 100);
+	new_entity.get_animation_controller().add_animation("idle", idle);
+
+	new_entity.get_animation_controller().play("idle");
+
+	Application::add_entity(new_entity);
+
+	// register the stored copy, that is the one being rendered
+	// a shiny is the same sheet read with another palette
+	std::string sheet   = shiny ? POKEMON_SHEET_PATH "#shiny" : POKEMON_SHEET_PATH;
+	std::string species = "pokemon_" + std::to_string(start_x) + (shiny ? "_shiny" : "");
+	Sprite     *pokemon = _entities.back().get();
+	_pokemons.push_back({pokemon, species});
+
+	// the feet are at the bottom of the sprite, half a tile up, moved out of the solid tiles to walk from there
+	Vector2f  feet = Vector2f(x + pokemon->get_w() * 0.5f, y + pokemon->get_h() - TILE_SIZE * 0.5f);
+	SDL_Point tile = {(int)floorf(feet.x / TILE_SIZE), (int)floorf(feet.y / TILE_SIZE)};
+	SDL_Point open = tile;
+	if (_map.find_open_tile(tile.x, tile.y, open) && (open.x != tile.x || open.y != tile.y)) {
+		feet = Vector2f((open.x + 0.5f) * TILE_SIZE, (open.y + 0.5f) * TILE_SIZE);
+		pokemon->set_position((int)(feet.x - pokemon->get_w() * 0.5f),
+		                      (int)(feet.y - pokemon->get_h() + TILE_SIZE * 0.5f));
+	}
+
+	_wanderers.push_back(Wanderer());
+	_wander_feet.push_back(feet);
+	_wander_velocities.push_back(Vector2f(0, 0));
+
+	if (DynamicAtlas::acquire(species, sheet, pokemon->get_animation_controller())) return;
+
+	// the atlas is full, fall back to the whole sheet
+	pokemon->set_texture(AssetManager::load_texture_async(sheet));
+}
+
+void Application::despawn_pokemon() {
+	if (_pokemons.empty()) return;
+
+	Sprite     *pokemon = _pokemons.back().first;
+	std::string species = _pokemons.back().second;
+	_pokemons.pop_back();
+
+	_wander_tickets.erase(_wanderers.back().ticket);
+	_wanderers.pop_back();
+	_wander_feet.swap_remove(_wander_feet.size() - 1);
+	_wander_velocities.swap_remove(_wander_velocities.size() - 1);
+
+	// hands the frames back before the controller is destroyed
+	DynamicAtlas::release(species, pokemon->get_animation_controller());
+
+	auto it = std::find_if(_entities.begin(), _entities.end(), [pokemon](const std::unique_ptr<Sprite> &entity) {
+		return entity.get() == pokemon;
+	});
+	if (it != _entities.end()) _entities.erase(it);
+}
+
 void Application::on_loop_start() {
-	InputHandler::update_key_states();
-	InputHandler::update_mouse_states();
+	AssetManager::pump_uploads(ASSET_UPLOAD_BUDGET_MS);
 }
 
 void Application::handle_input() {
 	auto input_direction = InputHandler::get_key_direction();
 
-	if (InputHandler::is_key_pressed(SDLK_b)) {
+	if (InputHandler::is_key_pressed(SDL_SCANCODE_B)) {
 		_player->toggle_on_bike();
 	}
 
+	if (InputHandler::is_key_pressed(SDL_SCANCODE_P)) {
+		spawn_pokemon(rand() % 2 ? 512 : 0,
+		              (int)InputHandler::get_mouse_position().x,
+		              (int)InputHandler::get_mouse_position().y,
+		              rand() % POKEMON_SHINY_ODDS == 0);
+	}
+
+	if (InputHandler::is_key_pressed(SDL_SCANCODE_O)) {
+		despawn_pokemon();
+	}
+
+	if (InputHandler::is_key_pressed(SDL_SCANCODE_F)) {
+		_pokemons_follow = !_pokemons_follow;
+
+		// back to wandering from where they are, not to where they were going
+		for (Wanderer &wanderer : _wanderers) {
+			wanderer.path.reset();
+		}
+	}
+
+	if (InputHandler::is_key_pressed(SDL_SCANCODE_X)) {
+		toggle_wall((int)InputHandler::get_mouse_position().x / TILE_SIZE,
+		            (int)InputHandler::get_mouse_position().y / TILE_SIZE);
+	}
+
 	// set the player's direction
 	Direction player_direction = InputHandler::vector_to_direction(input_direction);
 	if (player_direction != Direction::NONE) _player->set_direction(player_direction);
 
 	std::string animation_prefix =
-	    input_direction.magnitude() > 0.1f ? InputHandler::is_key_down(SDLK_LSHIFT) ? "run_" : "walk_" : "idle_";
+	    input_direction.magnitude() > 0.1f ? InputHandler::is_action_down(InputAction::RUN) ? "run_" : "walk_" : "idle_";
 
-	float speed = InputHandler::is_key_down(SDLK_LSHIFT) ? 250.f : 150.f;
+	float speed = InputHandler::is_action_down(InputAction::RUN) ? 250.f : 150.f;
 
 	if (_player->get_on_bike()) {
 		if (animation_prefix == "idle_")
@@ -323,23 +468,23 @@ void Application::handle_input() {
 	if (input_direction.magnitude() > 0.1f) {
 		_player->get_animation_controller().play(
 		    animation_prefix + StringUtils::to_lower(InputHandler::direction_to_string(player_direction)));
-		_player->move(input_direction.x * _delta_time * speed, input_direction.y * _delta_time * speed);
+		_player->slide(input_direction.x * _delta_time * speed, input_direction.y * _delta_time * speed, _map);
 	} else {
 		_player->get_animation_controller().play(
 		    animation_prefix + StringUtils::to_lower(InputHandler::direction_to_string(_player->get_direction())));
 	}
 }
 
-void Application::handle_key_down(SDL_Keycode key) {
-	if (key == SDLK_ESCAPE) {
+void Application::handle_key_down(const SDL_Keysym &key) {
+	if (key.sym == SDLK_ESCAPE) {
 		quit();
 	}
 
-	InputHandler::set_key_state(key, InputState::PRESSED);
+	InputHandler::set_key_state(key.scancode, InputState::PRESSED);
 }
 
-void Application::handle_key_up(SDL_Keycode key) {
-	InputHandler::set_key_state(key, InputState::RELEASED);
+void Application::handle_key_up(const SDL_Keysym &key) {
+	InputHandler::set_key_state(key.scancode, InputState::RELEASED);
 }
 
 void Application::handle_mouse_motion(int x, int y) {
@@ -365,11 +510,228 @@ void Application::update_delta_time() {
 }
 
 void Application::update() {
+	update_wanderers();
+
 	for (auto &sprite : _entities) {
 		sprite->update(_delta_time);
 	}
 
+	update_map_objects();
 	_player->update(_delta_time);
+
+	publish_stats();
+}
+
+void Application::update_map_objects() {
+	_object_query.clear();
+	_colliders.query(_player->get_hitbox(), _object_query);
+	for (Uint32 index : _object_query) {
+		SDL_Rect rect = ObjectBvh::get_bounds(_map.get_objects()[index]).to_rect();
+
+		// pushed out of an earlier one, the player may not touch this one anymore
+		if (_player->is_colliding(rect)) _player->handle_collision(rect, _map);
+	}
+
+	SDL_Rect hitbox = _player->get_hitbox();
+	_object_query.clear();
+	_enclosures.query(hitbox.x + hitbox.w * 0.5f, hitbox.y + hitbox.h * 0.5f, _object_query);
+	std::sort(_object_query.begin(), _object_query.end());
+
+	for (Uint32 index : _object_query) {
+		if (!std::binary_search(_enclosures_entered.begin(), _enclosures_entered.end(), index)) {
+			on_enclosure_changed(_map.get_objects()[index], true);
+		}
+	}
+	for (Uint32 index : _enclosures_entered) {
+		if (!std::binary_search(_object_query.begin(), _object_query.end(), index)) {
+			on_enclosure_changed(_map.get_objects()[index], false);
+		}
+	}
+	_enclosures_entered.swap(_object_query);
+}
+
+void Application::update_wanderers() {
+	_path_results.clear();
+	PathFinder::pump(PATH_BUDGET_MS, _path_results);
+
+	for (const PathResult &result : _path_results) {
+		auto it = _wander_tickets.find(result.ticket);
+		if (it == _wander_tickets.end()) continue; // its pokemon was despawned
+
+		Wanderer &wanderer = _wanderers[it->second];
+		_wander_tickets.erase(it);
+
+		wanderer.ticket   = 0;
+		wanderer.path     = result.path;
+		wanderer.waypoint = 1; // the first one is the tile the pokemon stands on
+		if (!result.found) wanderer.pause = 1.0f;
+	}
+
+	float delta_time = (float)_delta_time;
+	float step       = POKEMON_WALK_SPEED * delta_time;
+
+	const FlowField *field = nullptr;
+	if (_pokemons_follow) {
+		SDL_Rect  hitbox = _player->get_hitbox();
+		SDL_Point goal   = {std::clamp((hitbox.x + hitbox.w / 2) / TILE_SIZE, 0, _map.get_width() - 1),
+		                    std::clamp((hitbox.y + hitbox.h / 2) / TILE_SIZE, 0, _map.get_height() - 1)};
+		field            = &_flow_fields.get(_map, goal);
+	}
+
+	for (size_t i = 0; i < _wanderers.size(); ++i) {
+		Wanderer &wanderer = _wanderers[i];
+		_wander_velocities.set(i, Vector2f(0, 0));
+
+		// towards the center of the next tile of the field, nothing to do at the player or when cut off
+		if (field != nullptr) {
+			Vector2f  feet = _wander_feet.get(i);
+			SDL_Point next;
+			if (field->get_next((int)(feet.x / TILE_SIZE), (int)(feet.y / TILE_SIZE), next)) {
+				_wander_velocities.set(i, Vector2f((next.x + 0.5f) * TILE_SIZE, (next.y + 0.5f) * TILE_SIZE) - feet);
+			}
+			continue;
+		}
+
+		if (wanderer.path == nullptr || wanderer.waypoint >= wanderer.path->size()) {
+			wanderer.path.reset();
+			wanderer.pause -= delta_time;
+			if (wanderer.ticket == 0 && wanderer.pause <= 0) request_wander_path(i);
+			continue;
+		}
+
+		SDL_Point tile   = (*wanderer.path)[wanderer.waypoint];
+		Vector2f  target = Vector2f((tile.x + 0.5f) * TILE_SIZE, (tile.y + 0.5f) * TILE_SIZE);
+		Vector2f  offset = target - _wander_feet.get(i);
+
+		if (offset.magnitude() > step) {
+			_wander_velocities.set(i, offset);
+			continue;
+		}
+
+		// close enough to land on the waypoint this frame
+		_wander_feet.set(i, target);
+		if (++wanderer.waypoint == wanderer.path->size()) {
+			wanderer.pause = POKEMON_WANDER_PAUSE * (0.5f + (rand() % 100) / 100.0f);
+		}
+	}
+
+	batch_normalize(_wander_velocities);
+	batch_integrate(_wander_feet, _wander_velocities, step);
+
+	for (size_t i = 0; i < _wanderers.size(); ++i) {
+		Sprite  *pokemon = _pokemons[i].first;
+		Vector2f feet    = _wander_feet.get(i);
+		pokemon->set_position((int)(feet.x - pokemon->get_w() * 0.5f),
+		                      (int)(feet.y - pokemon->get_h() + TILE_SIZE * 0.5f));
+	}
+}
+
+void Application::request_wander_path(size_t index) {
+	Wanderer &wanderer = _wanderers[index];
+	Vector2f  feet     = _wander_feet.get(index);
+	SDL_Point start    = {std::clamp((int)(feet.x / TILE_SIZE), 0, _map.get_width() - 1),
+	                      std::clamp((int)(feet.y / TILE_SIZE), 0, _map.get_height() - 1)};
+
+	// goals on a lattice, so that pokemons walking between the same tiles share their paths through the cache
+	const int range = POKEMON_WANDER_RANGE / POKEMON_WANDER_STEP;
+	for (int attempt = 0; attempt < 8; ++attempt) {
+		SDL_Point goal = {(start.x / POKEMON_WANDER_STEP + rand() % (2 * range + 1) - range) * POKEMON_WANDER_STEP,
+		                  (start.y / POKEMON_WANDER_STEP + rand() % (2 * range + 1) - range) * POKEMON_WANDER_STEP};
+		if (goal.x < 0 || goal.y < 0 || goal.x >= _map.get_width() || goal.y >= _map.get_height()) continue;
+		if (_map.is_solid(goal.x, goal.y) || (goal.x == start.x && goal.y == start.y)) continue;
+
+		wanderer.ticket                  = PathFinder::request(start, goal);
+		_wander_tickets[wanderer.ticket] = index;
+		return;
+	}
+
+	// boxed in, try again later
+	wanderer.pause = POKEMON_WANDER_PAUSE;
+}
+
+void Application::toggle_wall(int x, int y) {
+	if (x < 0 || y < 0 || x >= _map.get_width() || y >= _map.get_height()) return;
+
+	bool solid = !_map.is_solid(x, y);
+	_map.set_solid(x, y, solid);
+	size_t changed = _flow_fields.update_tile(_map, x, y);
+	PathFinder::invalidate();
+
+	// the pokemons walking through the new wall look for another way from where they are
+	for (Wanderer &wanderer : _wanderers) {
+		if (!solid || wanderer.path == nullptr || wanderer.waypoint == 0) continue;
+		if (path_crosses(*wanderer.path, wanderer.waypoint - 1, {x, y})) wanderer.path.reset();
+	}
+
+	auto it = std::find_if(_walls.begin(), _walls.end(), [x, y](const SDL_Point &wall) {
+		return wall.x == x && wall.y == y;
+	});
+	if (it != _walls.end()) {
+		_walls.erase(it);
+	} else {
+		_walls.push_back({x, y});
+	}
+
+	printf("Tile %d,%d is now %s, %zu tiles of the flow fields changed\n", x, y, solid ? "solid" : "open", changed);
+}
+
+void Application::on_enclosure_changed(const MapObject &enclosure, bool entered) {
+	printf("%s %s\n", entered ? "Entered" : "Left", enclosure.name.c_str());
+}
+
+void Application::register_stats() {
+	_stats.delta_time         = Stats::add_gauge("frame.delta_time", 4);
+	_stats.fps                = Stats::add_gauge("frame.fps", 1);
+	_stats.entities           = Stats::add_counter("frame.entities");
+	_stats.textures_resident  = Stats::add_counter("textures.resident");
+	_stats.textures_mb        = Stats::add_gauge("textures.resident_mb", 1);
+	_stats.textures_budget_mb = Stats::add_gauge("textures.budget_mb", 1);
+	_stats.textures_hits      = Stats::add_counter("textures.hits");
+	_stats.textures_misses    = Stats::add_counter("textures.misses");
+	_stats.textures_evictions = Stats::add_counter("textures.evictions");
+	_stats.sheet_tiles        = Stats::add_counter("sheets.resident_tiles");
+	_stats.sheet_kb           = Stats::add_counter("sheets.resident_kb");
+	_stats.atlas_groups       = Stats::add_counter("atlas.groups");
+	_stats.atlas_pages        = Stats::add_counter("atlas.pages");
+	_stats.player_animation   = Stats::add_label("player.animation");
+	_stats.player_frame       = Stats::add_counter("player.frame");
+	_stats.player_timer       = Stats::add_gauge("player.timer");
+	_stats.player_enclosure   = Stats::add_label("player.enclosure");
+	_stats.path_requests      = Stats::add_counter("paths.requests");
+	_stats.path_cache_hits    = Stats::add_counter("paths.cache_hits");
+	_stats.path_searches      = Stats::add_counter("paths.searches");
+	_stats.path_queued        = Stats::add_counter("paths.queued");
+	_stats.flow_builds        = Stats::add_counter("flow.builds");
+}
+
+void Application::publish_stats() {
+	const TextureStats  &texture_stats = AssetManager::get_texture_stats();
+	AnimationController &animation     = _player->get_animation_controller();
+	const PathStats     &path_stats    = PathFinder::get_stats();
+
+	Stats::set_gauge(_stats.delta_time, _delta_time);
+	Stats::set_gauge(_stats.fps, _delta_time > 0 ? 1.0 / _delta_time : 0.0);
+	Stats::set_counter(_stats.entities, _entities.size());
+	Stats::set_counter(_stats.textures_resident, texture_stats.resident_count);
+	Stats::set_gauge(_stats.textures_mb, texture_stats.resident_bytes / (1024.0 * 1024.0));
+	Stats::set_gauge(_stats.textures_budget_mb, texture_stats.budget_bytes / (1024.0 * 1024.0));
+	Stats::set_counter(_stats.textures_hits, texture_stats.hits);
+	Stats::set_counter(_stats.textures_misses, texture_stats.misses);
+	Stats::set_counter(_stats.textures_evictions, texture_stats.evictions);
+	Stats::set_counter(_stats.sheet_tiles, SheetStreamer::get_resident_tiles());
+	Stats::set_counter(_stats.sheet_kb, SheetStreamer::get_resident_bytes() / 1024);
+	Stats::set_counter(_stats.atlas_groups, DynamicAtlas::get_group_count());
+	Stats::set_counter(_stats.atlas_pages, DynamicAtlas::get_page_count());
+	Stats::set_label(_stats.player_animation, animation.get_current_animation_name().c_str());
+	Stats::set_counter(_stats.player_frame, animation.get_current_frame_index());
+	Stats::set_gauge(_stats.player_timer, animation.get_timer());
+	Stats::set_label(_stats.player_enclosure,
+	                 _enclosures_entered.empty() ? "" : _map.get_objects()[_enclosures_entered.back()].name.c_str());
+	Stats::set_counter(_stats.path_requests, path_stats.requests);
+	Stats::set_counter(_stats.path_cache_hits, path_stats.cache_hits);
+	Stats::set_counter(_stats.path_searches, path_stats.searches);
+	Stats::set_counter(_stats.path_queued, path_stats.queued);
+	Stats::set_counter(_stats.flow_builds, _flow_fields.get_builds());
 }
 
 void Application::render() {
@@ -381,28 +743,23 @@ void Application::render() {
 	SDL_RenderClear(_renderer.get());
 
 	render_background();
+
+	// the tiles made solid at runtime are not in the background image
+	SDL_SetRenderDrawColor(_renderer.get(), 64, 64, 64, 255);
+	for (const SDL_Point &wall : _walls) {
+		if (!_map.is_solid(wall.x, wall.y)) continue;
+
+		SDL_Rect rect = {wall.x * TILE_SIZE, wall.y * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+		SDL_RenderFillRect(_renderer.get(), &rect);
+	}
+
 	_player->render(_renderer.get());
 
 	for (auto &sprite : _entities) {
 		sprite->render(_renderer.get());
 	}
 
-	// write the delta time to the screen
-	std::stringstream ss;
-	ss << "Delta Time: " << _delta_time << " FPS: " << 1.0f / _delta_time << std::endl
-	   << "Inputs: " << InputHandler::get() << std::endl
-	   << "Player Animation Controller: " << _player->get_animation_controller();
-
-	SDL_Color    color = {255, 255, 255, 255};
-	SDL_Surface *surface =
-	    TTF_RenderText_Blended_Wrapped(&AssetManager::get_font("../src/assets/fonts/Roboto/Roboto-Regular.ttf", 16),
-	                                   ss.str().c_str(),
-	                                   color,
-	                                   _window_width);
-	SDL_Texture *texture = SDL_CreateTextureFromSurface(_renderer.get(), surface);
-	SDL_Rect     rect    = {0, 0, surface->w, surface->h};
-	SDL_RenderCopy(_renderer.get(), texture, NULL, &rect);
-	SDL_FreeSurface(surface);
+	render_stats();
 
 	// render a red rectangle at the mouse position, 32x32 closest grid square
 	SDL_SetRenderDrawColor(_renderer.get(), 255, 0, 0, 128);
@@ -420,10 +777,11 @@ void Application::render() {
 	SDL_RenderFillRect(_renderer.get(), &rect3);
 
 	SDL_RenderPresent(_renderer.get());
+	InputQueue::present();
 }
 
 void Application::render_background() {
-	SDL_RenderCopy(_renderer.get(), &AssetManager::get_texture("../src/assets/tiled/zoo_1.png"), NULL, NULL);
+	SDL_RenderCopy(_renderer.get(), AssetManager::get_texture(_background_texture), NULL, NULL);
 
 	// draw a grid accross the whole screen
 	SDL_SetRenderDrawColor(_renderer.get(), 255, 255, 255, 255);
@@ -436,12 +794,38 @@ void Application::render_background() {
 	}
 }
 
+void Application::render_stats() {
+	// stats are only formatted here, the subsystems wrote their values during the frame
+	const char *stats = Stats::to_text();
+
+	if (_overlay_texture == nullptr || _overlay_text != stats) {
+		TTF_Font *font = AssetManager::get_font(_overlay_font);
+		if (font == nullptr) return;
+
+		if (_overlay_texture != nullptr) SDL_DestroyTexture(_overlay_texture);
+		_overlay_texture = nullptr;
+		_overlay_text    = stats;
+
+		SDL_Color    color   = {255, 255, 255, 255};
+		SDL_Surface *surface = TTF_RenderText_Blended_Wrapped(font, stats, color, _window_width);
+		if (surface == nullptr) return;
+
+		_overlay_texture = SDL_CreateTextureFromSurface(_renderer.get(), surface);
+		_overlay_rect    = {0, 0, surface->w, surface->h};
+		SDL_FreeSurface(surface);
+	}
+
+	if (_overlay_texture != nullptr) SDL_RenderCopy(_renderer.get(), _overlay_texture, NULL, &_overlay_rect);
+}
+
 void Application::render_text(const char *text, int x, int y, int size) {}
 
 void Application::quit() {
 	std::shared_ptr<Application> app = instance();
 	app->_running                    = false;
 
+	printf("Stats: %s\n", Stats::to_json());
+
 #ifdef __EMSCRIPTEN__
 	emscripten_cancel_main_loop();
 #endif
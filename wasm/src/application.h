@@ -1,6 +1,13 @@
 #pragma once
 
+#include "batch_math.h"
 #include "character.h"
+#include "dynamic_atlas.h"
+#include "input_queue.h"
+#include "object_bvh.h"
+#include "path_finder.h"
+#include "stats.h"
+#include "sprite_atlas.h"
 
 #ifdef __EMSCRIPTEN__
 #	include <emscripten.h>
@@ -37,6 +44,19 @@ class Application {
 
 	static void add_entity(const Sprite &sprite);
 
+	/**
+	 * Spawns a pokemon from the 4th gen spritesheet, its species is packed in
+	 * the dynamic atlas the first time it shows up. A shiny uses the "shiny"
+	 * palette of the sheet.
+	 */
+	void spawn_pokemon(int start_x, int x, int y, bool shiny = false);
+
+	/**
+	 * Removes the last spawned pokemon, its species leaves the atlas and the
+	 * streamed sheet once no other pokemon of it is left
+	 */
+	void despawn_pokemon();
+
   private:
 	/**
 	 *  Singleton Instance
@@ -65,9 +85,10 @@ class Application {
 	 */
 	void on_loop_start();
 	void handle_events();
+	void process_input_events();
 	void handle_input();
-	void handle_key_down(SDL_Keycode key);
-	void handle_key_up(SDL_Keycode key);
+	void handle_key_down(const SDL_Keysym &key);
+	void handle_key_up(const SDL_Keysym &key);
 	void handle_mouse_motion(int x, int y);
 	void handle_mouse_button_down(Uint8 button, int x, int y);
 	void handle_mouse_button_up(Uint8 button, int x, int y);
@@ -79,11 +100,39 @@ class Application {
 	void update_delta_time();
 	void update();
 
+	/**
+	 * Pushes the player out of the map's colliders, then raises the enter and
+	 * exit events of the enclosures its feet moved in or out of
+	 */
+	void update_map_objects();
+	void on_enclosure_changed(const MapObject &enclosure, bool entered);
+
+	/**
+	 * Walks the pokemons along their paths, and asks for a new path to the
+	 * ones that finished theirs and waited long enough
+	 */
+	void update_wanderers();
+	void request_wander_path(size_t index);
+
+	/**
+	 * Makes the tile solid or open again, the paths and the flow fields
+	 * follow the change
+	 */
+	void toggle_wall(int x, int y);
+
+	/**
+	 * Registers the stats of the subsystems without their own once, then
+	 * writes them every frame
+	 */
+	void register_stats();
+	void publish_stats();
+
 	/**
 	 * Methods for rendering the game state
 	 */
 	void render();
 	void render_background();
+	void render_stats();
 	void render_text(const char *text, int x, int y, int size);
 
 	/**
@@ -122,4 +171,84 @@ class Application {
 	Uint64                               LAST             = 0;
 	std::vector<std::unique_ptr<Sprite>> _entities;
 	std::unique_ptr<Character>           _player = nullptr;
+
+	/**
+	 * Spawned pokemons with their atlas group, in spawn order
+	 */
+	std::vector<std::pair<Sprite *, std::string>> _pokemons;
+
+	/**
+	 * Walk of the spawned pokemons, in the order of _pokemons. Their feet and
+	 * velocities are in batches, moved together by the batch_math kernels.
+	 */
+	struct Wanderer {
+		SharedPath path;
+		size_t     waypoint = 0;
+		PathTicket ticket   = 0; // path being searched, 0 for none
+		float      pause    = 0; // seconds before the next walk
+	};
+	std::vector<Wanderer>                  _wanderers;
+	Vector2Batch                           _wander_feet;
+	Vector2Batch                           _wander_velocities;
+	std::unordered_map<PathTicket, size_t> _wander_tickets;
+	std::vector<PathResult>                _path_results;
+
+	/**
+	 * The pokemons follow the player through a flow field towards its tile
+	 * instead of wandering, a field shared by all of them
+	 */
+	bool                   _pokemons_follow = false;
+	FlowFieldCache         _flow_fields;
+	std::vector<SDL_Point> _walls; // tiles toggled by toggle_wall()
+
+	/**
+	 * Assets resolved once in load_assets()
+	 */
+	TextureHandle _background_texture;
+	TextureHandle _player_texture;
+	FontHandle    _overlay_font;
+	TileMap       _map;
+
+	/**
+	 * Stats overlay, rendered again only when its text changes
+	 */
+	std::string  _overlay_text;
+	SDL_Texture *_overlay_texture = nullptr;
+	SDL_Rect     _overlay_rect    = {0, 0, 0, 0};
+
+	/**
+	 * Objects of the map, indexed once it is loaded
+	 */
+	ObjectBvh           _colliders;
+	ObjectBvh           _enclosures;
+	std::vector<Uint32> _enclosures_entered; // sorted
+	std::vector<Uint32> _object_query;
+
+	/**
+	 * Ids of the stats written by publish_stats()
+	 */
+	struct {
+		StatId delta_time;
+		StatId fps;
+		StatId entities;
+		StatId textures_resident;
+		StatId textures_mb;
+		StatId textures_budget_mb;
+		StatId textures_hits;
+		StatId textures_misses;
+		StatId textures_evictions;
+		StatId sheet_tiles;
+		StatId sheet_kb;
+		StatId atlas_groups;
+		StatId atlas_pages;
+		StatId player_animation;
+		StatId player_frame;
+		StatId player_timer;
+		StatId player_enclosure;
+		StatId path_requests;
+		StatId path_cache_hits;
+		StatId path_searches;
+		StatId path_queued;
+		StatId flow_builds;
+	} _stats;
 };
@@ -0,0 +1,162 @@
+#include "asset_archive.h"
+
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetArchive::AssetArchive() {}
+
+AssetArchive::~AssetArchive() {
+	close();
+}
+
+bool AssetArchive::open(const std::string &archive_path) {
+	auto &archive = get();
+	close();
+
+	const Uint8 *data = nullptr;
+	size_t       size = 0;
+
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+	int file = ::open(archive_path.c_str(), O_RDONLY);
+	if (file < 0) {
+		printf("AssetArchive::open() - Failed to open %s\n", archive_path.c_str());
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size <= 0) {
+		::close(file);
+		printf("AssetArchive::open() - Failed to stat %s\n", archive_path.c_str());
+		return false;
+	}
+
+	size          = (size_t)info.st_size;
+	void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (mapping == MAP_FAILED) {
+		printf("AssetArchive::open() - Failed to map %s\n", archive_path.c_str());
+		return false;
+	}
+
+	data            = (const Uint8 *)mapping;
+	archive._mapped = true;
+#else
+	// the preloaded file lives in the JS heap, outside of the wasm memory the
+	// index points into: it is read once into the buffer, then removed on wasm
+	std::ifstream file(archive_path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		printf("AssetArchive::open() - Failed to open %s\n", archive_path.c_str());
+		return false;
+	}
+
+	size = (size_t)file.tellg();
+	archive._buffer.resize(size);
+	file.seekg(0);
+	if (!file.read((char *)archive._buffer.data(), size)) {
+		archive._buffer.clear();
+		printf("AssetArchive::open() - Failed to read %s\n", archive_path.c_str());
+		return false;
+	}
+	file.close();
+
+#ifdef __EMSCRIPTEN__
+	// the preloaded package is only freed once no file refers to it
+	if (std::remove(archive_path.c_str()) != 0) {
+		printf("AssetArchive::open() - Failed to release the preloaded %s\n", archive_path.c_str());
+	}
+#endif
+
+	data = archive._buffer.data();
+#endif
+
+	archive._data = data;
+	archive._size = size;
+
+	const ArchiveHeader *header = (const ArchiveHeader *)data;
+	if (size < sizeof(ArchiveHeader) || header->magic != ARCHIVE_MAGIC || header->version != ARCHIVE_VERSION ||
+	    size < sizeof(ArchiveHeader) + (size_t)header->entry_count * sizeof(ArchiveEntry)) {
+		printf("AssetArchive::open() - %s is not a valid archive\n", archive_path.c_str());
+		close();
+		return false;
+	}
+
+	archive._entries     = (const ArchiveEntry *)(data + sizeof(ArchiveHeader));
+	archive._entry_count = header->entry_count;
+
+	for (size_t i = 0; i < archive._entry_count; ++i) {
+		const ArchiveEntry &entry = archive._entries[i];
+		if (entry.offset > size || entry.size > size - entry.offset || entry.path_offset > size ||
+		    entry.path_size > size - entry.path_offset) {
+			printf("AssetArchive::open() - %s is truncated\n", archive_path.c_str());
+			close();
+			return false;
+		}
+	}
+
+	printf("AssetArchive::open() - %zu assets, %zu bytes\n", archive._entry_count, size);
+	return true;
+}
+
+void AssetArchive::close() {
+	auto &archive = get();
+
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+	if (archive._mapped) munmap((void *)archive._data, archive._size);
+#endif
+
+	archive._buffer.clear();
+	archive._buffer.shrink_to_fit();
+	archive._mapped      = false;
+	archive._data        = nullptr;
+	archive._size        = 0;
+	archive._entries     = nullptr;
+	archive._entry_count = 0;
+}
+
+const ArchiveEntry *AssetArchive::find_entry(const std::string &path) const {
+	if (_entries == nullptr) return nullptr;
+
+	// the archive stores paths relative to the assets directory
+	static const std::string root = ASSET_ROOT;
+	size_t                   skip = path.compare(0, root.size(), root) == 0 ? root.size() : 0;
+	const char              *key  = path.data() + skip;
+	size_t                   size = path.size() - skip;
+	Uint64                   hash = archive_hash(key, size);
+
+	auto                less = [](const ArchiveEntry &entry, Uint64 value) { return entry.path_hash < value; };
+	const ArchiveEntry *end  = _entries + _entry_count;
+	const ArchiveEntry *it   = std::lower_bound(_entries, end, hash, less);
+
+	if (it == end || it->path_hash != hash) return nullptr;
+
+	// another path with the same hash is not in the archive
+	if (it->path_size != size || memcmp(_data + it->path_offset, key, size) != 0) return nullptr;
+	return it;
+}
+
+bool AssetArchive::find(const std::string &path, const void *&data, size_t &size) {
+	auto               &archive = get();
+	const ArchiveEntry *entry   = archive.find_entry(path);
+	if (entry == nullptr) return false;
+
+	data = archive._data + entry->offset;
+	size = (size_t)entry->size;
+	return true;
+}
+
+Uint64 AssetArchive::get_content_hash(const std::string &path) {
+	const ArchiveEntry *entry = get().find_entry(path);
+	return entry != nullptr ? entry->content_hash : 0;
+}
+
+SDL_RWops *AssetArchive::open_rw(const std::string &path) {
+	const void *data;
+	size_t      size;
+	if (find(path, data, size)) return SDL_RWFromConstMem(data, (int)size);
+
+	return SDL_RWFromFile(path.c_str(), "rb");
+}
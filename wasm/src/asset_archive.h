@@ -0,0 +1,67 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#pragma once
+
+#include "asset_archive_format.h"
+#include "includes.h"
+
+/**
+ * Read-only view over the packed assets (see tools/asset_packer.cpp).
+ *
+ * The archive is memory mapped on desktop and read into a single buffer on
+ * wasm, assets are then handed to SDL_image and SDL_ttf straight from that
+ * memory. Paths that are not in the archive, or every path when no archive
+ * is open, fall back to the loose files so the game still runs from a
+ * source checkout.
+ */
+class AssetArchive {
+  public:
+	AssetArchive();
+	~AssetArchive();
+
+	AssetArchive(const AssetArchive &)            = delete;
+	AssetArchive &operator=(const AssetArchive &) = delete;
+
+	static AssetArchive &get() {
+		static AssetArchive instance;
+		return instance;
+	}
+
+	static bool open(const std::string &archive_path);
+	static void close();
+	static bool is_open() { return get()._data != nullptr; }
+
+	/**
+	 * Finds an asset in the archive, the memory stays valid until close()
+	 * @param path The asset path, with or without the ASSET_ROOT prefix
+	 */
+	static bool find(const std::string &path, const void *&data, size_t &size);
+
+	/**
+	 * @return the content hash stored by the packer, 0 if the asset is not in the archive
+	 */
+	static Uint64 get_content_hash(const std::string &path);
+
+	/**
+	 * Opens the asset for SDL, from the archive memory if it is packed,
+	 * from the file system otherwise. Safe to call from any thread.
+	 */
+	static SDL_RWops *open_rw(const std::string &path);
+
+	static size_t get_entry_count() { return get()._entry_count; }
+
+  private:
+	const ArchiveEntry *find_entry(const std::string &path) const;
+
+	const Uint8        *_data        = nullptr;
+	size_t              _size        = 0;
+	const ArchiveEntry *_entries     = nullptr;
+	size_t              _entry_count = 0;
+
+	// wasm keeps the archive in memory, desktop maps it
+	std::vector<Uint8> _buffer;
+	bool               _mapped = false;
+};
+
+#endif
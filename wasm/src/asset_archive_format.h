@@ -0,0 +1,53 @@
+#ifndef ASSET_ARCHIVE_FORMAT_H
+#define ASSET_ARCHIVE_FORMAT_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * On-disk layout of the asset archive, shared by the game and the packer.
+ *
+ *   ArchiveHeader
+ *   ArchiveEntry[entry_count]   sorted by path_hash
+ *   paths                       of the entries, not terminated
+ *   blobs                       each one aligned to ARCHIVE_ALIGNMENT
+ *
+ * Paths are relative to the assets directory ("images/lyra.png"), all
+ * integers are little endian.
+ */
+
+#define ARCHIVE_MAGIC     0x52415A50 // "PZAR"
+#define ARCHIVE_VERSION   2
+#define ARCHIVE_ALIGNMENT 16
+
+struct ArchiveHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entry_count;
+	uint32_t reserved;
+};
+
+struct ArchiveEntry {
+	uint64_t path_hash;
+	uint64_t content_hash;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t path_offset; // from the start of the archive, a found hash is checked against the path
+	uint32_t path_size;
+};
+
+/**
+ * 64 bit FNV-1a, used for both the paths and the contents
+ */
+inline uint64_t archive_hash(const void *data, size_t size, uint64_t hash = 0xCBF29CE484222325ULL) {
+	const unsigned char *bytes = (const unsigned char *)data;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef ASSET_HANDLE_H
+#define ASSET_HANDLE_H
+
+#pragma once
+
+#include "includes.h"
+
+/**
+ * Typed index into one of the AssetManager arrays.
+ * The generation is bumped every time a slot is reused, so a handle kept
+ * after its asset was unloaded resolves to nothing instead of another asset.
+ */
+template<typename Tag>
+struct AssetHandle {
+	static constexpr Uint32 INVALID_INDEX = 0xFFFFFFFF;
+
+	Uint32 index      = INVALID_INDEX;
+	Uint32 generation = 0;
+
+	bool is_valid() const { return index != INVALID_INDEX; }
+
+	bool operator==(const AssetHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const AssetHandle& other) const { return !(*this == other); }
+};
+
+struct TextureTag {};
+struct FontTag {};
+
+typedef AssetHandle<TextureTag> TextureHandle;
+typedef AssetHandle<FontTag>    FontHandle;
+
+#endif
@@ -1,53 +1,757 @@
 #include "asset_manager.h"
 
 #include "application.h"
+#include "cooked_map_format.h"
+#include "lz4_block.h"
+#include "thread_pool.h"
 
 #include <stdexcept>
 
-AssetManager::AssetManager() {}
+AssetManager::AssetManager() {
+	_stats.budget_bytes = TEXTURE_BUDGET_BYTES;
+}
 
 AssetManager::~AssetManager() {}
 
-SDL_Texture &AssetManager::get_texture(const std::string &path) {
-	load_texture(path);
-	return *(AssetManager::get())._textureMap[path];
+TextureHandle AssetManager::find_texture(const std::string &path) {
+	auto &manager = AssetManager::get();
+
+	auto it = manager._texture_lookup.find(path);
+	if (it == manager._texture_lookup.end()) return TextureHandle();
+
+	return {it->second, manager._textures[it->second].generation};
+}
+
+Uint32 AssetManager::add_slot(const std::string &path) {
+	auto &manager = AssetManager::get();
+
+	// reuse an unloaded slot, its generation was bumped on unload
+	Uint32 index;
+	if (!manager._free_textures.empty()) {
+		index = manager._free_textures.back();
+		manager._free_textures.pop_back();
+	} else {
+		index = (Uint32)manager._textures.size();
+		manager._textures.push_back(TextureSlot());
+	}
+
+	manager._textures[index].path = path;
+	manager._texture_lookup[path] = index;
+
+	return index;
+}
+
+bool AssetManager::load_slot(Uint32 index) {
+	const std::string path = AssetManager::get()._textures[index].path;
+
+	bool         premultiplied = false;
+	SDL_Surface *surface       = load_surface(path, get_texture_format(), &premultiplied);
+	if (surface == nullptr) {
+		throw std::runtime_error("Failed to load image: " + path);
+	}
+
+	SDL_Texture *texture = SDL_CreateTextureFromSurface(Application::get_renderer(), surface);
+	if (texture == nullptr) {
+		throw std::runtime_error("Failed to create texture from surface: " + path);
+	}
+	set_blend_mode(texture, premultiplied);
+
+	size_t bytes = (size_t)surface->w * surface->h * 4;
+	SDL_FreeSurface(surface);
+
+	AssetManager::get()._textures[index].ready = true;
+	set_resident(index, texture, bytes);
+
+	return true;
+}
+
+bool AssetManager::start_async_load(Uint32 index) {
+	auto       &manager = AssetManager::get();
+	std::string path    = manager._textures[index].path;
+
+	// size unknown before decoding, it has to be loaded synchronously
+	int  width = 0, height = 0;
+	bool premultiplied = false;
+	if (!read_image_info(path, width, height, premultiplied)) return false;
+
+	// the placeholder is the final texture, it only becomes visible once uploaded
+	Uint32       format = get_texture_format();
+	SDL_Texture *texture =
+	    SDL_CreateTexture(Application::get_renderer(), format, SDL_TEXTUREACCESS_STATIC, width, height);
+	if (texture == nullptr) {
+		throw std::runtime_error("Failed to create texture: " + path);
+	}
+	set_blend_mode(texture, premultiplied);
+
+	// premultiplied colors are added whatever the alpha, hide them too
+	SDL_SetTextureAlphaMod(texture, 0);
+	SDL_SetTextureColorMod(texture, 0, 0, 0);
+
+	auto request   = std::make_unique<PendingTexture>();
+	request->index = index;
+	request->path  = path;
+
+	PendingTexture *raw              = request.get();
+	manager._textures[index].ready   = false;
+	manager._textures[index].pending = raw;
+	manager._pending.push_back(std::move(request));
+
+	set_resident(index, texture, (size_t)width * height * 4);
+
+	ThreadPool::get().submit([raw, path, format]() {
+		DecodedTexture decoded = {raw, load_surface(path, format)};
+		while (!AssetManager::get()._decoded.try_push(decoded)) {
+			std::this_thread::yield();
+		}
+	});
+
+	return true;
+}
+
+TextureHandle AssetManager::load_texture(const std::string &path) {
+	auto &manager = AssetManager::get();
+
+	TextureHandle handle = find_texture(path);
+	if (!handle.is_valid()) {
+		Uint32 index = add_slot(path);
+		load_slot(index);
+		return {index, manager._textures[index].generation};
+	}
+
+	// already requested asynchronously, finish it now, still in the same frame for the LRU clock
+	while (manager._textures[handle.index].pending != nullptr) {
+		upload_decoded(INFINITY);
+		std::this_thread::yield();
+	}
+
+	if (manager._textures[handle.index].texture == nullptr) {
+		manager._stats.misses++;
+		load_slot(handle.index);
+	}
+
+	return handle;
+}
+
+TextureHandle AssetManager::load_texture_async(const std::string &path) {
+	auto &manager = AssetManager::get();
+
+	TextureHandle handle = find_texture(path);
+	if (handle.is_valid()) {
+		if (manager._textures[handle.index].texture == nullptr) reload_texture(handle.index);
+		return handle;
+	}
+
+	Uint32 index = add_slot(path);
+	if (!start_async_load(index)) load_slot(index);
+
+	return {index, manager._textures[index].generation};
+}
+
+SDL_Texture *AssetManager::reload_texture(Uint32 index) {
+	auto &manager = AssetManager::get();
+	manager._stats.misses++;
+
+	if (!start_async_load(index)) load_slot(index);
+
+	return manager._textures[index].texture;
+}
+
+bool AssetManager::is_texture_ready(TextureHandle handle) {
+	const auto &textures = AssetManager::get()._textures;
+	if (handle.index >= textures.size() || textures[handle.index].generation != handle.generation) return false;
+	return textures[handle.index].texture != nullptr && textures[handle.index].ready;
+}
+
+void AssetManager::unload_texture(TextureHandle handle) {
+	auto &manager = AssetManager::get();
+	if (handle.index >= manager._textures.size()) return;
+
+	TextureSlot &slot = manager._textures[handle.index];
+	if (slot.generation != handle.generation) return;
+
+	// the decoding thread still owns the request, its result is dropped
+	if (slot.pending != nullptr) slot.pending->cancelled = true;
+
+	if (slot.texture != nullptr) {
+		SDL_DestroyTexture(slot.texture);
+		manager._stats.resident_bytes -= slot.bytes;
+		manager._stats.resident_count--;
+	}
+
+	manager._texture_lookup.erase(slot.path);
+
+	Uint32 generation = slot.generation + 1;
+	slot              = TextureSlot();
+	slot.generation   = generation;
+	manager._free_textures.push_back(handle.index);
+}
+
+void AssetManager::pin_texture(TextureHandle handle, bool pinned) {
+	auto &manager = AssetManager::get();
+	if (handle.index >= manager._textures.size()) return;
+	if (manager._textures[handle.index].generation != handle.generation) return;
+
+	manager._textures[handle.index].pinned = pinned;
+}
+
+void AssetManager::set_texture_budget(size_t bytes) {
+	AssetManager::get()._stats.budget_bytes = bytes;
+	enforce_budget();
+}
+
+void AssetManager::set_resident(Uint32 index, SDL_Texture *texture, size_t bytes) {
+	auto        &manager = AssetManager::get();
+	TextureSlot &slot    = manager._textures[index];
+
+	slot.texture   = texture;
+	slot.bytes     = bytes;
+	slot.last_used = manager._frame;
+
+	manager._stats.resident_bytes += bytes;
+	manager._stats.resident_count++;
+
+	enforce_budget();
 }
 
-bool AssetManager::load_texture(const std::string &path) {
-	auto &textureMap = AssetManager::get()._textureMap;
-	if (textureMap.find(path) == textureMap.end()) {
-		SDL_Surface *surface = IMG_Load(path.c_str());
-		if (surface == nullptr) {
-			throw std::runtime_error("Failed to load image: " + path);
+void AssetManager::evict(Uint32 index) {
+	auto        &manager = AssetManager::get();
+	TextureSlot &slot    = manager._textures[index];
+
+	SDL_DestroyTexture(slot.texture);
+	slot.texture = nullptr;
+	slot.ready   = false;
+
+	manager._stats.resident_bytes -= slot.bytes;
+	manager._stats.resident_count--;
+	manager._stats.evictions++;
+}
+
+void AssetManager::enforce_budget() {
+	auto &manager = AssetManager::get();
+
+	while (manager._stats.resident_bytes > manager._stats.budget_bytes) {
+		// textures used this frame, pinned or still loading are never evicted
+		Uint32 oldest = TextureHandle::INVALID_INDEX;
+		for (Uint32 i = 0; i < manager._textures.size(); ++i) {
+			const TextureSlot &slot = manager._textures[i];
+			if (slot.texture == nullptr || slot.pinned || slot.pending != nullptr) continue;
+			if (slot.last_used >= manager._frame) continue;
+
+			if (oldest == TextureHandle::INVALID_INDEX || slot.last_used < manager._textures[oldest].last_used) {
+				oldest = i;
+			}
 		}
 
-		SDL_Texture *texture = SDL_CreateTextureFromSurface(Application::get_renderer(), surface);
-		if (texture == nullptr) {
-			throw std::runtime_error("Failed to create texture from surface: " + path);
+		if (oldest == TextureHandle::INVALID_INDEX) return;
+
+		evict(oldest);
+	}
+}
+
+void AssetManager::finish_pending(PendingTexture *pending) {
+	auto &manager = AssetManager::get();
+
+	if (!pending->cancelled) manager._textures[pending->index].pending = nullptr;
+
+	auto it = std::find_if(manager._pending.begin(),
+	                       manager._pending.end(),
+	                       [pending](const std::unique_ptr<PendingTexture> &item) { return item.get() == pending; });
+	if (it != manager._pending.end()) manager._pending.erase(it);
+}
+
+void AssetManager::pump_uploads(double budget_ms) {
+	AssetManager::get()._frame++;
+	upload_decoded(budget_ms);
+}
+
+void AssetManager::upload_decoded(double budget_ms) {
+	auto        &manager   = AssetManager::get();
+	const Uint64 start     = SDL_GetPerformanceCounter();
+	const double frequency = (double)SDL_GetPerformanceFrequency();
+	auto         elapsed   = [&]() { return (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency; };
+
+	// no decoding thread, decode one image per call on the main thread
+	if (!ThreadPool::get().has_workers()) ThreadPool::get().run_pending();
+
+	DecodedTexture decoded;
+	while (manager._decoded.try_pop(decoded)) {
+		PendingTexture *pending = decoded.pending;
+
+		if (decoded.surface == nullptr || pending->cancelled) {
+			if (decoded.surface == nullptr) {
+				printf("AssetManager::pump_uploads() - Failed to load image: %s\n", pending->path.c_str());
+			}
+			SDL_FreeSurface(decoded.surface);
+			finish_pending(pending);
+			continue;
 		}
 
-		textureMap[path] = texture;
+		pending->surface = decoded.surface;
+		manager._uploads.push_back(pending);
+	}
+
+	// upload a few rows at a time so a large sheet is spread over several frames
+	while (!manager._uploads.empty() && elapsed() < budget_ms) {
+		PendingTexture *pending = manager._uploads.front();
+		SDL_Surface    *surface = pending->surface;
+
+		if (pending->cancelled) {
+			SDL_FreeSurface(surface);
+			manager._uploads.pop_front();
+			finish_pending(pending);
+			continue;
+		}
+
+		TextureSlot &slot = manager._textures[pending->index];
+
+		int      rows = std::min(ASSET_UPLOAD_ROWS, surface->h - pending->next_row);
+		SDL_Rect rect = {0, pending->next_row, surface->w, rows};
+		SDL_UpdateTexture(
+		    slot.texture, &rect, (const Uint8 *)surface->pixels + pending->next_row * surface->pitch, surface->pitch);
+		pending->next_row += rows;
+
+		if (pending->next_row < surface->h) continue;
+
 		SDL_FreeSurface(surface);
+		SDL_SetTextureAlphaMod(slot.texture, 255);
+		SDL_SetTextureColorMod(slot.texture, 255, 255, 255);
+		slot.ready = true;
+
+		manager._uploads.pop_front();
+		finish_pending(pending);
 	}
 
-	return true;
+	// textures that finished loading may have pushed the cache over budget
+	enforce_budget();
 }
 
-TTF_Font &AssetManager::get_font(const std::string &path, int size) {
-	load_font(path, size);
-	return *(AssetManager::get())._fontMap[path];
+SDL_Surface *AssetManager::load_surface(const std::string &path, Uint32 format, bool *premultiplied) {
+	std::string file, variant;
+	split_variant(path, file, variant);
+
+	const CookedTextureHeader *cooked = find_cooked_texture(file);
+	if (cooked != nullptr) {
+		SDL_Surface *surface = load_cooked_surface(cooked, variant);
+		if (surface != nullptr) {
+			if (premultiplied != nullptr) *premultiplied = (cooked->flags & COOKED_PREMULTIPLIED) != 0;
+			if (surface->format->format == format) return surface;
+
+			SDL_Surface *converted = convert_image_format(surface, format);
+			SDL_FreeSurface(surface);
+			return converted;
+		}
+
+		printf("AssetManager::load_surface() - Corrupted cooked texture: %s\n", path.c_str());
+	}
+
+	ImageOptions options = get_image_options(file);
+	if (premultiplied != nullptr) *premultiplied = options.premultiply;
+
+	SDL_Surface *surface = process_image(IMG_Load_RW(AssetArchive::open_rw(file), 1), options, format);
+	if (surface == nullptr || variant.empty()) return surface;
+
+	// not cooked, the variant is applied to the texels instead of a palette
+	std::vector<ColorSwap> swaps;
+	if (!load_color_swaps(file, variant, swaps)) {
+		printf("AssetManager::load_surface() - Unknown variant: %s\n", path.c_str());
+		return surface;
+	}
+	if (format == SDL_PIXELFORMAT_BGRA32) {
+		for (ColorSwap &swap : swaps) {
+			swap.from = ((swap.from & 0xFF) << 16) | (swap.from & 0xFF00) | ((swap.from >> 16) & 0xFF);
+			swap.to   = ((swap.to & 0xFF) << 16) | (swap.to & 0xFF00) | ((swap.to >> 16) & 0xFF);
+		}
+	}
+	for (int y = 0; y < surface->h; ++y) {
+		apply_color_swaps((Uint8 *)surface->pixels + y * surface->pitch, surface->w, swaps);
+	}
+
+	return surface;
+}
+
+void AssetManager::split_variant(const std::string &path, std::string &file, std::string &variant) {
+	size_t separator = path.find('#');
+	file             = path.substr(0, separator);
+	variant          = separator == std::string::npos ? "" : path.substr(separator + 1);
+}
+
+bool AssetManager::load_color_swaps(const std::string &file,
+                                    const std::string &variant,
+                                    std::vector<ColorSwap> &swaps) {
+	SDL_RWops *rw = AssetArchive::open_rw(get_palette_path(file, variant));
+	if (rw == nullptr) return false;
+
+	std::string text((size_t)std::max<Sint64>(SDL_RWsize(rw), 0), '\0');
+	size_t      read = SDL_RWread(rw, &text[0], 1, text.size());
+	SDL_RWclose(rw);
+	text.resize(read);
+
+	return parse_color_swaps(text, swaps);
+}
+
+const CookedTextureHeader *AssetManager::find_cooked_texture(const std::string &path) {
+	const void *data;
+	size_t      size;
+	if (!AssetArchive::find(path + COOKED_TEXTURE_EXTENSION, data, size)) return nullptr;
+
+	const CookedTextureHeader *header = (const CookedTextureHeader *)data;
+	if (size < sizeof(CookedTextureHeader) || header->magic != COOKED_TEXTURE_MAGIC ||
+	    header->version != COOKED_TEXTURE_VERSION || header->data_size > size - sizeof(CookedTextureHeader))
+		return nullptr;
+
+	if (header->width == 0 || header->height == 0) return nullptr;
+
+	bool indexed = (header->flags & COOKED_INDEXED) != 0;
+	if (indexed != (header->palette_count > 0) || header->data_size < header->palette_count * sizeof(CookedPalette))
+		return nullptr;
+
+	if (header->flags & COOKED_TILED) {
+		size_t table_size = (size_t)get_cooked_columns(header) * get_cooked_rows(header) * sizeof(CookedTile);
+		if (header->tile_size == 0 || get_cooked_payload_size(header) < table_size) return nullptr;
+	} else if (header->pitch < header->width * (indexed ? 1 : 4)) {
+		return nullptr;
+	}
+
+	if (is_cooked_stale(path, header)) return nullptr;
+
+	return header;
+}
+
+SDL_Surface *AssetManager::load_cooked_tile(const CookedTextureHeader *header, Uint32 column, Uint32 row) {
+	Uint32 columns = get_cooked_columns(header);
+	if (column >= columns || row >= get_cooked_rows(header)) return nullptr;
+
+	// the blobs follow the tile table, offsets are relative to its end
+	const CookedTile *tiles      = (const CookedTile *)get_cooked_payload(header);
+	size_t            table_size = (size_t)columns * get_cooked_rows(header) * sizeof(CookedTile);
+	size_t            blobs_size = get_cooked_payload_size(header) - table_size;
+	const CookedTile &tile       = tiles[row * columns + column];
+	if (tile.offset > blobs_size || tile.size > blobs_size - tile.offset) return nullptr;
+
+	int width  = (int)std::min(header->tile_size, header->width - column * header->tile_size);
+	int height = (int)std::min(header->tile_size, header->height - row * header->tile_size);
+
+	const CookedPalette *palette = find_cooked_palette(header, "");
+	const Uint8         *data    = get_cooked_payload(header) + table_size + tile.offset;
+	int                  pitch   = palette != nullptr ? (width + 3) & ~3 : width * 4;
+	return decode_cooked(data, tile.size, tile.compression, width, height, pitch, header->format, palette);
 }
 
-bool AssetManager::load_font(const std::string &path, int size) {
-	auto &fontMap = AssetManager::get()._fontMap;
-	if (fontMap.find(path) == fontMap.end()) {
-		TTF_Font *font = TTF_OpenFont(path.c_str(), size);
-		if (font == nullptr) {
-			throw std::runtime_error("Failed to load font: " + path);
+const CookedPalette *AssetManager::find_cooked_palette(const CookedTextureHeader *header, const std::string &variant) {
+	const CookedPalette *palettes = (const CookedPalette *)(header + 1);
+	for (Uint32 i = 0; i < header->palette_count; ++i) {
+		if (strncmp(palettes[i].name, variant.c_str(), sizeof(palettes[i].name)) == 0) return &palettes[i];
+	}
+	return nullptr;
+}
+
+SDL_Surface *AssetManager::load_cooked_surface(const CookedTextureHeader *header, const std::string &variant) {
+	const CookedPalette *palette = nullptr;
+	if (header->flags & COOKED_INDEXED) {
+		palette = find_cooked_palette(header, variant);
+		if (palette == nullptr) {
+			printf("AssetManager::load_cooked_surface() - Unknown variant: %s\n", variant.c_str());
+			palette = find_cooked_palette(header, "");
 		}
+	} else if (!variant.empty()) {
+		printf("AssetManager::load_cooked_surface() - Not indexed, no variant: %s\n", variant.c_str());
+	}
 
-		fontMap[path] = font;
+	if (!(header->flags & COOKED_TILED)) {
+		return decode_cooked(get_cooked_payload(header),
+		                     get_cooked_payload_size(header),
+		                     header->compression,
+		                     header->width,
+		                     header->height,
+		                     header->pitch,
+		                     header->format,
+		                     palette);
 	}
 
+	// the whole sheet is wanted, put the tiles back together
+	int          bytes   = palette != nullptr ? 1 : 4;
+	SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, header->width, header->height, bytes * 8, header->format);
+	if (surface == nullptr) return nullptr;
+	if (palette != nullptr) {
+		SDL_SetPaletteColors(surface->format->palette, (const SDL_Color *)palette->colors, 0, 256);
+	}
+
+	for (Uint32 row = 0; row < get_cooked_rows(header); ++row) {
+		for (Uint32 column = 0; column < get_cooked_columns(header); ++column) {
+			SDL_Surface *tile = load_cooked_tile(header, column, row);
+			if (tile == nullptr) {
+				SDL_FreeSurface(surface);
+				return nullptr;
+			}
+
+			Uint8 *destination = (Uint8 *)surface->pixels + row * header->tile_size * surface->pitch +
+			                     column * header->tile_size * bytes;
+			for (int y = 0; y < tile->h; ++y) {
+				memcpy(destination + y * surface->pitch, (const Uint8 *)tile->pixels + y * tile->pitch, tile->w * bytes);
+			}
+			SDL_FreeSurface(tile);
+		}
+	}
+
+	return surface;
+}
+
+SDL_Surface *AssetManager::decode_cooked(const Uint8         *data,
+                                         size_t               size,
+                                         Uint32               compression,
+                                         int                  width,
+                                         int                  height,
+                                         int                  pitch,
+                                         Uint32               format,
+                                         const CookedPalette *palette) {
+	size_t       pixel_size = (size_t)pitch * height;
+	int          depth      = palette != nullptr ? 8 : 32;
+	SDL_Surface *surface    = nullptr;
+
+	if (compression == COOKED_RAW && size == pixel_size) {
+		// the pixels stay in the archive, nothing is copied before the upload
+		surface = SDL_CreateRGBSurfaceWithFormatFrom((void *)data, width, height, depth, pitch, format);
+	} else if (compression == COOKED_LZ4) {
+		surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, depth, format);
+		if (surface != nullptr &&
+		    (surface->pitch != pitch || !lz4_decompress(data, size, (Uint8 *)surface->pixels, pixel_size))) {
+			SDL_FreeSurface(surface);
+			surface = nullptr;
+		}
+	}
+
+	// one byte per texel, the colors come from the palette table
+	if (surface != nullptr && palette != nullptr) {
+		SDL_SetPaletteColors(surface->format->palette, (const SDL_Color *)palette->colors, 0, 256);
+	}
+
+	return surface;
+}
+
+bool AssetManager::is_cooked_stale(const std::string &path, const CookedTextureHeader *header) {
+	auto &manager = AssetManager::get();
+
+	{
+		std::lock_guard<std::mutex> lock(manager._image_mutex);
+		auto                        it = manager._stale_cooked.find(path);
+		if (it != manager._stale_cooked.end()) return it->second;
+	}
+
+	// only a source checkout has the image next to the archive, an edited
+	// image wins over the texture cooked from its previous version
+	bool          stale = false;
+	std::ifstream file(path, std::ios::binary);
+	if (file) {
+		std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		Uint64            source_hash = archive_hash(data.data(), data.size());
+
+		// the palette variants were chained in cooking order, after the colors of the image
+		const CookedPalette *palettes = (const CookedPalette *)(header + 1);
+		bool                 checked  = true;
+		for (Uint32 i = 1; i < header->palette_count; ++i) {
+			std::string   name(palettes[i].name, strnlen(palettes[i].name, sizeof(palettes[i].name)));
+			std::ifstream swaps(get_palette_path(path, name), std::ios::binary);
+			checked = (bool)swaps;
+			if (!checked) break;
+
+			data.assign(std::istreambuf_iterator<char>(swaps), std::istreambuf_iterator<char>());
+			source_hash = archive_hash(data.data(), data.size(), source_hash);
+		}
+
+		// a palette that cannot be read keeps the texture, it cannot be checked
+		stale = checked && source_hash != header->source_hash;
+		if (stale) printf("AssetManager::is_cooked_stale() - %s changed since it was cooked\n", path.c_str());
+	}
+
+	std::lock_guard<std::mutex> lock(manager._image_mutex);
+	manager._stale_cooked[path] = stale;
+	return stale;
+}
+
+bool AssetManager::read_image_info(const std::string &path, int &width, int &height, bool &premultiplied) {
+	std::string file, variant;
+	split_variant(path, file, variant);
+
+	const CookedTextureHeader *cooked = find_cooked_texture(file);
+	if (cooked != nullptr) {
+		width         = (int)cooked->width;
+		height        = (int)cooked->height;
+		premultiplied = (cooked->flags & COOKED_PREMULTIPLIED) != 0;
+		return true;
+	}
+
+	premultiplied = get_image_options(file).premultiply;
+	return read_png_size(file, width, height);
+}
+
+ImageOptions AssetManager::get_image_options(const std::string &path) {
+	auto                       &manager = AssetManager::get();
+	std::lock_guard<std::mutex> lock(manager._image_mutex);
+
+	// same options as the packer uses when cooking, read from the manifest
+	if (!manager._image_options_loaded) {
+		manager._image_options_loaded = true;
+
+		std::ifstream manifest(ASSET_ROOT "manifest.txt");
+		std::string   line;
+		while (std::getline(manifest, line)) {
+			std::istringstream tokens(line);
+			std::string        asset, option;
+			if (!(tokens >> asset) || asset[0] == '#') continue;
+
+			ImageOptions options;
+			while (tokens >> option) parse_image_option(option, options);
+			manager._image_options[ASSET_ROOT + asset] = options;
+		}
+	}
+
+	auto it = manager._image_options.find(path);
+	return it != manager._image_options.end() ? it->second : ImageOptions();
+}
+
+Uint32 AssetManager::get_texture_format() {
+	auto &manager = AssetManager::get();
+
+	if (manager._texture_format == SDL_PIXELFORMAT_UNKNOWN) {
+		manager._texture_format = SDL_PIXELFORMAT_RGBA32;
+
+		// renderers preferring ARGB8888 (BGRA32 in memory) get it swizzled at load time
+		SDL_RendererInfo info;
+		if (SDL_GetRendererInfo(Application::get_renderer(), &info) == 0 && info.num_texture_formats > 0 &&
+		    info.texture_formats[0] == SDL_PIXELFORMAT_BGRA32) {
+			manager._texture_format = SDL_PIXELFORMAT_BGRA32;
+		}
+	}
+
+	return manager._texture_format;
+}
+
+void AssetManager::set_blend_mode(SDL_Texture *texture, bool premultiplied) {
+	if (!premultiplied) {
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		return;
+	}
+
+	SDL_BlendMode mode = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE,
+	                                                SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+	                                                SDL_BLENDOPERATION_ADD,
+	                                                SDL_BLENDFACTOR_ONE,
+	                                                SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+	                                                SDL_BLENDOPERATION_ADD);
+	if (SDL_SetTextureBlendMode(texture, mode) != 0) {
+		printf("AssetManager::set_blend_mode() - Premultiplied alpha unsupported: %s\n", SDL_GetError());
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	}
+}
+
+bool AssetManager::read_png_size(const std::string &path, int &width, int &height) {
+	// signature (8) + IHDR length and type (8) + width and height, big endian
+	unsigned char header[24];
+	SDL_RWops    *file = AssetArchive::open_rw(path);
+	if (file == nullptr) return false;
+
+	size_t read = SDL_RWread(file, header, 1, sizeof(header));
+	SDL_RWclose(file);
+	if (read != sizeof(header)) return false;
+
+	static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	if (!std::equal(signature, signature + 8, header) || !std::equal(header + 12, header + 16, "IHDR")) return false;
+
+	width  = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+	height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+	return width > 0 && height > 0;
+}
+
+FontHandle AssetManager::load_font(const std::string &path, int size) {
+	auto &manager = AssetManager::get();
+
+	// the same file opened at two sizes is two fonts
+	std::string key = path + "@" + std::to_string(size);
+
+	auto it = manager._font_lookup.find(key);
+	if (it != manager._font_lookup.end()) return {it->second, manager._fonts[it->second].generation};
+
+	// archived fonts are read in place, the archive outlives them
+	TTF_Font *font = TTF_OpenFontRW(AssetArchive::open_rw(path), 1, size);
+	if (font == nullptr) {
+		throw std::runtime_error("Failed to load font: " + path);
+	}
+
+	FontSlot slot;
+	slot.font = font;
+	slot.path = path;
+	slot.size = size;
+
+	Uint32 index = (Uint32)manager._fonts.size();
+	manager._fonts.push_back(slot);
+	manager._font_lookup[key] = index;
+
+	return {index, slot.generation};
+}
+
+bool AssetManager::load_tile_map(const std::string &path, TileMap &map) {
+	std::string directory = path.substr(0, path.find_last_of('/') + 1);
+
+	// a loose file (source checkout) wins over the packed one, which may be older
+	auto read_text = [](const std::string &file, std::vector<char> &text, const char *&data, size_t &size) {
+		std::ifstream stream(file, std::ios::binary);
+		if (stream) {
+			text.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+			data = text.data();
+			size = text.size();
+			return true;
+		}
+
+		const void *packed;
+		if (!AssetArchive::find(file, packed, size)) return false;
+		data = (const char *)packed;
+		return true;
+	};
+
+	const void *cooked;
+	size_t      cooked_size;
+	if (AssetArchive::find(path + COOKED_MAP_EXTENSION, cooked, cooked_size) &&
+	    map.load_cooked(cooked, cooked_size, path + COOKED_MAP_EXTENSION)) {
+		// only a source checkout has the map next to the archive, an edited map
+		// or tileset wins over the map cooked from its previous version
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return true;
+
+		std::vector<char> text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		Uint64            source_hash = archive_hash(text.data(), text.size());
+		for (const TileSet &tileset : map.get_tilesets()) {
+			if (tileset.source.empty()) continue;
+
+			// mapcook hashed every tileset, the map cannot be checked without this one
+			std::ifstream source(directory + tileset.source, std::ios::binary);
+			if (!source) return true;
+
+			text.assign(std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>());
+			source_hash = archive_hash(text.data(), text.size(), source_hash);
+		}
+
+		if (source_hash == ((const CookedMapHeader *)cooked)->source_hash) return true;
+		printf("AssetManager::load_tile_map() - %s changed since it was cooked\n", path.c_str());
+	}
+
+	std::vector<char> text;
+	const char       *data;
+	size_t            size;
+	if (!read_text(path, text, data, size)) {
+		printf("AssetManager::load_tile_map() - %s not found\n", path.c_str());
+		return false;
+	}
+	if (!map.parse(data, size, path)) return false;
+
+	for (size_t i = 0; i < map.get_tilesets().size(); ++i) {
+		std::string source = map.get_tilesets()[i].source;
+		if (source.empty()) continue;
+
+		if (!read_text(directory + source, text, data, size)) {
+			printf("AssetManager::load_tile_map() - tileset %s%s not found\n", directory.c_str(), source.c_str());
+			return false;
+		}
+		if (!map.parse_tileset(i, data, size, directory + source)) return false;
+	}
 	return true;
 }
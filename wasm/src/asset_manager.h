@@ -3,8 +3,39 @@
 
 #pragma once
 
+#include "asset_archive.h"
+#include "asset_handle.h"
+#include "cooked_texture_format.h"
+#include "image_pipeline.h"
 #include "input_handler.h"
+#include "lock_free_queue.h"
+#include "tile_map.h"
 
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * Residency counters of the texture cache, shown by the overlay
+ */
+struct TextureStats {
+	size_t budget_bytes   = 0;
+	size_t resident_bytes = 0;
+	size_t resident_count = 0;
+	size_t hits           = 0;
+	size_t misses         = 0;
+	size_t evictions      = 0;
+};
+
+/**
+ * Owns every texture and font.
+ * Paths are only used to load an asset, which gives back a handle; every
+ * access after that is an index in a dense array.
+ *
+ * Textures are kept under a memory budget: when it is exceeded, the least
+ * recently used textures that are not pinned are destroyed. Their handles
+ * stay valid and the texture is reloaded the next time it is accessed.
+ */
 class AssetManager {
   public:
 	AssetManager();
@@ -18,15 +49,217 @@ class AssetManager {
 		return instance;
 	}
 
-	static SDL_Texture &get_texture(const std::string &path);
-	static bool         load_texture(const std::string &path);
+	/**
+	 * Loads the texture on the calling thread, finishing the asynchronous
+	 * request if there is one
+	 */
+	static TextureHandle load_texture(const std::string &path);
+
+	/**
+	 * Decodes the image on the thread pool, the texture is uploaded later by
+	 * pump_uploads() on the main thread. Until then the handle resolves to a
+	 * transparent placeholder of the right size.
+	 */
+	static TextureHandle load_texture_async(const std::string &path);
+	static bool          is_texture_ready(TextureHandle handle);
+
+	/**
+	 * Destroys the texture and invalidates every handle to it
+	 */
+	static void unload_texture(TextureHandle handle);
+
+	/**
+	 * Pinned textures are never evicted
+	 */
+	static void pin_texture(TextureHandle handle, bool pinned = true);
+
+	static void                set_texture_budget(size_t bytes);
+	static const TextureStats &get_texture_stats() { return get()._stats; }
+
+	/**
+	 * Uploads the decoded images, stops once budget_ms is spent.
+	 * Must be called once per frame from the main thread, it also advances
+	 * the clock used to find the least recently used textures.
+	 */
+	static void pump_uploads(double budget_ms);
+
+	static FontHandle load_font(const std::string &path, int size);
+
+	/**
+	 * Loads a Tiled map, from the map cooked by tools/mapcook when the archive
+	 * has one that matches the map, by parsing the .tmx and its external
+	 * tilesets otherwise (straight from the archive memory when they are packed)
+	 * @return false if the map is missing or malformed
+	 */
+	static bool load_tile_map(const std::string &path, TileMap &map);
+
+	/**
+	 * Decodes an image, from its cooked texture when the archive has one that
+	 * matches the image, through the image pipeline otherwise with the options
+	 * of the manifest. Safe to call from any thread.
+	 * @param path The image, "<image>#<variant>" for a palette variant of it
+	 * @param premultiplied Set to whether the pixels have premultiplied alpha
+	 */
+	static SDL_Surface *load_surface(const std::string &path,
+	                                 Uint32             format        = SDL_PIXELFORMAT_RGBA32,
+	                                 bool              *premultiplied = nullptr);
+
+	/**
+	 * @return the cooked texture of the image, nullptr if there is none or it
+	 * was cooked from an older version of the image
+	 */
+	static const CookedTextureHeader *find_cooked_texture(const std::string &path);
+
+	/**
+	 * Splits "images/a.png#shiny" in the image and the variant, which is
+	 * empty when the path has none
+	 */
+	static void split_variant(const std::string &path, std::string &file, std::string &variant);
+
+	/**
+	 * Decodes a single tile of a tiled cooked texture, indexed tiles get the
+	 * colors of the image
+	 */
+	static SDL_Surface *load_cooked_tile(const CookedTextureHeader *header, Uint32 column, Uint32 row);
+
+	/**
+	 * @return the palette table of an indexed cooked texture, the colors of
+	 * the image when variant is empty, nullptr if it has no such variant
+	 */
+	static const CookedPalette *find_cooked_palette(const CookedTextureHeader *header, const std::string &variant);
+
+	static Uint32 get_cooked_columns(const CookedTextureHeader *header) {
+		return (header->width + header->tile_size - 1) / header->tile_size;
+	}
+	static Uint32 get_cooked_rows(const CookedTextureHeader *header) {
+		return (header->height + header->tile_size - 1) / header->tile_size;
+	}
+
+	/**
+	 * The pixels, or the tile table, after the palette tables
+	 */
+	static const Uint8 *get_cooked_payload(const CookedTextureHeader *header) {
+		return (const Uint8 *)(header + 1) + header->palette_count * sizeof(CookedPalette);
+	}
+	static size_t get_cooked_payload_size(const CookedTextureHeader *header) {
+		return header->data_size - header->palette_count * sizeof(CookedPalette);
+	}
+
+	/**
+	 * @return nullptr if the handle is stale, a placeholder if the texture was
+	 * evicted and is being reloaded
+	 */
+	static SDL_Texture *get_texture(TextureHandle handle) {
+		auto &manager = get();
+		if (handle.index >= manager._textures.size()) return nullptr;
+
+		TextureSlot &slot = manager._textures[handle.index];
+		if (slot.generation != handle.generation) return nullptr;
+
+		slot.last_used = manager._frame;
+		if (slot.texture == nullptr) return reload_texture(handle.index);
+
+		manager._stats.hits++;
+		return slot.texture;
+	}
 
-	static TTF_Font &get_font(const std::string &path, int size);
-	static bool      load_font(const std::string &path, int size);
+	static TTF_Font *get_font(FontHandle handle) {
+		const auto &fonts = get()._fonts;
+		if (handle.index >= fonts.size() || fonts[handle.index].generation != handle.generation) return nullptr;
+		return fonts[handle.index].font;
+	}
 
   private:
-	std::map<std::string, SDL_Texture *> _textureMap;
-	std::map<std::string, TTF_Font *>    _fontMap;
+	struct PendingTexture;
+
+	struct TextureSlot {
+		SDL_Texture    *texture    = nullptr;
+		Uint32          generation = 1;
+		bool            ready      = false;
+		bool            pinned     = false;
+		size_t          bytes      = 0;
+		Uint64          last_used  = 0;
+		PendingTexture *pending    = nullptr;
+		std::string     path;
+	};
+
+	struct FontSlot {
+		TTF_Font   *font       = nullptr;
+		Uint32      generation = 1;
+		std::string path;
+		int         size = 0;
+	};
+
+	struct PendingTexture {
+		Uint32       index;
+		std::string  path;
+		SDL_Surface *surface   = nullptr;
+		int          next_row  = 0;
+		bool         cancelled = false;
+	};
+
+	struct DecodedTexture {
+		PendingTexture *pending = nullptr;
+		SDL_Surface    *surface = nullptr;
+	};
+
+	static TextureHandle find_texture(const std::string &path);
+	static Uint32        add_slot(const std::string &path);
+	static bool          load_slot(Uint32 index);
+	static bool          start_async_load(Uint32 index);
+	static SDL_Texture  *reload_texture(Uint32 index);
+	static void          set_resident(Uint32 index, SDL_Texture *texture, size_t bytes);
+	static void          evict(Uint32 index);
+	static void          enforce_budget();
+	static void          finish_pending(PendingTexture *pending);
+	static void          upload_decoded(double budget_ms); // pump_uploads() without advancing the clock
+	static bool          read_image_info(const std::string &path, int &width, int &height, bool &premultiplied);
+	static bool          read_png_size(const std::string &path, int &width, int &height);
+	static Uint32        get_texture_format();
+	static void          set_blend_mode(SDL_Texture *texture, bool premultiplied);
+	static ImageOptions  get_image_options(const std::string &path);
+
+	static SDL_Surface *load_cooked_surface(const CookedTextureHeader *header, const std::string &variant);
+	static SDL_Surface *decode_cooked(const Uint8         *data,
+	                                  size_t               size,
+	                                  Uint32               compression,
+	                                  int                  width,
+	                                  int                  height,
+	                                  int                  pitch,
+	                                  Uint32               format,
+	                                  const CookedPalette *palette);
+
+	/**
+	 * Reads the color swaps of a variant of a loose image, see get_palette_path()
+	 */
+	static bool load_color_swaps(const std::string &file, const std::string &variant, std::vector<ColorSwap> &swaps);
+	static bool is_cooked_stale(const std::string &path, const CookedTextureHeader *header);
+
+	std::vector<TextureSlot>                _textures;
+	std::vector<Uint32>                     _free_textures;
+	std::vector<FontSlot>                   _fonts;
+	std::unordered_map<std::string, Uint32> _texture_lookup;
+	std::unordered_map<std::string, Uint32> _font_lookup;
+
+	TextureStats _stats;
+	Uint64       _frame = 1;
+
+	// main thread only
+	std::vector<std::unique_ptr<PendingTexture>> _pending;
+	std::deque<PendingTexture *>                 _uploads;
+
+	// filled by the decoding threads
+	LockFreeQueue<DecodedTexture, 64> _decoded;
+
+	// format the renderer uploads without converting
+	Uint32 _texture_format = SDL_PIXELFORMAT_UNKNOWN;
+
+	// cooked textures checked against their source image and manifest
+	// options of the loose images, any thread
+	std::unordered_map<std::string, bool>         _stale_cooked;
+	std::unordered_map<std::string, ImageOptions> _image_options;
+	bool                                          _image_options_loaded = false;
+	std::mutex                                    _image_mutex;
 };
 
 #endif
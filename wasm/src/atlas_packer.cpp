@@ -0,0 +1,192 @@
+#include "atlas_packer.h"
+
+#include <climits>
+
+namespace {
+	bool contains(const SDL_Rect& outer, const SDL_Rect& inner) {
+		return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.w <= outer.x + outer.w &&
+		       inner.y + inner.h <= outer.y + outer.h;
+	}
+} // namespace
+
+MaxRectsPacker::MaxRectsPacker(int width, int height): _width(width), _height(height) {
+	_free_rects.push_back({0, 0, width, height});
+}
+
+bool MaxRectsPacker::insert(int w, int h, SDL_Rect& out) {
+	if (w <= 0 || h <= 0) return false;
+
+	int      best_short_side = INT_MAX;
+	int      best_long_side  = INT_MAX;
+	SDL_Rect best            = {0, 0, 0, 0};
+
+	for (const SDL_Rect& free_rect : _free_rects) {
+		if (free_rect.w < w || free_rect.h < h) continue;
+
+		int leftover_w = free_rect.w - w;
+		int leftover_h = free_rect.h - h;
+		int short_side = std::min(leftover_w, leftover_h);
+		int long_side  = std::max(leftover_w, leftover_h);
+
+		if (short_side < best_short_side || (short_side == best_short_side && long_side < best_long_side)) {
+			best            = {free_rect.x, free_rect.y, w, h};
+			best_short_side = short_side;
+			best_long_side  = long_side;
+		}
+	}
+
+	if (best_short_side == INT_MAX) return false;
+
+	// split every free rectangle overlapped by the new one
+	_new_free_rects.clear();
+	for (size_t i = 0; i < _free_rects.size();) {
+		if (split_free_rect(_free_rects[i], best)) {
+			_free_rects[i] = _free_rects.back();
+			_free_rects.pop_back();
+		} else {
+			++i;
+		}
+	}
+	_free_rects.insert(_free_rects.end(), _new_free_rects.begin(), _new_free_rects.end());
+	prune_free_rects();
+
+	_used_area += (long long)w * h;
+	_used_width  = std::max(_used_width, best.x + best.w);
+	_used_height = std::max(_used_height, best.y + best.h);
+
+	out = best;
+	return true;
+}
+
+float MaxRectsPacker::occupancy() const {
+	return (float)_used_area / ((float)_width * _height);
+}
+
+bool MaxRectsPacker::split_free_rect(const SDL_Rect& free_rect, const SDL_Rect& used) {
+	if (used.x >= free_rect.x + free_rect.w || used.x + used.w <= free_rect.x || used.y >= free_rect.y + free_rect.h ||
+	    used.y + used.h <= free_rect.y)
+		return false;
+
+	// left and right leftovers
+	if (used.x > free_rect.x) {
+		_new_free_rects.push_back({free_rect.x, free_rect.y, used.x - free_rect.x, free_rect.h});
+	}
+	if (used.x + used.w < free_rect.x + free_rect.w) {
+		_new_free_rects.push_back({used.x + used.w,
+		                           free_rect.y,
+		                           free_rect.x + free_rect.w - (used.x + used.w),
+		                           free_rect.h});
+	}
+
+	// top and bottom leftovers
+	if (used.y > free_rect.y) {
+		_new_free_rects.push_back({free_rect.x, free_rect.y, free_rect.w, used.y - free_rect.y});
+	}
+	if (used.y + used.h < free_rect.y + free_rect.h) {
+		_new_free_rects.push_back({free_rect.x,
+		                           used.y + used.h,
+		                           free_rect.w,
+		                           free_rect.y + free_rect.h - (used.y + used.h)});
+	}
+
+	return true;
+}
+
+void MaxRectsPacker::prune_free_rects() {
+	// drop every free rectangle fully contained in another one
+	for (size_t i = 0; i < _free_rects.size(); ++i) {
+		for (size_t j = i + 1; j < _free_rects.size(); ++j) {
+			if (contains(_free_rects[j], _free_rects[i])) {
+				_free_rects.erase(_free_rects.begin() + i);
+				--i;
+				break;
+			}
+			if (contains(_free_rects[i], _free_rects[j])) {
+				_free_rects.erase(_free_rects.begin() + j);
+				--j;
+			}
+		}
+	}
+}
+
+SkylinePacker::SkylinePacker(int width, int height): _width(width), _height(height) {
+	reset();
+}
+
+void SkylinePacker::reset() {
+	_skyline.clear();
+	_skyline.push_back({0, 0, _width});
+	_used_area = 0;
+}
+
+int SkylinePacker::fit(size_t index, int w, int h) const {
+	int x = _skyline[index].x;
+	if (x + w > _width) return -1;
+
+	int y          = _skyline[index].y;
+	int width_left = w;
+	for (size_t i = index; width_left > 0 && i < _skyline.size(); ++i) {
+		y = std::max(y, _skyline[i].y);
+		if (y + h > _height) return -1;
+		width_left -= _skyline[i].w;
+	}
+
+	return y;
+}
+
+bool SkylinePacker::insert(int w, int h, SDL_Rect& out) {
+	if (w <= 0 || h <= 0) return false;
+
+	int    best_bottom = INT_MAX;
+	int    best_width  = INT_MAX;
+	size_t best_index  = 0;
+	int    best_y      = -1;
+
+	for (size_t i = 0; i < _skyline.size(); ++i) {
+		int y = fit(i, w, h);
+		if (y < 0) continue;
+
+		if (y + h < best_bottom || (y + h == best_bottom && _skyline[i].w < best_width)) {
+			best_bottom = y + h;
+			best_width  = _skyline[i].w;
+			best_index  = i;
+			best_y      = y;
+		}
+	}
+
+	if (best_y < 0) return false;
+
+	out = {_skyline[best_index].x, best_y, w, h};
+	_skyline.insert(_skyline.begin() + best_index, {out.x, best_y + h, w});
+
+	// shrink or drop the nodes now hidden under the new one
+	for (size_t i = best_index + 1; i < _skyline.size(); ++i) {
+		const Node& previous = _skyline[i - 1];
+		int         overlap  = previous.x + previous.w - _skyline[i].x;
+		if (overlap <= 0) break;
+
+		_skyline[i].x += overlap;
+		_skyline[i].w -= overlap;
+		if (_skyline[i].w > 0) break;
+
+		_skyline.erase(_skyline.begin() + i);
+		--i;
+	}
+
+	// merge neighbours at the same height
+	for (size_t i = 0; i + 1 < _skyline.size();) {
+		if (_skyline[i].y == _skyline[i + 1].y) {
+			_skyline[i].w += _skyline[i + 1].w;
+			_skyline.erase(_skyline.begin() + i + 1);
+		} else {
+			++i;
+		}
+	}
+
+	_used_area += (long long)w * h;
+	return true;
+}
+
+float SkylinePacker::occupancy() const {
+	return (float)_used_area / ((float)_width * _height);
+}
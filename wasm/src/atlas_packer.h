@@ -0,0 +1,88 @@
+#ifndef ATLAS_PACKER_H
+#define ATLAS_PACKER_H
+
+#pragma once
+
+#include "includes.h"
+
+/**
+ * MaxRects bin packer (Best Short Side Fit).
+ * Keeps the list of maximal free rectangles of a single page and places each
+ * new rectangle where it leaves the smallest leftover on its shortest side.
+ */
+class MaxRectsPacker {
+  public:
+	MaxRectsPacker(int width, int height);
+
+	/**
+	 * Tries to place a w x h rectangle in the page
+	 * @param w The width of the rectangle
+	 * @param h The height of the rectangle
+	 * @param out The placed rectangle, only written on success
+	 * @return true if the rectangle fits, false if the page is full
+	 */
+	bool insert(int w, int h, SDL_Rect& out);
+
+	int get_width() const { return _width; }
+	int get_height() const { return _height; }
+
+	/**
+	 * Extent of the placed rectangles, used to shrink the last page
+	 */
+	int get_used_width() const { return _used_width; }
+	int get_used_height() const { return _used_height; }
+
+	float occupancy() const;
+
+  private:
+	bool split_free_rect(const SDL_Rect& free_rect, const SDL_Rect& used_rect);
+	void prune_free_rects();
+
+	int _width;
+	int _height;
+	int _used_width  = 0;
+	int _used_height = 0;
+
+	long long             _used_area = 0;
+	std::vector<SDL_Rect> _free_rects;
+	std::vector<SDL_Rect> _new_free_rects;
+};
+
+/**
+ * Skyline bin packer (Bottom-Left).
+ * Only keeps the top outline of the placed rectangles, which makes insertion
+ * cheap enough to run while the game is playing. Freed space is not tracked,
+ * pages are reclaimed by repacking them from scratch.
+ */
+class SkylinePacker {
+  public:
+	SkylinePacker(int width, int height);
+
+	bool insert(int w, int h, SDL_Rect& out);
+	void reset();
+
+	int get_width() const { return _width; }
+	int get_height() const { return _height; }
+
+	float occupancy() const;
+
+  private:
+	struct Node {
+		int x;
+		int y;
+		int w;
+	};
+
+	/**
+	 * @return the y at which a w x h rectangle fits on top of the node, -1 if it does not fit
+	 */
+	int fit(size_t index, int w, int h) const;
+
+	int _width;
+	int _height;
+
+	long long         _used_area = 0;
+	std::vector<Node> _skyline;
+};
+
+#endif
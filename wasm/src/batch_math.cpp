@@ -0,0 +1,170 @@
+#include "batch_math.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BATCH_MATH_SSE2
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#define BATCH_MATH_WASM_SIMD
+#include <wasm_simd128.h>
+#endif
+
+#if defined(BATCH_MATH_SSE2)
+namespace {
+	// 1 / sqrt(v), 12 bits from the hardware estimate then one Newton-Raphson step
+	inline __m128 reciprocal_sqrt(__m128 v) {
+		const __m128 half         = _mm_set1_ps(0.5f);
+		const __m128 three_halves = _mm_set1_ps(1.5f);
+
+		__m128 r = _mm_rsqrt_ps(v);
+		return _mm_mul_ps(r, _mm_sub_ps(three_halves, _mm_mul_ps(_mm_mul_ps(half, v), _mm_mul_ps(r, r))));
+	}
+} // namespace
+#endif
+
+void batch_integrate(Vector2Batch& positions, const Vector2Batch& velocities, float delta_time) {
+	size_t       count = std::min(positions.size(), velocities.size());
+	float*       x     = positions.x.data();
+	float*       y     = positions.y.data();
+	const float* vx    = velocities.x.data();
+	const float* vy    = velocities.y.data();
+	size_t       i     = 0;
+
+#if defined(BATCH_MATH_SSE2)
+	const __m128 dt = _mm_set1_ps(delta_time);
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(vx + i), dt)));
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(vy + i), dt)));
+	}
+#elif defined(BATCH_MATH_WASM_SIMD)
+	const v128_t dt = wasm_f32x4_splat(delta_time);
+	for (; i + 4 <= count; i += 4) {
+		wasm_v128_store(x + i, wasm_f32x4_add(wasm_v128_load(x + i), wasm_f32x4_mul(wasm_v128_load(vx + i), dt)));
+		wasm_v128_store(y + i, wasm_f32x4_add(wasm_v128_load(y + i), wasm_f32x4_mul(wasm_v128_load(vy + i), dt)));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		x[i] += vx[i] * delta_time;
+		y[i] += vy[i] * delta_time;
+	}
+}
+
+void batch_normalize(Vector2Batch& vectors) {
+	size_t count = vectors.size();
+	float* x     = vectors.x.data();
+	float* y     = vectors.y.data();
+	size_t i     = 0;
+
+#if defined(BATCH_MATH_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4) {
+		__m128 vx      = _mm_loadu_ps(x + i);
+		__m128 vy      = _mm_loadu_ps(y + i);
+		__m128 length2 = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+
+		// rsqrt(0) is inf, the mask keeps zero vectors at zero instead of NaN
+		__m128 scale = _mm_and_ps(reciprocal_sqrt(length2), _mm_cmpgt_ps(length2, zero));
+		_mm_storeu_ps(x + i, _mm_mul_ps(vx, scale));
+		_mm_storeu_ps(y + i, _mm_mul_ps(vy, scale));
+	}
+#elif defined(BATCH_MATH_WASM_SIMD)
+	// no reciprocal square root estimate in simd128
+	const v128_t zero = wasm_f32x4_splat(0.0f);
+	const v128_t one  = wasm_f32x4_splat(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		v128_t vx      = wasm_v128_load(x + i);
+		v128_t vy      = wasm_v128_load(y + i);
+		v128_t length2 = wasm_f32x4_add(wasm_f32x4_mul(vx, vx), wasm_f32x4_mul(vy, vy));
+		v128_t scale   = wasm_f32x4_div(one, wasm_f32x4_sqrt(length2));
+		scale          = wasm_v128_and(scale, wasm_f32x4_gt(length2, zero));
+		wasm_v128_store(x + i, wasm_f32x4_mul(vx, scale));
+		wasm_v128_store(y + i, wasm_f32x4_mul(vy, scale));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		float length2 = x[i] * x[i] + y[i] * y[i];
+		if (length2 <= 0.0f) continue;
+
+		float scale = 1.0f / std::sqrt(length2);
+		x[i] *= scale;
+		y[i] *= scale;
+	}
+}
+
+void batch_lerp(Vector2Batch& vectors, const Vector2Batch& targets, float t) {
+	size_t       count = std::min(vectors.size(), targets.size());
+	float*       x     = vectors.x.data();
+	float*       y     = vectors.y.data();
+	const float* tx    = targets.x.data();
+	const float* ty    = targets.y.data();
+	size_t       i     = 0;
+
+#if defined(BATCH_MATH_SSE2)
+	const __m128 vt = _mm_set1_ps(t);
+	for (; i + 4 <= count; i += 4) {
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		_mm_storeu_ps(x + i, _mm_add_ps(vx, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(tx + i), vx), vt)));
+		_mm_storeu_ps(y + i, _mm_add_ps(vy, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(ty + i), vy), vt)));
+	}
+#elif defined(BATCH_MATH_WASM_SIMD)
+	const v128_t vt = wasm_f32x4_splat(t);
+	for (; i + 4 <= count; i += 4) {
+		v128_t vx = wasm_v128_load(x + i);
+		v128_t vy = wasm_v128_load(y + i);
+		wasm_v128_store(x + i, wasm_f32x4_add(vx, wasm_f32x4_mul(wasm_f32x4_sub(wasm_v128_load(tx + i), vx), vt)));
+		wasm_v128_store(y + i, wasm_f32x4_add(vy, wasm_f32x4_mul(wasm_f32x4_sub(wasm_v128_load(ty + i), vy), vt)));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		x[i] += (tx[i] - x[i]) * t;
+		y[i] += (ty[i] - y[i]) * t;
+	}
+}
+
+void batch_clamp_length(Vector2Batch& vectors, float max_length) {
+	size_t count       = vectors.size();
+	float* x           = vectors.x.data();
+	float* y           = vectors.y.data();
+	float  max_length2 = max_length * max_length;
+	size_t i           = 0;
+
+#if defined(BATCH_MATH_SSE2)
+	const __m128 limit  = _mm_set1_ps(max_length);
+	const __m128 limit2 = _mm_set1_ps(max_length2);
+	for (; i + 4 <= count; i += 4) {
+		__m128 vx      = _mm_loadu_ps(x + i);
+		__m128 vy      = _mm_loadu_ps(y + i);
+		__m128 length2 = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+
+		// only the lanes over the limit are scaled, the others keep their exact value
+		__m128 over  = _mm_cmpgt_ps(length2, limit2);
+		__m128 scale = _mm_mul_ps(limit, reciprocal_sqrt(length2));
+		_mm_storeu_ps(x + i, _mm_or_ps(_mm_and_ps(over, _mm_mul_ps(vx, scale)), _mm_andnot_ps(over, vx)));
+		_mm_storeu_ps(y + i, _mm_or_ps(_mm_and_ps(over, _mm_mul_ps(vy, scale)), _mm_andnot_ps(over, vy)));
+	}
+#elif defined(BATCH_MATH_WASM_SIMD)
+	const v128_t limit  = wasm_f32x4_splat(max_length);
+	const v128_t limit2 = wasm_f32x4_splat(max_length2);
+	for (; i + 4 <= count; i += 4) {
+		v128_t vx      = wasm_v128_load(x + i);
+		v128_t vy      = wasm_v128_load(y + i);
+		v128_t length2 = wasm_f32x4_add(wasm_f32x4_mul(vx, vx), wasm_f32x4_mul(vy, vy));
+		v128_t over    = wasm_f32x4_gt(length2, limit2);
+		v128_t scale   = wasm_f32x4_div(limit, wasm_f32x4_sqrt(length2));
+		wasm_v128_store(x + i, wasm_v128_bitselect(wasm_f32x4_mul(vx, scale), vx, over));
+		wasm_v128_store(y + i, wasm_v128_bitselect(wasm_f32x4_mul(vy, scale), vy, over));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		float length2 = x[i] * x[i] + y[i] * y[i];
+		if (length2 <= max_length2) continue;
+
+		float scale = max_length / std::sqrt(length2);
+		x[i] *= scale;
+		y[i] *= scale;
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef BATCH_MATH_H
+#define BATCH_MATH_H
+
+#pragma once
+
+#include "yet_another_math_header_file.h"
+
+/**
+ * Vectors of many entities stored as two float arrays (structure of arrays),
+ * so the kernels below read x and y of four entities per SIMD load.
+ */
+struct Vector2Batch {
+	std::vector<float> x;
+	std::vector<float> y;
+
+	size_t size() const { return x.size(); }
+
+	void resize(size_t count, float value = 0.0f) {
+		x.resize(count, value);
+		y.resize(count, value);
+	}
+
+	Vector2f get(size_t i) const { return Vector2f(x[i], y[i]); }
+
+	void set(size_t i, const Vector2f& value) {
+		x[i] = value.x;
+		y[i] = value.y;
+	}
+
+	void push_back(const Vector2f& value) {
+		x.push_back(value.x);
+		y.push_back(value.y);
+	}
+
+	/**
+	 * Removes the vector at i by moving the last one in its place
+	 */
+	void swap_remove(size_t i) {
+		x[i] = x.back();
+		y[i] = y.back();
+		x.pop_back();
+		y.pop_back();
+	}
+};
+
+/**
+ * Kernels over whole batches, with SSE2 or wasm simd128 when the target has
+ * them and a scalar loop for the remainder. The batches given to one call
+ * must have the same size.
+ */
+
+/**
+ * positions += velocities * delta_time
+ */
+void batch_integrate(Vector2Batch& positions, const Vector2Batch& velocities, float delta_time);
+
+/**
+ * Scales every vector to a length of 1, zero vectors stay zero.
+ * SSE2 uses the hardware reciprocal square root refined by one Newton step,
+ * the length of the result is within about 1e-6 of 1.
+ */
+void batch_normalize(Vector2Batch& vectors);
+
+/**
+ * vectors += (targets - vectors) * t
+ */
+void batch_lerp(Vector2Batch& vectors, const Vector2Batch& targets, float t);
+
+/**
+ * Shortens the vectors longer than max_length to max_length
+ */
+void batch_clamp_length(Vector2Batch& vectors, float max_length);
+
+#endif
@@ -1,9 +1,9 @@
 #include "character.h"
 
-Character::Character(SDL_Texture& texture, const SDL_Rect& frame_rect, const SDL_Rect& world_rect)
+Character::Character(TextureHandle texture, const SDL_Rect& frame_rect, const SDL_Rect& world_rect)
     : Sprite(texture, frame_rect, world_rect) {}
 
-Character::Character(SDL_Texture& texture, const SDL_Rect& frame_rect, int x, int y, int w, int h)
+Character::Character(TextureHandle texture, const SDL_Rect& frame_rect, int x, int y, int w, int h)
     : Sprite(texture, frame_rect, x, y, w, h) {}
 
 Character::Character(const Character& other): Sprite(other) {}
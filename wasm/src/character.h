@@ -7,8 +7,8 @@
 
 class Character: public Sprite {
   public:
-	Character(SDL_Texture& texture, const SDL_Rect& frame_rect, const SDL_Rect& world_rect);
-	Character(SDL_Texture& texture, const SDL_Rect& frame_rect, int x, int y, int w, int h);
+	Character(TextureHandle texture, const SDL_Rect& frame_rect, const SDL_Rect& world_rect);
+	Character(TextureHandle texture, const SDL_Rect& frame_rect, int x, int y, int w, int h);
 	Character(const Character& other);
 	virtual ~Character() = default;
 
@@ -0,0 +1,98 @@
+#ifndef COOKED_MAP_FORMAT_H
+#define COOKED_MAP_FORMAT_H
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Tile map compiled ahead of time by tools/mapcook, stored in the archive as
+ * "<map path>.cmap" next to the .tmx. It holds a TileMap as it is in memory,
+ * so loading it is a few copies and no parsing:
+ *
+ *   CookedMapHeader
+ *   CookedTileSet[tileset_count]
+ *   CookedLayer[layer_count]
+ *   CookedObject[object_count]
+ *   MapChunk[chunk_columns * chunk_rows]        see tile_map.h, row major
+ *   collision   height rows of collision_stride 64 bit words, bit x % 64
+ *               of word x / 64 is set for a solid tile
+ *   tiles       width * height gids per layer, in layer order
+ *   solid ids   local ids of the solid tiles, solid_count per tileset in
+ *               tileset order
+ *   strings     null terminated, referenced by their offset
+ *
+ * Every section keeps the next one aligned, integers are little endian.
+ */
+
+#define COOKED_MAP_MAGIC     0x50414D43 // "CMAP"
+#define COOKED_MAP_VERSION   1
+#define COOKED_MAP_EXTENSION ".cmap"
+
+enum CookedLayerFlags : uint32_t {
+	COOKED_LAYER_VISIBLE  = 1 << 0,
+	COOKED_LAYER_COLLIDES = 1 << 1,
+};
+
+struct CookedMapHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t tile_width;
+	uint32_t tile_height;
+	uint32_t tileset_count;
+	uint32_t layer_count;
+	uint32_t object_count;
+	uint32_t chunk_columns;
+	uint32_t chunk_rows;
+	uint32_t collision_stride;
+	uint32_t solid_count; // solid ids of all the tilesets
+	uint32_t strings_size;
+	uint32_t reserved[2];
+	uint64_t source_hash; // archive_hash() of the .tmx, chained through its external tilesets in order
+	uint64_t data_size;   // everything after the header
+};
+
+struct CookedTileSet {
+	uint32_t first_gid;
+	int32_t  tile_width;
+	int32_t  tile_height;
+	int32_t  tile_count;
+	int32_t  columns;
+	int32_t  image_width;
+	int32_t  image_height;
+	int32_t  transparent;
+	uint32_t name;
+	uint32_t source;
+	uint32_t image;
+	uint32_t solid_count;
+	uint32_t reserved[2];
+};
+
+struct CookedLayer {
+	int32_t  id;
+	int32_t  width;
+	int32_t  height;
+	uint32_t flags;
+	float    opacity;
+	uint32_t name;
+	uint32_t reserved[2];
+};
+
+struct CookedObject {
+	int32_t  id;
+	uint32_t gid;
+	uint32_t shape; // MapObjectShape
+	uint32_t visible;
+	uint32_t name;
+	uint32_t type;
+	uint32_t group;
+	float    x;
+	float    y;
+	float    width;
+	float    height;
+	float    rotation;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef COOKED_TEXTURE_FORMAT_H
+#define COOKED_TEXTURE_FORMAT_H
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Texture decoded ahead of time by the asset packer, stored in the archive
+ * as "<image path>.tex" in place of the image itself.
+ *
+ *   CookedTextureHeader
+ *   pixels      height rows of pitch bytes, raw or one LZ4 block
+ *
+ * Large sheets are cooked as tiles (COOKED_TILED) so that parts of them can
+ * be decoded on their own:
+ *
+ *   CookedTextureHeader
+ *   CookedTile[columns * rows]   row major
+ *   tiles       tile_size x tile_size texels (less on the last row and
+ *               column), rows of width * 4 bytes, raw or one LZ4 block
+ *
+ * Indexed textures (COOKED_INDEXED) hold one byte per texel, an index into
+ * palette tables stored right after the header; everything above follows
+ * the tables and rows are width bytes rounded up to 4, as SDL lays out
+ * 8-bit surfaces. Table 0 holds the colors of the image, the others are
+ * named variants of it (e.g. "shiny").
+ *
+ * The pixels have been through the image pipeline (color key, premultiplied
+ * alpha) and are in the format the texture cache creates its textures with,
+ * so they go to SDL_UpdateTexture as they are.
+ */
+
+#define COOKED_TEXTURE_MAGIC     0x58455443 // "CTEX"
+#define COOKED_TEXTURE_VERSION   3
+#define COOKED_TEXTURE_EXTENSION ".tex"
+
+enum CookedCompression : uint32_t {
+	COOKED_RAW = 0,
+	COOKED_LZ4 = 1,
+};
+
+enum CookedFlags : uint32_t {
+	COOKED_PREMULTIPLIED = 1 << 0,
+	COOKED_TILED         = 1 << 1,
+	COOKED_INDEXED       = 1 << 2,
+};
+
+struct CookedTextureHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format; // SDL_PixelFormatEnum
+	uint32_t width;
+	uint32_t height;
+	uint32_t pitch;
+	uint32_t compression;
+	uint32_t flags;
+	uint32_t tile_size;
+	uint32_t palette_count;
+	uint32_t reserved[2];
+	uint64_t source_hash; // archive_hash() of the image it was cooked from, chained with its palette variants
+	uint64_t data_size;
+};
+
+struct CookedPalette {
+	char     name[32]; // empty for the colors of the image
+	uint32_t colors[256]; // RGBA32 texels
+};
+
+struct CookedTile {
+	uint64_t offset; // from the end of the tile table
+	uint64_t size;
+	uint32_t compression;
+	uint32_t reserved[3]; // keeps the tiles after the table aligned
+};
+
+#endif
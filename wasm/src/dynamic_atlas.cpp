@@ -0,0 +1,426 @@
+#include "dynamic_atlas.h"
+
+#include "application.h"
+
+#include <set>
+#include <tuple>
+
+namespace {
+	const size_t NO_REGION = (size_t)-1;
+} // namespace
+
+DynamicAtlas::DynamicAtlas() {}
+
+DynamicAtlas::~DynamicAtlas() {
+	//? NOTE: pages are owned by the renderer, SDL_DestroyRenderer frees them
+}
+
+bool DynamicAtlas::acquire(const std::string &key, const std::string &source_path, AnimationController &controller) {
+	auto &atlas = get();
+
+	auto it      = atlas._groups.find(key);
+	bool created = it == atlas._groups.end();
+	if (created) {
+		Group group;
+		group.source_path = source_path;
+
+		for (auto &[name, animation] : controller.get_animations()) {
+			for (AnimationFrame &frame : animation.frames) {
+				if (frame.texture != nullptr || find_region(group, frame.rect) != NO_REGION) continue;
+				group.regions.push_back({-1, {0, 0, 0, 0}, frame.rect, frame.rect, NO_REGION, false});
+			}
+		}
+
+		if (group.regions.empty()) return false;
+
+		// only the part of the sheet under the frames is decoded
+		group.bounds = group.regions.front().source_rect;
+		for (const Region &region : group.regions) {
+			SDL_UnionRect(&group.bounds, &region.source_rect, &group.bounds);
+		}
+
+		SheetStreamer::retain(source_path, group.bounds);
+		SDL_Surface *pixels = SheetStreamer::read(source_path, group.bounds);
+		if (pixels == nullptr) {
+			printf("DynamicAtlas::acquire() - Failed to read %s\n", source_path.c_str());
+			SheetStreamer::release(source_path, group.bounds);
+			return false;
+		}
+
+		// pages use straight alpha
+		if (SheetStreamer::is_premultiplied(source_path)) {
+			printf("DynamicAtlas::acquire() - Premultiplied sheet: %s\n", source_path.c_str());
+			SDL_FreeSurface(pixels);
+			SheetStreamer::release(source_path, group.bounds);
+			return false;
+		}
+
+		// only the visible part of each frame takes room in the page
+		for (Region &region : group.regions) {
+			SDL_Rect area = {region.source_rect.x - group.bounds.x,
+			                 region.source_rect.y - group.bounds.y,
+			                 region.source_rect.w,
+			                 region.source_rect.h};
+			SDL_Rect bounds;
+			if (find_opaque_bounds(pixels, area, bounds)) {
+				region.crop = {bounds.x + group.bounds.x, bounds.y + group.bounds.y, bounds.w, bounds.h};
+			}
+		}
+		find_shared(group, pixels);
+
+		bool uploaded = false;
+		if (!atlas.allocate(group)) {
+			printf("DynamicAtlas::acquire() - No room left for %s\n", key.c_str());
+		} else if (!(uploaded = atlas.upload(group, pixels))) {
+			for (const Region &region : group.regions) {
+				if (region.shared_with != NO_REGION) continue;
+				atlas._pages[region.page].dead_area +=
+				    (long long)(region.rect.w + ATLAS_PADDING) * (region.rect.h + ATLAS_PADDING);
+			}
+		}
+		SDL_FreeSurface(pixels);
+
+		if (!uploaded) {
+			SheetStreamer::release(source_path, group.bounds);
+			return false;
+		}
+
+		it = atlas._groups.emplace(key, std::move(group)).first;
+	}
+
+	Group &group = it->second;
+	if (group.ref_count++ == 0 && !created) SheetStreamer::retain(group.source_path, group.bounds);
+
+	for (auto &[name, animation] : controller.get_animations()) {
+		for (AnimationFrame &frame : animation.frames) {
+			if (frame.texture != nullptr) continue;
+
+			size_t index = find_region(group, frame.rect);
+			if (index == NO_REGION) continue;
+
+			const Region &region = group.regions[index];
+			group.frames.push_back({&frame, frame.rect, frame.is_flipped, index});
+			frame.rect    = region.rect;
+			frame.texture = atlas._pages[region.page].texture;
+			frame.trim    = {region.crop.x - region.source_rect.x,
+			                 region.crop.y - region.source_rect.y,
+			                 region.source_rect.w,
+			                 region.source_rect.h};
+
+			// the packed texels are the mirror image of the frame, so is their place in it
+			if (region.mirrored) {
+				frame.trim.x     = region.source_rect.w - frame.trim.x - region.crop.w;
+				frame.is_flipped = !frame.is_flipped;
+			}
+		}
+	}
+
+	return true;
+}
+
+void DynamicAtlas::release(const std::string &key, AnimationController &controller) {
+	auto &atlas = get();
+
+	auto it = atlas._groups.find(key);
+	if (it == atlas._groups.end()) return;
+
+	std::set<AnimationFrame *> released;
+	for (auto &[name, animation] : controller.get_animations()) {
+		for (AnimationFrame &frame : animation.frames) released.insert(&frame);
+	}
+
+	Group &group = it->second;
+	for (size_t i = 0; i < group.frames.size();) {
+		FrameRef &ref = group.frames[i];
+		if (released.count(ref.frame)) {
+			reset_frame(ref);
+			group.frames[i] = group.frames.back();
+			group.frames.pop_back();
+		} else {
+			++i;
+		}
+	}
+
+	if (group.ref_count > 0 && --group.ref_count == 0) {
+		// stays resident in the page until the space is needed, not in memory
+		group.last_release = ++atlas._release_clock;
+		SheetStreamer::release(group.source_path, group.bounds);
+	}
+}
+
+void DynamicAtlas::defragment() {
+	auto &atlas = get();
+	for (size_t i = 0; i < atlas._pages.size(); ++i) {
+		atlas.defragment((int)i);
+	}
+}
+
+void DynamicAtlas::restore() {
+	auto &atlas = get();
+
+	std::vector<std::string> unused;
+	for (auto &[key, group] : atlas._groups) {
+		if (group.ref_count == 0) unused.push_back(key);
+	}
+	for (const std::string &key : unused) atlas.evict(key);
+
+	// the page contents are gone anyway, only the layout is compacted
+	defragment();
+
+	for (auto &[key, group] : atlas._groups) {
+		SDL_Surface *pixels = SheetStreamer::read(group.source_path, group.bounds);
+		if (pixels == nullptr || !atlas.upload(group, pixels)) {
+			printf("DynamicAtlas::restore() - Failed to restore %s\n", key.c_str());
+		}
+		SDL_FreeSurface(pixels);
+	}
+}
+
+void DynamicAtlas::clear() {
+	auto &atlas = get();
+
+	for (auto &[key, group] : atlas._groups) {
+		for (FrameRef &ref : group.frames) reset_frame(ref);
+		if (group.ref_count > 0) SheetStreamer::release(group.source_path, group.bounds);
+	}
+	atlas._groups.clear();
+
+	for (Page &page : atlas._pages) {
+		SDL_DestroyTexture(page.texture);
+	}
+	atlas._pages.clear();
+}
+
+bool DynamicAtlas::allocate(Group &group) {
+	if (try_allocate(group)) return true;
+
+	// make room by dropping the groups nobody uses, oldest first
+	while (evict_one()) {
+		if (try_allocate(group)) return true;
+	}
+
+	if (_pages.size() < ATLAS_MAX_PAGES && add_page()) {
+		return try_allocate(group);
+	}
+
+	return false;
+}
+
+bool DynamicAtlas::try_allocate(Group &group) {
+	std::vector<size_t> order;
+	for (size_t i = 0; i < group.regions.size(); ++i) {
+		if (group.regions[i].shared_with == NO_REGION) order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), [&group](size_t a, size_t b) {
+		return group.regions[a].crop.h > group.regions[b].crop.h;
+	});
+
+	// a group lives in a single page so that a species is drawn with one bind
+	for (size_t page = 0; page < _pages.size(); ++page) {
+		SkylinePacker         packer = _pages[page].packer;
+		std::vector<SDL_Rect> rects(group.regions.size());
+		bool                  fits = true;
+
+		for (size_t index : order) {
+			const SDL_Rect &crop = group.regions[index].crop;
+			if (!packer.insert(crop.w + ATLAS_PADDING, crop.h + ATLAS_PADDING, rects[index])) {
+				fits = false;
+				break;
+			}
+		}
+
+		if (!fits) continue;
+
+		_pages[page].packer = packer;
+		for (size_t i : order) {
+			Region &region = group.regions[i];
+			region.page    = (int)page;
+			region.rect    = {rects[i].x, rects[i].y, region.crop.w, region.crop.h};
+		}
+		sync_shared(group);
+		return true;
+	}
+
+	return false;
+}
+
+bool DynamicAtlas::add_page() {
+	SDL_Renderer *renderer = Application::get_renderer();
+
+	int              size = ATLAS_PAGE_SIZE;
+	SDL_RendererInfo info;
+	if (SDL_GetRendererInfo(renderer, &info) == 0 && info.max_texture_width > 0) {
+		size = std::min({size, info.max_texture_width, info.max_texture_height});
+	}
+
+	// render target so that defragmenting stays on the GPU
+	SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, size, size);
+	if (texture == nullptr) {
+		printf("DynamicAtlas::add_page() - Failed to create page: %s\n", SDL_GetError());
+		return false;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	_pages.push_back({texture, SkylinePacker(size, size)});
+	return true;
+}
+
+bool DynamicAtlas::evict_one() {
+	auto oldest = _groups.end();
+	for (auto it = _groups.begin(); it != _groups.end(); ++it) {
+		if (it->second.ref_count > 0) continue;
+		if (oldest == _groups.end() || it->second.last_release < oldest->second.last_release) oldest = it;
+	}
+
+	if (oldest == _groups.end()) return false;
+
+	int page = oldest->second.regions.front().page;
+	evict(oldest->first);
+	defragment(page);
+
+	return true;
+}
+
+void DynamicAtlas::evict(const std::string &key) {
+	auto it = _groups.find(key);
+	if (it == _groups.end()) return;
+
+	for (FrameRef &ref : it->second.frames) reset_frame(ref);
+
+	for (const Region &region : it->second.regions) {
+		if (region.shared_with != NO_REGION) continue;
+		_pages[region.page].dead_area += (long long)(region.rect.w + ATLAS_PADDING) * (region.rect.h + ATLAS_PADDING);
+	}
+
+	_groups.erase(it);
+}
+
+bool DynamicAtlas::defragment(int index) {
+	Page &page = _pages[index];
+	if (page.dead_area == 0) return true;
+
+	std::vector<Region *> live;
+	for (auto &[key, group] : _groups) {
+		for (Region &region : group.regions) {
+			if (region.page == index && region.shared_with == NO_REGION) live.push_back(&region);
+		}
+	}
+	std::sort(live.begin(), live.end(), [](const Region *a, const Region *b) { return a->rect.h > b->rect.h; });
+
+	SkylinePacker         packer(page.packer.get_width(), page.packer.get_height());
+	std::vector<SDL_Rect> rects(live.size());
+	for (size_t i = 0; i < live.size(); ++i) {
+		if (!packer.insert(live[i]->rect.w + ATLAS_PADDING, live[i]->rect.h + ATLAS_PADDING, rects[i])) return false;
+		rects[i].w = live[i]->rect.w;
+		rects[i].h = live[i]->rect.h;
+	}
+
+	int           w        = packer.get_width();
+	int           h        = packer.get_height();
+	SDL_Renderer *renderer = Application::get_renderer();
+	SDL_Texture  *texture  = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, w, h);
+	if (texture == nullptr) return false;
+
+	// copy the live regions to their new place without blending
+	SDL_Texture *previous_target = SDL_GetRenderTarget(renderer);
+	SDL_SetRenderTarget(renderer, texture);
+	SDL_SetTextureBlendMode(page.texture, SDL_BLENDMODE_NONE);
+	for (size_t i = 0; i < live.size(); ++i) {
+		SDL_RenderCopy(renderer, page.texture, &live[i]->rect, &rects[i]);
+	}
+	SDL_SetRenderTarget(renderer, previous_target);
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+	SDL_DestroyTexture(page.texture);
+	page.texture   = texture;
+	page.packer    = packer;
+	page.dead_area = 0;
+
+	for (size_t i = 0; i < live.size(); ++i) {
+		live[i]->rect = rects[i];
+	}
+
+	for (auto &[key, group] : _groups) {
+		sync_shared(group);
+		for (FrameRef &ref : group.frames) {
+			const Region &region = group.regions[ref.region];
+			if (region.page != index) continue;
+
+			ref.frame->rect    = region.rect;
+			ref.frame->texture = texture;
+		}
+	}
+
+	return true;
+}
+
+bool DynamicAtlas::upload(const Group &group, SDL_Surface *pixels) {
+	for (const Region &region : group.regions) {
+		if (region.shared_with != NO_REGION) continue;
+
+		// pixels covers the bounds of the group, the crop always lies inside
+		const Uint8 *data = (const Uint8 *)pixels->pixels + (region.crop.y - group.bounds.y) * pixels->pitch +
+		                    (region.crop.x - group.bounds.x) * 4;
+		if (SDL_UpdateTexture(_pages[region.page].texture, &region.rect, data, pixels->pitch) != 0) {
+			printf("DynamicAtlas::upload() - Failed to upload %s: %s\n", group.source_path.c_str(), SDL_GetError());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void DynamicAtlas::find_shared(Group &group, SDL_Surface *pixels) {
+	std::map<std::tuple<Uint64, int, int>, size_t> packed_lookup;
+
+	for (size_t i = 0; i < group.regions.size(); ++i) {
+		Region  &region    = group.regions[i];
+		SDL_Rect area      = {region.crop.x - group.bounds.x,
+		                      region.crop.y - group.bounds.y,
+		                      region.crop.w,
+		                      region.crop.h};
+		Uint64   hashes[2] = {hash_texels(pixels, area), hash_texels(pixels, area, true)};
+
+		for (bool mirrored : {false, true}) {
+			auto it = packed_lookup.find({hashes[mirrored], area.w, area.h});
+			if (it == packed_lookup.end()) continue;
+
+			const Region &packed      = group.regions[it->second];
+			SDL_Rect      packed_area = {packed.crop.x - group.bounds.x,
+			                             packed.crop.y - group.bounds.y,
+			                             packed.crop.w,
+			                             packed.crop.h};
+			if (same_texels(pixels, packed_area, pixels, area, mirrored)) {
+				region.shared_with = it->second;
+				region.mirrored    = mirrored;
+				break;
+			}
+		}
+
+		if (region.shared_with == NO_REGION) packed_lookup.emplace(std::make_tuple(hashes[0], area.w, area.h), i);
+	}
+}
+
+void DynamicAtlas::sync_shared(Group &group) {
+	for (Region &region : group.regions) {
+		if (region.shared_with == NO_REGION) continue;
+		region.page = group.regions[region.shared_with].page;
+		region.rect = group.regions[region.shared_with].rect;
+	}
+}
+
+void DynamicAtlas::reset_frame(const FrameRef &ref) {
+	ref.frame->rect       = ref.source_rect;
+	ref.frame->texture    = nullptr;
+	ref.frame->trim       = {0, 0, 0, 0};
+	ref.frame->is_flipped = ref.flipped;
+}
+
+size_t DynamicAtlas::find_region(const Group &group, const SDL_Rect &source_rect) {
+	for (size_t i = 0; i < group.regions.size(); ++i) {
+		const SDL_Rect &rect = group.regions[i].source_rect;
+		if (rect.x == source_rect.x && rect.y == source_rect.y && rect.w == source_rect.w && rect.h == source_rect.h)
+			return i;
+	}
+	return NO_REGION;
+}
@@ -0,0 +1,119 @@
+#ifndef DYNAMIC_ATLAS_H
+#define DYNAMIC_ATLAS_H
+
+#pragma once
+
+#include "animation_controller.h"
+#include "atlas_packer.h"
+#include "sheet_streamer.h"
+
+/**
+ * Atlas that grows while the game runs, one group of regions per species.
+ *
+ * acquire() only allocates and uploads the frames of the new group, existing
+ * pages are left untouched. Groups nobody uses anymore stay resident until
+ * their space is needed, then they are evicted oldest first and the page is
+ * repacked on the GPU.
+ *
+ * Transparent borders are trimmed, see AnimationFrame::trim. Frames of a
+ * group holding the same texels as another one, or their mirror image, are
+ * drawn from it.
+ *
+ * Frames are read from the spritesheet through the SheetStreamer, the tiles
+ * under a group stay decoded while the group is referenced.
+ *
+ * Registered frames are remapped in place, so the controller given to
+ * acquire() must be the one of the sprite that is rendered, and it must be
+ * handed back to release() before it is destroyed.
+ */
+class DynamicAtlas {
+  public:
+	DynamicAtlas();
+	~DynamicAtlas();
+
+	DynamicAtlas(const DynamicAtlas &)            = delete;
+	DynamicAtlas &operator=(const DynamicAtlas &) = delete;
+
+	static DynamicAtlas &get() {
+		static DynamicAtlas instance;
+		return instance;
+	}
+
+	/**
+	 * Maps the frames of the controller to the regions of the group, the
+	 * regions are uploaded from the spritesheet the first time the group is used
+	 * @param key The group name, e.g. the species
+	 * @param source_path The spritesheet the frame rects refer to
+	 * @return false if the frames could not be placed, they keep their spritesheet
+	 */
+	static bool acquire(const std::string &key, const std::string &source_path, AnimationController &controller);
+	static void release(const std::string &key, AnimationController &controller);
+
+	static bool contains(const std::string &key) { return get()._groups.count(key) > 0; }
+
+	/**
+	 * Repacks every page holding evicted regions
+	 */
+	static void defragment();
+
+	/**
+	 * Uploads the referenced groups again once the renderer lost its render
+	 * targets, the unreferenced ones are dropped
+	 */
+	static void restore();
+
+	static void clear();
+
+	static size_t get_page_count() { return get()._pages.size(); }
+	static size_t get_group_count() { return get()._groups.size(); }
+
+  private:
+	struct Region {
+		int      page;
+		SDL_Rect rect;
+		SDL_Rect source_rect;
+		SDL_Rect crop;      // source_rect without its transparent border
+		size_t   shared_with; // region holding the texels, page and rect are copied from it
+		bool     mirrored;    // the shared texels are the mirror image of this region
+	};
+
+	struct FrameRef {
+		AnimationFrame *frame;
+		SDL_Rect        source_rect;
+		bool            flipped;
+		size_t          region;
+	};
+
+	struct Group {
+		std::string           source_path;
+		SDL_Rect              bounds; // union of the source rects, retained in the streamer
+		std::vector<Region>   regions;
+		std::vector<FrameRef> frames;
+		int                   ref_count    = 0;
+		Uint64                last_release = 0;
+	};
+
+	struct Page {
+		SDL_Texture  *texture;
+		SkylinePacker packer;
+		long long     dead_area = 0;
+	};
+
+	bool          allocate(Group &group);
+	bool          try_allocate(Group &group);
+	bool          add_page();
+	bool          evict_one();
+	void          evict(const std::string &key);
+	bool          defragment(int page);
+	bool          upload(const Group &group, SDL_Surface *pixels);
+	static void   find_shared(Group &group, SDL_Surface *pixels);
+	static void   sync_shared(Group &group);
+	static void   reset_frame(const FrameRef &ref);
+	static size_t find_region(const Group &group, const SDL_Rect &source_rect);
+
+	std::map<std::string, Group>         _groups;
+	std::vector<Page>                    _pages;
+	Uint64                               _release_clock = 0;
+};
+
+#endif
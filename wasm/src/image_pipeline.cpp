@@ -0,0 +1,478 @@
+#include "image_pipeline.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_PIPELINE_SSE2
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#define IMAGE_PIPELINE_WASM_SIMD
+#include <wasm_simd128.h>
+#endif
+
+//? NOTE: the SIMD paths read RGBA32 texels as little endian words, which both
+// x86 and wasm are
+
+namespace {
+	inline Uint8 multiply_255(unsigned value, unsigned alpha) {
+		// value * alpha / 255, rounded
+		unsigned t = value * alpha + 128;
+		return (Uint8)((t + (t >> 8)) >> 8);
+	}
+
+	inline Uint32 texel_at(const SDL_Surface *surface, int x, int y) {
+		Uint32 texel;
+		memcpy(&texel, (const Uint8 *)surface->pixels + y * surface->pitch + x * 4, 4);
+		// the color of a transparent texel is never seen
+		return (texel & 0xFF000000) ? texel : 0;
+	}
+
+	template<typename Kernel>
+	void for_each_row(SDL_Surface *surface, Kernel kernel) {
+		for (int y = 0; y < surface->h; ++y) {
+			kernel((Uint8 *)surface->pixels + y * surface->pitch, (size_t)surface->w);
+		}
+	}
+
+	/**
+	 * Reads a whole token as a number no greater than max, no sign or spaces
+	 * @return false if it is empty, has other characters or is too large
+	 */
+	bool parse_number(const std::string &text, int base, unsigned long max, unsigned long &value) {
+		if (text.empty() || !isxdigit((unsigned char)text[0])) return false;
+
+		char *end = nullptr;
+		errno     = 0;
+		value     = strtoul(text.c_str(), &end, base);
+		return errno == 0 && *end == '\0' && value <= max;
+	}
+} // namespace
+
+bool parse_image_option(const std::string &token, ImageOptions &options) {
+	unsigned long value;
+	if (token.compare(0, 4, "key=") == 0) {
+		if (!parse_number(token.substr(4), 16, 0xFFFFFF, value)) return false;
+		options.color_key = (Sint32)value;
+		return true;
+	}
+	if (token.compare(0, 6, "tiles=") == 0) {
+		if (!parse_number(token.substr(6), 10, 0xFFFFFFFF, value) || value == 0) return false;
+		options.tile_size = (Uint32)value;
+		return true;
+	}
+	if (token == "premultiply") {
+		options.premultiply = true;
+		return true;
+	}
+	if (token == "indexed") {
+		options.indexed = true;
+		return true;
+	}
+	if (token.compare(0, 9, "palettes=") == 0) {
+		std::istringstream names(token.substr(9));
+		std::string        name;
+		while (std::getline(names, name, ',')) {
+			if (!name.empty()) options.palettes.push_back(name);
+		}
+		options.indexed = true;
+		return true;
+	}
+	return false;
+}
+
+bool index_image(const SDL_Surface *surface, std::vector<Uint8> &indices, std::vector<Uint32> &palette) {
+	indices.resize((size_t)surface->w * surface->h);
+	palette.clear();
+
+	// texels come in runs of the same color, only a new color is looked up
+	std::unordered_map<Uint32, Uint8> lookup;
+	Uint32                            last_texel = 0;
+	Uint8                             last_index = 0;
+
+	for (int y = 0; y < surface->h; ++y) {
+		const Uint32 *row = (const Uint32 *)((const Uint8 *)surface->pixels + y * surface->pitch);
+		for (int x = 0; x < surface->w; ++x) {
+			Uint32 texel = row[x];
+			if (palette.empty() || texel != last_texel) {
+				auto it = lookup.find(texel);
+				if (it == lookup.end()) {
+					if (palette.size() == 256) return false;
+					it = lookup.emplace(texel, (Uint8)palette.size()).first;
+					palette.push_back(texel);
+				}
+				last_texel = texel;
+				last_index = it->second;
+			}
+			indices[(size_t)y * surface->w + x] = last_index;
+		}
+	}
+
+	return true;
+}
+
+std::string get_palette_path(const std::string &image_path, const std::string &variant) {
+	size_t dot = image_path.find_last_of('.');
+	if (dot == std::string::npos || image_path.find('/', dot) != std::string::npos) dot = image_path.size();
+	return image_path.substr(0, dot) + "." + variant + ".pal";
+}
+
+bool parse_color_swaps(const std::string &text, std::vector<ColorSwap> &swaps) {
+	std::istringstream lines(text);
+	std::string        line;
+	while (std::getline(lines, line)) {
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream tokens(line);
+		std::string        from, to;
+		if (!(tokens >> from)) continue;
+		if (!(tokens >> to) || from.size() != 6 || to.size() != 6) return false;
+
+		char  *end      = nullptr;
+		Uint32 from_rgb = (Uint32)strtoul(from.c_str(), &end, 16);
+		if (*end != '\0') return false;
+		Uint32 to_rgb = (Uint32)strtoul(to.c_str(), &end, 16);
+		if (*end != '\0') return false;
+
+		swaps.push_back({from_rgb, to_rgb});
+	}
+
+	return true;
+}
+
+void color_key_to_alpha(Uint8 *pixels, size_t count, Uint32 rgb) {
+	// keyed texels become transparent black so filtering does not bleed the key
+	Uint32 key = ((rgb >> 16) & 0xFF) | (rgb & 0xFF00) | ((rgb & 0xFF) << 16);
+	size_t i   = 0;
+
+#if defined(IMAGE_PIPELINE_SSE2)
+	const __m128i mask = _mm_set1_epi32(0x00FFFFFF);
+	const __m128i keys = _mm_set1_epi32((int)key);
+	for (; i + 4 <= count; i += 4) {
+		__m128i *p       = (__m128i *)(pixels + i * 4);
+		__m128i  texels  = _mm_loadu_si128(p);
+		__m128i  matches = _mm_cmpeq_epi32(_mm_and_si128(texels, mask), keys);
+		_mm_storeu_si128(p, _mm_andnot_si128(matches, texels));
+	}
+#elif defined(IMAGE_PIPELINE_WASM_SIMD)
+	const v128_t mask = wasm_i32x4_splat(0x00FFFFFF);
+	const v128_t keys = wasm_i32x4_splat((int)key);
+	for (; i + 4 <= count; i += 4) {
+		Uint8 *p       = pixels + i * 4;
+		v128_t texels  = wasm_v128_load(p);
+		v128_t matches = wasm_i32x4_eq(wasm_v128_and(texels, mask), keys);
+		wasm_v128_store(p, wasm_v128_andnot(texels, matches));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		Uint8 *p = pixels + i * 4;
+		if (p[0] == ((key >> 0) & 0xFF) && p[1] == ((key >> 8) & 0xFF) && p[2] == ((key >> 16) & 0xFF)) {
+			memset(p, 0, 4);
+		}
+	}
+}
+
+void premultiply_alpha(Uint8 *pixels, size_t count) {
+	size_t i = 0;
+
+#if defined(IMAGE_PIPELINE_SSE2)
+	// alpha is multiplied by 255 so it comes out unchanged
+	const __m128i zero      = _mm_setzero_si128();
+	const __m128i rgb_mask  = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i alpha_255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	const __m128i half      = _mm_set1_epi16(128);
+
+	auto multiply = [&](__m128i texels) {
+		__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(texels, 0xFF), 0xFF);
+		alpha         = _mm_or_si128(_mm_and_si128(alpha, rgb_mask), alpha_255);
+		__m128i t     = _mm_add_epi16(_mm_mullo_epi16(texels, alpha), half);
+		return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+	};
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i *p      = (__m128i *)(pixels + i * 4);
+		__m128i  texels = _mm_loadu_si128(p);
+		__m128i  low    = multiply(_mm_unpacklo_epi8(texels, zero));
+		__m128i  high   = multiply(_mm_unpackhi_epi8(texels, zero));
+		_mm_storeu_si128(p, _mm_packus_epi16(low, high));
+	}
+#elif defined(IMAGE_PIPELINE_WASM_SIMD)
+	const v128_t rgb_mask  = wasm_i16x8_make(-1, -1, -1, 0, -1, -1, -1, 0);
+	const v128_t alpha_255 = wasm_i16x8_make(0, 0, 0, 255, 0, 0, 0, 255);
+	const v128_t half      = wasm_i16x8_splat(128);
+
+	auto multiply = [&](v128_t texels) {
+		v128_t alpha = wasm_i16x8_shuffle(texels, texels, 3, 3, 3, 3, 7, 7, 7, 7);
+		alpha        = wasm_v128_or(wasm_v128_and(alpha, rgb_mask), alpha_255);
+		v128_t t     = wasm_i16x8_add(wasm_i16x8_mul(texels, alpha), half);
+		return wasm_u16x8_shr(wasm_i16x8_add(t, wasm_u16x8_shr(t, 8)), 8);
+	};
+
+	for (; i + 4 <= count; i += 4) {
+		Uint8 *p      = pixels + i * 4;
+		v128_t texels = wasm_v128_load(p);
+		v128_t low    = multiply(wasm_u16x8_extend_low_u8x16(texels));
+		v128_t high   = multiply(wasm_u16x8_extend_high_u8x16(texels));
+		wasm_v128_store(p, wasm_u8x16_narrow_i16x8(low, high));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		Uint8 *p = pixels + i * 4;
+		p[0]     = multiply_255(p[0], p[3]);
+		p[1]     = multiply_255(p[1], p[3]);
+		p[2]     = multiply_255(p[2], p[3]);
+	}
+}
+
+void clear_transparent(Uint8 *pixels, size_t count) {
+	// the color under alpha 0 would bleed into the neighbours when filtered or packed
+	size_t i = 0;
+
+#if defined(IMAGE_PIPELINE_SSE2)
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	const __m128i zero  = _mm_setzero_si128();
+	for (; i + 4 <= count; i += 4) {
+		__m128i *p           = (__m128i *)(pixels + i * 4);
+		__m128i  texels      = _mm_loadu_si128(p);
+		__m128i  transparent = _mm_cmpeq_epi32(_mm_and_si128(texels, alpha), zero);
+		_mm_storeu_si128(p, _mm_andnot_si128(transparent, texels));
+	}
+#elif defined(IMAGE_PIPELINE_WASM_SIMD)
+	const v128_t alpha = wasm_i32x4_splat((int)0xFF000000);
+	for (; i + 4 <= count; i += 4) {
+		Uint8 *p           = pixels + i * 4;
+		v128_t texels      = wasm_v128_load(p);
+		v128_t transparent = wasm_i32x4_eq(wasm_v128_and(texels, alpha), wasm_i32x4_splat(0));
+		wasm_v128_store(p, wasm_v128_andnot(texels, transparent));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		Uint8 *p = pixels + i * 4;
+		if (p[3] == 0) memset(p, 0, 4);
+	}
+}
+
+void swap_red_blue(const Uint8 *src, Uint8 *dst, size_t count) {
+	size_t i = 0;
+
+#if defined(IMAGE_PIPELINE_SSE2)
+	const __m128i green_alpha = _mm_set1_epi32((int)0xFF00FF00);
+	const __m128i red_blue    = _mm_set1_epi32(0x00FF00FF);
+	for (; i + 4 <= count; i += 4) {
+		__m128i texels  = _mm_loadu_si128((const __m128i *)(src + i * 4));
+		__m128i rb      = _mm_and_si128(texels, red_blue);
+		__m128i swapped = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+		_mm_storeu_si128((__m128i *)(dst + i * 4), _mm_or_si128(_mm_and_si128(texels, green_alpha), swapped));
+	}
+#elif defined(IMAGE_PIPELINE_WASM_SIMD)
+	for (; i + 4 <= count; i += 4) {
+		v128_t texels = wasm_v128_load(src + i * 4);
+		wasm_v128_store(dst + i * 4,
+		                wasm_i8x16_shuffle(texels, texels, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15));
+	}
+#endif
+
+	for (; i < count; ++i) {
+		const Uint8 *s = src + i * 4;
+		Uint8       *d = dst + i * 4;
+		Uint8        r = s[0];
+		d[0]           = s[2];
+		d[1]           = s[1];
+		d[2]           = r;
+		d[3]           = s[3];
+	}
+}
+
+bool has_opaque_texel(const Uint8 *pixels, size_t count) {
+	size_t i = 0;
+
+#if defined(IMAGE_PIPELINE_SSE2)
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	const __m128i zero  = _mm_setzero_si128();
+	for (; i + 4 <= count; i += 4) {
+		__m128i texels = _mm_and_si128(_mm_loadu_si128((const __m128i *)(pixels + i * 4)), alpha);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(texels, zero)) != 0xFFFF) return true;
+	}
+#elif defined(IMAGE_PIPELINE_WASM_SIMD)
+	const v128_t alpha = wasm_i32x4_splat((int)0xFF000000);
+	for (; i + 4 <= count; i += 4) {
+		if (wasm_v128_any_true(wasm_v128_and(wasm_v128_load(pixels + i * 4), alpha))) return true;
+	}
+#endif
+
+	for (; i < count; ++i) {
+		if (pixels[i * 4 + 3] != 0) return true;
+	}
+	return false;
+}
+
+void apply_color_swaps(Uint8 *pixels, size_t count, const std::vector<ColorSwap> &swaps) {
+	// every swap looks at the original color, so "a b" and "b a" exchange them
+	std::vector<Uint32> from(swaps.size()), to(swaps.size());
+	for (size_t s = 0; s < swaps.size(); ++s) {
+		from[s] = ((swaps[s].from >> 16) & 0xFF) | (swaps[s].from & 0xFF00) | ((swaps[s].from & 0xFF) << 16);
+		to[s]   = ((swaps[s].to >> 16) & 0xFF) | (swaps[s].to & 0xFF00) | ((swaps[s].to & 0xFF) << 16);
+	}
+
+	size_t i = 0;
+
+#if defined(IMAGE_PIPELINE_SSE2)
+	const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+	for (; i + 4 <= count; i += 4) {
+		__m128i *p      = (__m128i *)(pixels + i * 4);
+		__m128i  texels = _mm_loadu_si128(p);
+		__m128i  rgb    = _mm_and_si128(texels, rgb_mask);
+		__m128i  alpha  = _mm_andnot_si128(rgb_mask, texels);
+		__m128i  result = texels;
+		for (size_t s = 0; s < from.size(); ++s) {
+			__m128i matches = _mm_cmpeq_epi32(rgb, _mm_set1_epi32((int)from[s]));
+			__m128i swapped = _mm_or_si128(alpha, _mm_set1_epi32((int)to[s]));
+			result          = _mm_or_si128(_mm_andnot_si128(matches, result), _mm_and_si128(matches, swapped));
+		}
+		_mm_storeu_si128(p, result);
+	}
+#elif defined(IMAGE_PIPELINE_WASM_SIMD)
+	const v128_t rgb_mask = wasm_i32x4_splat(0x00FFFFFF);
+	for (; i + 4 <= count; i += 4) {
+		Uint8 *p      = pixels + i * 4;
+		v128_t texels = wasm_v128_load(p);
+		v128_t rgb    = wasm_v128_and(texels, rgb_mask);
+		v128_t alpha  = wasm_v128_andnot(texels, rgb_mask);
+		v128_t result = texels;
+		for (size_t s = 0; s < from.size(); ++s) {
+			v128_t matches = wasm_i32x4_eq(rgb, wasm_i32x4_splat((int)from[s]));
+			result         = wasm_v128_bitselect(wasm_v128_or(alpha, wasm_i32x4_splat((int)to[s])), result, matches);
+		}
+		wasm_v128_store(p, result);
+	}
+#endif
+
+	for (; i < count; ++i) {
+		Uint32 texel;
+		memcpy(&texel, pixels + i * 4, 4);
+		for (size_t s = 0; s < from.size(); ++s) {
+			if ((texel & 0x00FFFFFF) != from[s]) continue;
+
+			Uint32 swapped = (texel & 0xFF000000) | to[s];
+			memcpy(pixels + i * 4, &swapped, 4);
+		}
+	}
+}
+
+bool find_opaque_bounds(const SDL_Surface *surface, const SDL_Rect &area, SDL_Rect &bounds) {
+	SDL_Rect sheet = {0, 0, surface->w, surface->h};
+	SDL_Rect clip;
+	if (!SDL_IntersectRect(&area, &sheet, &clip)) return false;
+
+	auto row = [&](int y) { return (const Uint8 *)surface->pixels + y * surface->pitch + clip.x * 4; };
+
+	int top = clip.y;
+	while (top < clip.y + clip.h && !has_opaque_texel(row(top), clip.w)) ++top;
+	if (top == clip.y + clip.h) return false;
+
+	int bottom = clip.y + clip.h - 1;
+	while (bottom > top && !has_opaque_texel(row(bottom), clip.w)) --bottom;
+
+	// columns only need to be searched outside of what is already known to be opaque
+	int left  = clip.w;
+	int right = -1;
+	for (int y = top; y <= bottom; ++y) {
+		const Uint8 *pixels = row(y);
+		for (int x = 0; x < left; ++x) {
+			if (pixels[x * 4 + 3] != 0) {
+				left = x;
+				break;
+			}
+		}
+		for (int x = clip.w - 1; x > right; --x) {
+			if (pixels[x * 4 + 3] != 0) {
+				right = x;
+				break;
+			}
+		}
+	}
+
+	bounds = {clip.x + left, top, right - left + 1, bottom - top + 1};
+	return true;
+}
+
+Uint64 hash_texels(const SDL_Surface *surface, const SDL_Rect &area, bool mirrored) {
+	// FNV-1a over whole texels
+	Uint64 hash = 0xCBF29CE484222325ull;
+	for (int y = area.y; y < area.y + area.h; ++y) {
+		for (int i = 0; i < area.w; ++i) {
+			int x = mirrored ? area.x + area.w - 1 - i : area.x + i;
+			hash  = (hash ^ texel_at(surface, x, y)) * 0x100000001B3ull;
+		}
+	}
+	return hash;
+}
+
+bool same_texels(const SDL_Surface *surface_a,
+                 const SDL_Rect    &area_a,
+                 const SDL_Surface *surface_b,
+                 const SDL_Rect    &area_b,
+                 bool               mirrored) {
+	if (area_a.w != area_b.w || area_a.h != area_b.h) return false;
+
+	for (int y = 0; y < area_a.h; ++y) {
+		for (int x = 0; x < area_a.w; ++x) {
+			int x_b = mirrored ? area_b.x + area_b.w - 1 - x : area_b.x + x;
+			if (texel_at(surface_a, area_a.x + x, area_a.y + y) != texel_at(surface_b, x_b, area_b.y + y)) return false;
+		}
+	}
+	return true;
+}
+
+SDL_Surface *convert_image_format(SDL_Surface *surface, Uint32 format) {
+	Uint32 source  = surface->format->format;
+	bool   swizzle = (source == SDL_PIXELFORMAT_RGBA32 && format == SDL_PIXELFORMAT_BGRA32) ||
+	                 (source == SDL_PIXELFORMAT_BGRA32 && format == SDL_PIXELFORMAT_RGBA32);
+	if (!swizzle) return SDL_ConvertSurfaceFormat(surface, format, 0);
+
+	SDL_Surface *converted = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h, 32, format);
+	if (converted == nullptr) return nullptr;
+
+	for (int y = 0; y < surface->h; ++y) {
+		swap_red_blue((const Uint8 *)surface->pixels + y * surface->pitch,
+		              (Uint8 *)converted->pixels + y * converted->pitch,
+		              (size_t)surface->w);
+	}
+	return converted;
+}
+
+SDL_Surface *process_image(SDL_Surface *surface, const ImageOptions &options, Uint32 format) {
+	if (surface == nullptr) return nullptr;
+
+	// the kernels need RGBA32
+	if (surface->format->format != SDL_PIXELFORMAT_RGBA32) {
+		SDL_Surface *converted = convert_image_format(surface, SDL_PIXELFORMAT_RGBA32);
+		SDL_FreeSurface(surface);
+		if (converted == nullptr) return nullptr;
+		surface = converted;
+	}
+
+	if (options.color_key >= 0) {
+		for_each_row(surface, [&](Uint8 *pixels, size_t count) { color_key_to_alpha(pixels, count, options.color_key); });
+	}
+
+	// premultiplying clears them too
+	if (options.premultiply) {
+		for_each_row(surface, [](Uint8 *pixels, size_t count) { premultiply_alpha(pixels, count); });
+	} else {
+		for_each_row(surface, [](Uint8 *pixels, size_t count) { clear_transparent(pixels, count); });
+	}
+
+	if (format == SDL_PIXELFORMAT_RGBA32) return surface;
+
+	SDL_Surface *converted = convert_image_format(surface, format);
+	SDL_FreeSurface(surface);
+	return converted;
+}
@@ -0,0 +1,101 @@
+#ifndef IMAGE_PIPELINE_H
+#define IMAGE_PIPELINE_H
+
+#pragma once
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+/**
+ * Processing applied to decoded images before they are uploaded, by the
+ * asset packer when cooking and by the game when it decodes an image itself.
+ *
+ * The kernels work on RGBA32 pixels, rows of w pixels, and use SSE2 or wasm
+ * simd128 when the target has them, with a scalar loop for the remainder.
+ */
+
+struct ImageOptions {
+	Sint32 color_key   = -1; // 0xRRGGBB made transparent, negative for none
+	bool   premultiply = false;
+	Uint32 tile_size   = 0; // cooked as tiles of this size, 0 for a single image
+	bool   indexed     = false; // cooked as palette indices
+
+	std::vector<std::string> palettes; // variants cooked next to the colors of the image
+};
+
+/**
+ * Color replaced in a palette variant, both 0xRRGGBB
+ */
+struct ColorSwap {
+	Uint32 from;
+	Uint32 to;
+};
+
+/**
+ * Reads one manifest option ("key=ff00ff", "premultiply", "tiles=128",
+ * "indexed", "palettes=shiny,alt")
+ * @return false if the option is unknown or its value is malformed
+ */
+bool parse_image_option(const std::string &token, ImageOptions &options);
+
+/**
+ * Applies the options to a decoded image and converts it to format
+ * @return the processed surface, the input is freed if a new one was needed
+ */
+SDL_Surface *process_image(SDL_Surface *surface, const ImageOptions &options, Uint32 format = SDL_PIXELFORMAT_RGBA32);
+
+/**
+ * Converts between RGBA32 and BGRA32 with a byte swizzle, any other pair
+ * goes through SDL_ConvertSurfaceFormat
+ * @return a new surface, the input is left untouched
+ */
+SDL_Surface *convert_image_format(SDL_Surface *surface, Uint32 format);
+
+/**
+ * Splits an RGBA32 image in one palette index per texel and its colors
+ * @return false if the image has more than 256 colors
+ */
+bool index_image(const SDL_Surface *surface, std::vector<Uint8> &indices, std::vector<Uint32> &palette);
+
+/**
+ * Where the color swaps of a variant live, "images/a.png" + "shiny" gives
+ * "images/a.shiny.pal"
+ */
+std::string get_palette_path(const std::string &image_path, const std::string &variant);
+
+/**
+ * Reads a palette file, one "RRGGBB RRGGBB" swap per line, '#' starts a comment
+ */
+bool parse_color_swaps(const std::string &text, std::vector<ColorSwap> &swaps);
+
+/**
+ * Smallest rectangle of area holding a texel that is not fully transparent
+ * @return false if the whole area is transparent
+ */
+bool find_opaque_bounds(const SDL_Surface *surface, const SDL_Rect &area, SDL_Rect &bounds);
+
+/**
+ * Hash of the texels of area, fully transparent texels all count as one
+ * @param mirrored Hash the area as if it was flipped horizontally
+ */
+Uint64 hash_texels(const SDL_Surface *surface, const SDL_Rect &area, bool mirrored = false);
+
+/**
+ * @return true if area_b holds the same texels as area_a, or its mirror image
+ */
+bool same_texels(const SDL_Surface *surface_a,
+                 const SDL_Rect    &area_a,
+                 const SDL_Surface *surface_b,
+                 const SDL_Rect    &area_b,
+                 bool               mirrored = false);
+
+// kernels, count pixels in place
+void color_key_to_alpha(Uint8 *pixels, size_t count, Uint32 rgb);
+void premultiply_alpha(Uint8 *pixels, size_t count);
+void clear_transparent(Uint8 *pixels, size_t count);
+void swap_red_blue(const Uint8 *src, Uint8 *dst, size_t count);
+bool has_opaque_texel(const Uint8 *pixels, size_t count);
+void apply_color_swaps(Uint8 *pixels, size_t count, const std::vector<ColorSwap> &swaps);
+
+#endif
@@ -28,4 +28,40 @@
 #define FPS               60
 #define FRAME_TARGET_TIME (1000 / FPS)
 
-#define MAX_ENTITIES 1024
\ No newline at end of file
+#define MAX_ENTITIES 1024
+
+#define INPUT_QUEUE_CAPACITY  256 // events between two frames, more are dropped
+#define INPUT_LATENCY_SAMPLES 512
+
+#define STATS_CAPACITY    64
+#define STATS_LABEL_SIZE  48
+#define STATS_BUFFER_SIZE 4096
+
+#define ATLAS_PAGE_SIZE 2048
+#define ATLAS_PADDING   1
+#define ATLAS_MAX_PAGES 4
+
+#define ASSET_UPLOAD_BUDGET_MS 4.0
+#define ASSET_UPLOAD_ROWS      128
+
+#define TEXTURE_BUDGET_BYTES (64 * 1024 * 1024)
+
+#define ASSET_ROOT         "../src/assets/"
+#define ASSET_ARCHIVE_PATH "assets.pak"
+#define ZOO_MAP_PATH       ASSET_ROOT "tiled/zoo.tmx"
+#define POKEMON_SHEET_PATH ASSET_ROOT "images/spritesheets/pokemons/pokemons_4th_gen.png"
+#define POKEMON_SHINY_ODDS 8 // one pokemon in N is shiny
+
+#define POKEMON_WALK_SPEED   40.0f // pixels per second
+#define POKEMON_WANDER_RANGE 12    // tiles from where a pokemon stands to where it walks
+#define POKEMON_WANDER_STEP  4     // wander goals are the tiles of this lattice
+#define POKEMON_WANDER_PAUSE 2.0f  // seconds, on average, between two walks
+
+#define MAP_COLLIDER_GROUP  "Colliders"  // object layer of the colliders that are not tiles
+#define MAP_ENCLOSURE_GROUP "Enclosures" // object layer of the areas raising enter and exit events
+
+#define PATH_CACHE_SIZE 1024 // paths kept by start and goal tiles
+#define PATH_BATCH_SIZE 32   // searches per thread pool job
+#define PATH_BUDGET_MS  2.0  // searches run by the main thread per frame when there is no worker
+
+#define FLOW_FIELD_CACHE_SIZE 8 // goals whose flow field is kept
\ No newline at end of file
@@ -1,68 +1,409 @@
 #include "input_handler.h"
 
-void InputHandler::update_key_states() {
-	auto& key_states = get()._key_states;
-
-	for (auto& [code, state] : key_states) {
-		switch (state) {
-			case InputState::PRESSED:
-				state = InputState::DOWN;
-				break;
-			case InputState::RELEASED:
-				state = InputState::NOT_PRESSED;
-				break;
-			default:
-				break;
+namespace {
+	struct KeyName {
+		SDL_Scancode code;
+		const char*  name;
+	};
+
+	// clang-format off
+	constexpr KeyName KEY_NAMES[] = {
+		{SDL_SCANCODE_A,                  "a"},
+		{SDL_SCANCODE_B,                  "b"},
+		{SDL_SCANCODE_C,                  "c"},
+		{SDL_SCANCODE_D,                  "d"},
+		{SDL_SCANCODE_E,                  "e"},
+		{SDL_SCANCODE_F,                  "f"},
+		{SDL_SCANCODE_G,                  "g"},
+		{SDL_SCANCODE_H,                  "h"},
+		{SDL_SCANCODE_I,                  "i"},
+		{SDL_SCANCODE_J,                  "j"},
+		{SDL_SCANCODE_K,                  "k"},
+		{SDL_SCANCODE_L,                  "l"},
+		{SDL_SCANCODE_M,                  "m"},
+		{SDL_SCANCODE_N,                  "n"},
+		{SDL_SCANCODE_O,                  "o"},
+		{SDL_SCANCODE_P,                  "p"},
+		{SDL_SCANCODE_Q,                  "q"},
+		{SDL_SCANCODE_R,                  "r"},
+		{SDL_SCANCODE_S,                  "s"},
+		{SDL_SCANCODE_T,                  "t"},
+		{SDL_SCANCODE_U,                  "u"},
+		{SDL_SCANCODE_V,                  "v"},
+		{SDL_SCANCODE_W,                  "w"},
+		{SDL_SCANCODE_X,                  "x"},
+		{SDL_SCANCODE_Y,                  "y"},
+		{SDL_SCANCODE_Z,                  "z"},
+		{SDL_SCANCODE_1,                  "1"},
+		{SDL_SCANCODE_2,                  "2"},
+		{SDL_SCANCODE_3,                  "3"},
+		{SDL_SCANCODE_4,                  "4"},
+		{SDL_SCANCODE_5,                  "5"},
+		{SDL_SCANCODE_6,                  "6"},
+		{SDL_SCANCODE_7,                  "7"},
+		{SDL_SCANCODE_8,                  "8"},
+		{SDL_SCANCODE_9,                  "9"},
+		{SDL_SCANCODE_0,                  "0"},
+		{SDL_SCANCODE_RETURN,             "RETURN"},
+		{SDL_SCANCODE_ESCAPE,             "ESCAPE"},
+		{SDL_SCANCODE_BACKSPACE,          "BACKSPACE"},
+		{SDL_SCANCODE_TAB,                "TAB"},
+		{SDL_SCANCODE_SPACE,              "SPACE"},
+		{SDL_SCANCODE_MINUS,              "MINUS"},
+		{SDL_SCANCODE_EQUALS,             "EQUALS"},
+		{SDL_SCANCODE_LEFTBRACKET,        "LEFTBRACKET"},
+		{SDL_SCANCODE_RIGHTBRACKET,       "RIGHTBRACKET"},
+		{SDL_SCANCODE_BACKSLASH,          "BACKSLASH"},
+		{SDL_SCANCODE_NONUSHASH,          "NONUSHASH"},
+		{SDL_SCANCODE_SEMICOLON,          "SEMICOLON"},
+		{SDL_SCANCODE_APOSTROPHE,         "APOSTROPHE"},
+		{SDL_SCANCODE_GRAVE,              "GRAVE"},
+		{SDL_SCANCODE_COMMA,              "COMMA"},
+		{SDL_SCANCODE_PERIOD,             "PERIOD"},
+		{SDL_SCANCODE_SLASH,              "SLASH"},
+		{SDL_SCANCODE_CAPSLOCK,           "CAPSLOCK"},
+		{SDL_SCANCODE_F1,                 "F1"},
+		{SDL_SCANCODE_F2,                 "F2"},
+		{SDL_SCANCODE_F3,                 "F3"},
+		{SDL_SCANCODE_F4,                 "F4"},
+		{SDL_SCANCODE_F5,                 "F5"},
+		{SDL_SCANCODE_F6,                 "F6"},
+		{SDL_SCANCODE_F7,                 "F7"},
+		{SDL_SCANCODE_F8,                 "F8"},
+		{SDL_SCANCODE_F9,                 "F9"},
+		{SDL_SCANCODE_F10,                "F10"},
+		{SDL_SCANCODE_F11,                "F11"},
+		{SDL_SCANCODE_F12,                "F12"},
+		{SDL_SCANCODE_PRINTSCREEN,        "PRINTSCREEN"},
+		{SDL_SCANCODE_SCROLLLOCK,         "SCROLLLOCK"},
+		{SDL_SCANCODE_PAUSE,              "PAUSE"},
+		{SDL_SCANCODE_INSERT,             "INSERT"},
+		{SDL_SCANCODE_HOME,               "HOME"},
+		{SDL_SCANCODE_PAGEUP,             "PAGEUP"},
+		{SDL_SCANCODE_DELETE,             "DELETE"},
+		{SDL_SCANCODE_END,                "END"},
+		{SDL_SCANCODE_PAGEDOWN,           "PAGEDOWN"},
+		{SDL_SCANCODE_RIGHT,              "RIGHT"},
+		{SDL_SCANCODE_LEFT,               "LEFT"},
+		{SDL_SCANCODE_DOWN,               "DOWN"},
+		{SDL_SCANCODE_UP,                 "UP"},
+		{SDL_SCANCODE_NUMLOCKCLEAR,       "NUMLOCKCLEAR"},
+		{SDL_SCANCODE_KP_DIVIDE,          "KP_DIVIDE"},
+		{SDL_SCANCODE_KP_MULTIPLY,        "KP_MULTIPLY"},
+		{SDL_SCANCODE_KP_MINUS,           "KP_MINUS"},
+		{SDL_SCANCODE_KP_PLUS,            "KP_PLUS"},
+		{SDL_SCANCODE_KP_ENTER,           "KP_ENTER"},
+		{SDL_SCANCODE_KP_1,               "KP_1"},
+		{SDL_SCANCODE_KP_2,               "KP_2"},
+		{SDL_SCANCODE_KP_3,               "KP_3"},
+		{SDL_SCANCODE_KP_4,               "KP_4"},
+		{SDL_SCANCODE_KP_5,               "KP_5"},
+		{SDL_SCANCODE_KP_6,               "KP_6"},
+		{SDL_SCANCODE_KP_7,               "KP_7"},
+		{SDL_SCANCODE_KP_8,               "KP_8"},
+		{SDL_SCANCODE_KP_9,               "KP_9"},
+		{SDL_SCANCODE_KP_0,               "KP_0"},
+		{SDL_SCANCODE_KP_PERIOD,          "KP_PERIOD"},
+		{SDL_SCANCODE_NONUSBACKSLASH,     "NONUSBACKSLASH"},
+		{SDL_SCANCODE_APPLICATION,        "APPLICATION"},
+		{SDL_SCANCODE_POWER,              "POWER"},
+		{SDL_SCANCODE_KP_EQUALS,          "KP_EQUALS"},
+		{SDL_SCANCODE_F13,                "F13"},
+		{SDL_SCANCODE_F14,                "F14"},
+		{SDL_SCANCODE_F15,                "F15"},
+		{SDL_SCANCODE_F16,                "F16"},
+		{SDL_SCANCODE_F17,                "F17"},
+		{SDL_SCANCODE_F18,                "F18"},
+		{SDL_SCANCODE_F19,                "F19"},
+		{SDL_SCANCODE_F20,                "F20"},
+		{SDL_SCANCODE_F21,                "F21"},
+		{SDL_SCANCODE_F22,                "F22"},
+		{SDL_SCANCODE_F23,                "F23"},
+		{SDL_SCANCODE_F24,                "F24"},
+		{SDL_SCANCODE_EXECUTE,            "EXECUTE"},
+		{SDL_SCANCODE_HELP,               "HELP"},
+		{SDL_SCANCODE_MENU,               "MENU"},
+		{SDL_SCANCODE_SELECT,             "SELECT"},
+		{SDL_SCANCODE_STOP,               "STOP"},
+		{SDL_SCANCODE_AGAIN,              "AGAIN"},
+		{SDL_SCANCODE_UNDO,               "UNDO"},
+		{SDL_SCANCODE_CUT,                "CUT"},
+		{SDL_SCANCODE_COPY,               "COPY"},
+		{SDL_SCANCODE_PASTE,              "PASTE"},
+		{SDL_SCANCODE_FIND,               "FIND"},
+		{SDL_SCANCODE_MUTE,               "MUTE"},
+		{SDL_SCANCODE_VOLUMEUP,           "VOLUMEUP"},
+		{SDL_SCANCODE_VOLUMEDOWN,         "VOLUMEDOWN"},
+		{SDL_SCANCODE_KP_COMMA,           "KP_COMMA"},
+		{SDL_SCANCODE_KP_EQUALSAS400,     "KP_EQUALSAS400"},
+		{SDL_SCANCODE_ALTERASE,           "ALTERASE"},
+		{SDL_SCANCODE_SYSREQ,             "SYSREQ"},
+		{SDL_SCANCODE_CANCEL,             "CANCEL"},
+		{SDL_SCANCODE_CLEAR,              "CLEAR"},
+		{SDL_SCANCODE_PRIOR,              "PRIOR"},
+		{SDL_SCANCODE_RETURN2,            "RETURN2"},
+		{SDL_SCANCODE_SEPARATOR,          "SEPARATOR"},
+		{SDL_SCANCODE_OUT,                "OUT"},
+		{SDL_SCANCODE_OPER,               "OPER"},
+		{SDL_SCANCODE_CLEARAGAIN,         "CLEARAGAIN"},
+		{SDL_SCANCODE_CRSEL,              "CRSEL"},
+		{SDL_SCANCODE_EXSEL,              "EXSEL"},
+		{SDL_SCANCODE_KP_00,              "KP_00"},
+		{SDL_SCANCODE_KP_000,             "KP_000"},
+		{SDL_SCANCODE_THOUSANDSSEPARATOR, "THOUSANDSSEPARATOR"},
+		{SDL_SCANCODE_DECIMALSEPARATOR,   "DECIMALSEPARATOR"},
+		{SDL_SCANCODE_CURRENCYUNIT,       "CURRENCYUNIT"},
+		{SDL_SCANCODE_CURRENCYSUBUNIT,    "CURRENCYSUBUNIT"},
+		{SDL_SCANCODE_KP_LEFTPAREN,       "KP_LEFTPAREN"},
+		{SDL_SCANCODE_KP_RIGHTPAREN,      "KP_RIGHTPAREN"},
+		{SDL_SCANCODE_KP_LEFTBRACE,       "KP_LEFTBRACE"},
+		{SDL_SCANCODE_KP_RIGHTBRACE,      "KP_RIGHTBRACE"},
+		{SDL_SCANCODE_KP_TAB,             "KP_TAB"},
+		{SDL_SCANCODE_KP_BACKSPACE,       "KP_BACKSPACE"},
+		{SDL_SCANCODE_KP_A,               "KP_A"},
+		{SDL_SCANCODE_KP_B,               "KP_B"},
+		{SDL_SCANCODE_KP_C,               "KP_C"},
+		{SDL_SCANCODE_KP_D,               "KP_D"},
+		{SDL_SCANCODE_KP_E,               "KP_E"},
+		{SDL_SCANCODE_KP_F,               "KP_F"},
+		{SDL_SCANCODE_KP_XOR,             "KP_XOR"},
+		{SDL_SCANCODE_KP_POWER,           "KP_POWER"},
+		{SDL_SCANCODE_KP_PERCENT,         "KP_PERCENT"},
+		{SDL_SCANCODE_KP_LESS,            "KP_LESS"},
+		{SDL_SCANCODE_KP_GREATER,         "KP_GREATER"},
+		{SDL_SCANCODE_KP_AMPERSAND,       "KP_AMPERSAND"},
+		{SDL_SCANCODE_KP_DBLAMPERSAND,    "KP_DBLAMPERSAND"},
+		{SDL_SCANCODE_KP_VERTICALBAR,     "KP_VERTICALBAR"},
+		{SDL_SCANCODE_KP_DBLVERTICALBAR,  "KP_DBLVERTICALBAR"},
+		{SDL_SCANCODE_KP_COLON,           "KP_COLON"},
+		{SDL_SCANCODE_KP_HASH,            "KP_HASH"},
+		{SDL_SCANCODE_KP_SPACE,           "KP_SPACE"},
+		{SDL_SCANCODE_KP_AT,              "KP_AT"},
+		{SDL_SCANCODE_KP_EXCLAM,          "KP_EXCLAM"},
+		{SDL_SCANCODE_KP_MEMSTORE,        "KP_MEMSTORE"},
+		{SDL_SCANCODE_KP_MEMRECALL,       "KP_MEMRECALL"},
+		{SDL_SCANCODE_KP_MEMCLEAR,        "KP_MEMCLEAR"},
+		{SDL_SCANCODE_KP_MEMADD,          "KP_MEMADD"},
+		{SDL_SCANCODE_KP_MEMSUBTRACT,     "KP_MEMSUBTRACT"},
+		{SDL_SCANCODE_KP_MEMMULTIPLY,     "KP_MEMMULTIPLY"},
+		{SDL_SCANCODE_KP_MEMDIVIDE,       "KP_MEMDIVIDE"},
+		{SDL_SCANCODE_KP_PLUSMINUS,       "KP_PLUSMINUS"},
+		{SDL_SCANCODE_KP_CLEAR,           "KP_CLEAR"},
+		{SDL_SCANCODE_KP_CLEARENTRY,      "KP_CLEARENTRY"},
+		{SDL_SCANCODE_KP_BINARY,          "KP_BINARY"},
+		{SDL_SCANCODE_KP_OCTAL,           "KP_OCTAL"},
+		{SDL_SCANCODE_KP_DECIMAL,         "KP_DECIMAL"},
+		{SDL_SCANCODE_KP_HEXADECIMAL,     "KP_HEXADECIMAL"},
+		{SDL_SCANCODE_LCTRL,              "LCTRL"},
+		{SDL_SCANCODE_LSHIFT,             "LSHIFT"},
+		{SDL_SCANCODE_LALT,               "LALT"},
+		{SDL_SCANCODE_LGUI,               "LGUI"},
+		{SDL_SCANCODE_RCTRL,              "RCTRL"},
+		{SDL_SCANCODE_RSHIFT,             "RSHIFT"},
+		{SDL_SCANCODE_RALT,               "RALT"},
+		{SDL_SCANCODE_RGUI,               "RGUI"},
+		{SDL_SCANCODE_MODE,               "MODE"},
+		{SDL_SCANCODE_AUDIONEXT,          "AUDIONEXT"},
+		{SDL_SCANCODE_AUDIOPREV,          "AUDIOPREV"},
+		{SDL_SCANCODE_AUDIOSTOP,          "AUDIOSTOP"},
+		{SDL_SCANCODE_AUDIOPLAY,          "AUDIOPLAY"},
+		{SDL_SCANCODE_AUDIOMUTE,          "AUDIOMUTE"},
+		{SDL_SCANCODE_MEDIASELECT,        "MEDIASELECT"},
+		{SDL_SCANCODE_WWW,                "WWW"},
+		{SDL_SCANCODE_MAIL,               "MAIL"},
+		{SDL_SCANCODE_CALCULATOR,         "CALCULATOR"},
+		{SDL_SCANCODE_COMPUTER,           "COMPUTER"},
+		{SDL_SCANCODE_AC_SEARCH,          "AC_SEARCH"},
+		{SDL_SCANCODE_AC_HOME,            "AC_HOME"},
+		{SDL_SCANCODE_AC_BACK,            "AC_BACK"},
+		{SDL_SCANCODE_AC_FORWARD,         "AC_FORWARD"},
+		{SDL_SCANCODE_AC_STOP,            "AC_STOP"},
+		{SDL_SCANCODE_AC_REFRESH,         "AC_REFRESH"},
+		{SDL_SCANCODE_AC_BOOKMARKS,       "AC_BOOKMARKS"},
+		{SDL_SCANCODE_BRIGHTNESSDOWN,     "BRIGHTNESSDOWN"},
+		{SDL_SCANCODE_BRIGHTNESSUP,       "BRIGHTNESSUP"},
+		{SDL_SCANCODE_DISPLAYSWITCH,      "DISPLAYSWITCH"},
+		{SDL_SCANCODE_KBDILLUMTOGGLE,     "KBDILLUMTOGGLE"},
+		{SDL_SCANCODE_KBDILLUMDOWN,       "KBDILLUMDOWN"},
+		{SDL_SCANCODE_KBDILLUMUP,         "KBDILLUMUP"},
+		{SDL_SCANCODE_EJECT,              "EJECT"},
+		{SDL_SCANCODE_SLEEP,              "SLEEP"},
+		{SDL_SCANCODE_APP1,               "APP1"},
+		{SDL_SCANCODE_APP2,               "APP2"},
+		{SDL_SCANCODE_AUDIOREWIND,        "AUDIOREWIND"},
+		{SDL_SCANCODE_AUDIOFASTFORWARD,   "AUDIOFASTFORWARD"},
+		{SDL_SCANCODE_SOFTLEFT,           "SOFTLEFT"},
+		{SDL_SCANCODE_SOFTRIGHT,          "SOFTRIGHT"},
+		{SDL_SCANCODE_CALL,               "CALL"},
+		{SDL_SCANCODE_ENDCALL,            "ENDCALL"},
+	};
+	// clang-format on
+
+	constexpr std::array<const char*, SDL_NUM_SCANCODES> make_scancode_names() {
+		std::array<const char*, SDL_NUM_SCANCODES> names = {};
+		for (const KeyName& key : KEY_NAMES) {
+			names[key.code] = key.name;
 		}
+		return names;
 	}
 
+	// built at compile time, indexed by scancode, nullptr for unnamed keys
+	constexpr std::array<const char*, SDL_NUM_SCANCODES> SCANCODE_NAMES = make_scancode_names();
+} // namespace
+
+InputHandler::InputHandler() {
+	// not through bind_action(), get() is still constructing this instance
+	auto bind = [this](InputAction action, SDL_Scancode code) { _bindings[(size_t)action].set(code); };
+
+	bind(InputAction::MOVE_UP, SDL_SCANCODE_W);
+	bind(InputAction::MOVE_UP, SDL_SCANCODE_UP);
+	bind(InputAction::MOVE_DOWN, SDL_SCANCODE_S);
+	bind(InputAction::MOVE_DOWN, SDL_SCANCODE_DOWN);
+	bind(InputAction::MOVE_LEFT, SDL_SCANCODE_A);
+	bind(InputAction::MOVE_LEFT, SDL_SCANCODE_LEFT);
+	bind(InputAction::MOVE_RIGHT, SDL_SCANCODE_D);
+	bind(InputAction::MOVE_RIGHT, SDL_SCANCODE_RIGHT);
+	bind(InputAction::RUN, SDL_SCANCODE_LSHIFT);
+
+	_stat_keys        = Stats::add_label("input.keys");
+	_stat_direction_x = Stats::add_gauge("input.direction_x");
+	_stat_direction_y = Stats::add_gauge("input.direction_y");
+	_stat_mouse_x     = Stats::add_counter("input.mouse_x");
+	_stat_mouse_y     = Stats::add_counter("input.mouse_y");
+}
+
+void InputHandler::update_key_states() {
+	auto& input = get();
+
+	if (input._keys != input._previous_keys) input.publish_key_stats();
+
+	// a key hit and released within the frame is both pressed and released
+	input._pressed_keys  = (input._keys & ~input._previous_keys) | input._hit_keys;
+	input._released_keys = (input._previous_keys | input._hit_keys) & ~input._keys;
+	input._previous_keys = input._keys;
+	input._hit_keys.reset();
+
+	uint32_t actions_down     = 0;
+	uint32_t actions_pressed  = 0;
+	uint32_t actions_released = 0;
+	for (size_t i = 0; i < ACTION_COUNT; ++i) {
+		const KeySet& keys = input._bindings[i];
+		uint32_t      bit  = 1u << i;
+
+		if ((input._keys & keys).any()) actions_down |= bit;
+		if ((input._pressed_keys & keys).any()) actions_pressed |= bit;
+		if ((input._released_keys & keys).any()) actions_released |= bit;
+	}
+	input._actions_down     = actions_down;
+	input._actions_pressed  = actions_pressed;
+	input._actions_released = actions_released & ~actions_down; // another bound key is still held
+
 	// update key direction, cannot go diagonally
 	Vector2f desired_direction = Vector2f::zero();
-	if (is_key_down(SDLK_w) || is_key_down(SDLK_UP)) {
+	if (is_action_down(InputAction::MOVE_UP)) {
 		desired_direction.x = 0;
 		desired_direction.y -= 1;
 	}
-	if (is_key_down(SDLK_s) || is_key_down(SDLK_DOWN)) {
+	if (is_action_down(InputAction::MOVE_DOWN)) {
 		desired_direction.x = 0;
 		desired_direction.y += 1;
 	}
-	if (is_key_down(SDLK_a) || is_key_down(SDLK_LEFT)) {
+	if (is_action_down(InputAction::MOVE_LEFT)) {
 		desired_direction.y = 0;
 		desired_direction.x -= 1;
 	}
-	if (is_key_down(SDLK_d) || is_key_down(SDLK_RIGHT)) {
+	if (is_action_down(InputAction::MOVE_RIGHT)) {
 		desired_direction.y = 0;
 		desired_direction.x += 1;
 	}
 	desired_direction    = desired_direction.normalized();
-	get()._key_direction = get()._key_direction.lerp(desired_direction, 0.2f);
-	if (get()._key_direction.magnitude() < 0.1f) {
-		get()._key_direction = Vector2f::zero();
+	input._key_direction = input._key_direction.lerp(desired_direction, 0.2f);
+	if (input._key_direction.magnitude() < 0.1f) {
+		input._key_direction = Vector2f::zero();
 	}
+
+	Stats::set_gauge(input._stat_direction_x, input._key_direction.x);
+	Stats::set_gauge(input._stat_direction_y, input._key_direction.y);
 }
 
-std::map<SDL_Keycode, InputState> InputHandler::get_key_states() {
-	return get()._key_states;
+void InputHandler::publish_key_stats() {
+	char   names[STATS_LABEL_SIZE];
+	size_t length = 0;
+
+	names[0] = '\0';
+	for (size_t code = 0; code < SDL_NUM_SCANCODES && length + 1 < sizeof(names); ++code) {
+		if (!_keys.test(code)) continue;
+
+		int written = snprintf(names + length,
+		                       sizeof(names) - length,
+		                       "%s%s",
+		                       length > 0 ? " " : "",
+		                       scancode_to_string((SDL_Scancode)code));
+		if (written > 0) length = std::min(length + written, sizeof(names) - 1);
+	}
+
+	Stats::set_label(_stat_keys, names);
+}
+
+InputState InputHandler::get_key_state(SDL_Scancode code) {
+	if (is_key_pressed(code)) return InputState::PRESSED;
+	if (is_key_released(code)) return InputState::RELEASED;
+	if (is_key_down(code)) return InputState::DOWN;
+	return InputState::NOT_PRESSED;
 }
 
 Vector2f InputHandler::get_key_direction() {
 	return get()._key_direction;
 }
 
-void InputHandler::set_key_state(const SDL_Keycode& code, InputState new_state) {
-	get()._key_states[code] = new_state;
+void InputHandler::set_key_state(SDL_Scancode code, InputState new_state) {
+	if ((size_t)code >= SDL_NUM_SCANCODES) return;
+
+	auto& input = get();
+	switch (new_state) {
+		case InputState::PRESSED:
+		case InputState::DOWN:
+			input._keys.set(code);
+			input._hit_keys.set(code);
+			break;
+		default:
+			input._keys.reset(code);
+			break;
+	}
+}
+
+bool InputHandler::is_key_pressed(SDL_Scancode code) {
+	return (size_t)code < SDL_NUM_SCANCODES && get()._pressed_keys.test(code);
+}
+
+bool InputHandler::is_key_down(SDL_Scancode code) {
+	return (size_t)code < SDL_NUM_SCANCODES && get()._keys.test(code);
+}
+
+bool InputHandler::is_key_released(SDL_Scancode code) {
+	return (size_t)code < SDL_NUM_SCANCODES && get()._released_keys.test(code);
+}
+
+void InputHandler::bind_action(InputAction action, SDL_Scancode code) {
+	if (action == InputAction::COUNT || (size_t)code >= SDL_NUM_SCANCODES) return;
+	get()._bindings[(size_t)action].set(code);
+}
+
+void InputHandler::unbind_action(InputAction action) {
+	if (action == InputAction::COUNT) return;
+	get()._bindings[(size_t)action].reset();
 }
 
-bool InputHandler::is_key_pressed(const SDL_Keycode& code) {
-	return get()._key_states[code] == InputState::PRESSED;
+bool InputHandler::is_action_pressed(InputAction action) {
+	return get()._actions_pressed & action_bit(action);
 }
 
-bool InputHandler::is_key_down(const SDL_Keycode& code) {
-	return get()._key_states[code] == InputState::DOWN;
+bool InputHandler::is_action_down(InputAction action) {
+	return get()._actions_down & action_bit(action);
 }
 
-bool InputHandler::is_key_released(const SDL_Keycode& code) {
-	return get()._key_states[code] == InputState::RELEASED;
+bool InputHandler::is_action_released(InputAction action) {
+	return get()._actions_released & action_bit(action);
 }
 
 std::string InputHandler::input_state_to_string(InputState state) {
@@ -82,256 +423,9 @@ std::string InputHandler::input_state_to_string(InputState state) {
 	return input_state_map[state];
 }
 
-std::string InputHandler::key_code_to_string(int code) {
-	static std::map<int, std::string> key_code_to_string_map;
-	if (key_code_to_string_map.empty()) {
-		key_code_to_string_map[0]                = "UNKNOWN";
-		key_code_to_string_map['\r']             = "RETURN";
-		key_code_to_string_map['\x1B']           = "ESCAPE";
-		key_code_to_string_map['\b']             = "BACKSPACE";
-		key_code_to_string_map['\t']             = "TAB";
-		key_code_to_string_map[' ']              = "SPACE";
-		key_code_to_string_map['!']              = "EXCLAIM";
-		key_code_to_string_map['"']              = "QUOTEDBL";
-		key_code_to_string_map['#']              = "HASH";
-		key_code_to_string_map['%']              = "PERCENT";
-		key_code_to_string_map['$']              = "DOLLAR";
-		key_code_to_string_map['&']              = "AMPERSAND";
-		key_code_to_string_map['\'']             = "QUOTE";
-		key_code_to_string_map['(']              = "LEFTPAREN";
-		key_code_to_string_map[')']              = "RIGHTPAREN";
-		key_code_to_string_map['*']              = "ASTERISK";
-		key_code_to_string_map['+']              = "PLUS";
-		key_code_to_string_map[',']              = "COMMA";
-		key_code_to_string_map['-']              = "MINUS";
-		key_code_to_string_map['.']              = "PERIOD";
-		key_code_to_string_map['/']              = "SLASH";
-		key_code_to_string_map['0']              = "0";
-		key_code_to_string_map['1']              = "1";
-		key_code_to_string_map['2']              = "2";
-		key_code_to_string_map['3']              = "3";
-		key_code_to_string_map['4']              = "4";
-		key_code_to_string_map['5']              = "5";
-		key_code_to_string_map['6']              = "6";
-		key_code_to_string_map['7']              = "7";
-		key_code_to_string_map['8']              = "8";
-		key_code_to_string_map['9']              = "9";
-		key_code_to_string_map[':']              = "COLON";
-		key_code_to_string_map[';']              = "SEMICOLON";
-		key_code_to_string_map['<']              = "LESS";
-		key_code_to_string_map['=']              = "EQUALS";
-		key_code_to_string_map['>']              = "GREATER";
-		key_code_to_string_map['?']              = "QUESTION";
-		key_code_to_string_map['@']              = "AT";
-		key_code_to_string_map['[']              = "LEFTBRACKET";
-		key_code_to_string_map['\\']             = "BACKSLASH";
-		key_code_to_string_map[']']              = "RIGHTBRACKET";
-		key_code_to_string_map['^']              = "CARET";
-		key_code_to_string_map['_']              = "UNDERSCORE";
-		key_code_to_string_map['`']              = "BACKQUOTE";
-		key_code_to_string_map['a']              = "a";
-		key_code_to_string_map['b']              = "b";
-		key_code_to_string_map['c']              = "c";
-		key_code_to_string_map['d']              = "d";
-		key_code_to_string_map['e']              = "e";
-		key_code_to_string_map['f']              = "f";
-		key_code_to_string_map['g']              = "g";
-		key_code_to_string_map['h']              = "h";
-		key_code_to_string_map['i']              = "i";
-		key_code_to_string_map['j']              = "j";
-		key_code_to_string_map['k']              = "k";
-		key_code_to_string_map['l']              = "l";
-		key_code_to_string_map['m']              = "m";
-		key_code_to_string_map['n']              = "n";
-		key_code_to_string_map['o']              = "o";
-		key_code_to_string_map['p']              = "p";
-		key_code_to_string_map['q']              = "q";
-		key_code_to_string_map['r']              = "r";
-		key_code_to_string_map['s']              = "s";
-		key_code_to_string_map['t']              = "t";
-		key_code_to_string_map['u']              = "u";
-		key_code_to_string_map['v']              = "v";
-		key_code_to_string_map['w']              = "w";
-		key_code_to_string_map['x']              = "x";
-		key_code_to_string_map['y']              = "y";
-		key_code_to_string_map['z']              = "z";
-		key_code_to_string_map[SDLK_CAPSLOCK]    = "CAPSLOCK";
-		key_code_to_string_map[SDLK_F1]          = "F1";
-		key_code_to_string_map[SDLK_F2]          = "F2";
-		key_code_to_string_map[SDLK_F3]          = "F3";
-		key_code_to_string_map[SDLK_F4]          = "F4";
-		key_code_to_string_map[SDLK_F5]          = "F5";
-		key_code_to_string_map[SDLK_F6]          = "F6";
-		key_code_to_string_map[SDLK_F7]          = "F7";
-		key_code_to_string_map[SDLK_F8]          = "F8";
-		key_code_to_string_map[SDLK_F9]          = "F9";
-		key_code_to_string_map[SDLK_F10]         = "F10";
-		key_code_to_string_map[SDLK_F11]         = "F11";
-		key_code_to_string_map[SDLK_F12]         = "F12";
-		key_code_to_string_map[SDLK_PRINTSCREEN] = "PRINTSCREEN";
-		key_code_to_string_map[SDLK_SCROLLLOCK]  = "SCROLLLOCK";
-		key_code_to_string_map[SDLK_PAUSE]       = "PAUSE";
-		key_code_to_string_map[SDLK_INSERT]      = "INSERT";
-		key_code_to_string_map[SDLK_HOME]        = "HOME";
-		key_code_to_string_map[SDLK_PAGEUP]      = "PAGEUP";
-
-		key_code_to_string_map[SDLK_END]                = "END";
-		key_code_to_string_map[SDLK_PAGEDOWN]           = "PAGEDOWN";
-		key_code_to_string_map[SDLK_RIGHT]              = "RIGHT";
-		key_code_to_string_map[SDLK_LEFT]               = "LEFT";
-		key_code_to_string_map[SDLK_DOWN]               = "DOWN";
-		key_code_to_string_map[SDLK_UP]                 = "UP";
-		key_code_to_string_map[SDLK_NUMLOCKCLEAR]       = "NUMLOCKCLEAR";
-		key_code_to_string_map[SDLK_KP_DIVIDE]          = "KP_DIVIDE";
-		key_code_to_string_map[SDLK_KP_MULTIPLY]        = "KP_MULTIPLY";
-		key_code_to_string_map[SDLK_KP_MINUS]           = "KP_MINUS";
-		key_code_to_string_map[SDLK_KP_PLUS]            = "KP_PLUS";
-		key_code_to_string_map[SDLK_KP_ENTER]           = "KP_ENTER";
-		key_code_to_string_map[SDLK_KP_1]               = "KP_1";
-		key_code_to_string_map[SDLK_KP_2]               = "KP_2";
-		key_code_to_string_map[SDLK_KP_3]               = "KP_3";
-		key_code_to_string_map[SDLK_KP_4]               = "KP_4";
-		key_code_to_string_map[SDLK_KP_5]               = "KP_5";
-		key_code_to_string_map[SDLK_KP_6]               = "KP_6";
-		key_code_to_string_map[SDLK_KP_7]               = "KP_7";
-		key_code_to_string_map[SDLK_KP_8]               = "KP_8";
-		key_code_to_string_map[SDLK_KP_9]               = "KP_9";
-		key_code_to_string_map[SDLK_KP_0]               = "KP_0";
-		key_code_to_string_map[SDLK_KP_PERIOD]          = "KP_PERIOD";
-		key_code_to_string_map[SDLK_APPLICATION]        = "APPLICATION";
-		key_code_to_string_map[SDLK_POWER]              = "POWER";
-		key_code_to_string_map[SDLK_KP_EQUALS]          = "KP_EQUALS";
-		key_code_to_string_map[SDLK_F13]                = "F13";
-		key_code_to_string_map[SDLK_F14]                = "F14";
-		key_code_to_string_map[SDLK_F15]                = "F15";
-		key_code_to_string_map[SDLK_F16]                = "F16";
-		key_code_to_string_map[SDLK_F17]                = "F17";
-		key_code_to_string_map[SDLK_F18]                = "F18";
-		key_code_to_string_map[SDLK_F19]                = "F19";
-		key_code_to_string_map[SDLK_F20]                = "F20";
-		key_code_to_string_map[SDLK_F21]                = "F21";
-		key_code_to_string_map[SDLK_F22]                = "F22";
-		key_code_to_string_map[SDLK_F23]                = "F23";
-		key_code_to_string_map[SDLK_F24]                = "F24";
-		key_code_to_string_map[SDLK_EXECUTE]            = "EXECUTE";
-		key_code_to_string_map[SDLK_HELP]               = "HELP";
-		key_code_to_string_map[SDLK_MENU]               = "MENU";
-		key_code_to_string_map[SDLK_SELECT]             = "SELECT";
-		key_code_to_string_map[SDLK_STOP]               = "STOP";
-		key_code_to_string_map[SDLK_AGAIN]              = "AGAIN";
-		key_code_to_string_map[SDLK_UNDO]               = "UNDO";
-		key_code_to_string_map[SDLK_CUT]                = "CUT";
-		key_code_to_string_map[SDLK_COPY]               = "COPY";
-		key_code_to_string_map[SDLK_PASTE]              = "PASTE";
-		key_code_to_string_map[SDLK_FIND]               = "FIND";
-		key_code_to_string_map[SDLK_MUTE]               = "MUTE";
-		key_code_to_string_map[SDLK_VOLUMEUP]           = "VOLUMEUP";
-		key_code_to_string_map[SDLK_VOLUMEDOWN]         = "VOLUMEDOWN";
-		key_code_to_string_map[SDLK_KP_COMMA]           = "KP_COMMA";
-		key_code_to_string_map[SDLK_KP_EQUALSAS400]     = "KP_EQUALSAS400";
-		key_code_to_string_map[SDLK_ALTERASE]           = "ALTERASE";
-		key_code_to_string_map[SDLK_SYSREQ]             = "SYSREQ";
-		key_code_to_string_map[SDLK_CANCEL]             = "CANCEL";
-		key_code_to_string_map[SDLK_CLEAR]              = "CLEAR";
-		key_code_to_string_map[SDLK_PRIOR]              = "PRIOR";
-		key_code_to_string_map[SDLK_RETURN2]            = "RETURN2";
-		key_code_to_string_map[SDLK_SEPARATOR]          = "SEPARATOR";
-		key_code_to_string_map[SDLK_OUT]                = "OUT";
-		key_code_to_string_map[SDLK_OPER]               = "OPER";
-		key_code_to_string_map[SDLK_CLEARAGAIN]         = "CLEARAGAIN";
-		key_code_to_string_map[SDLK_CRSEL]              = "CRSEL";
-		key_code_to_string_map[SDLK_EXSEL]              = "EXSEL";
-		key_code_to_string_map[SDLK_KP_00]              = "KP_00";
-		key_code_to_string_map[SDLK_KP_000]             = "KP_000";
-		key_code_to_string_map[SDLK_THOUSANDSSEPARATOR] = "THOUSANDSSEPARATOR";
-		key_code_to_string_map[SDLK_DECIMALSEPARATOR]   = "DECIMALSEPARATOR";
-		key_code_to_string_map[SDLK_CURRENCYUNIT]       = "CURRENCYUNIT";
-		key_code_to_string_map[SDLK_CURRENCYSUBUNIT]    = "CURRENCYSUBUNIT";
-		key_code_to_string_map[SDLK_KP_LEFTPAREN]       = "KP_LEFTPAREN";
-		key_code_to_string_map[SDLK_KP_RIGHTPAREN]      = "KP_RIGHTPAREN";
-		key_code_to_string_map[SDLK_KP_LEFTBRACE]       = "KP_LEFTBRACE";
-		key_code_to_string_map[SDLK_KP_RIGHTBRACE]      = "KP_RIGHTBRACE";
-		key_code_to_string_map[SDLK_KP_TAB]             = "KP_TAB";
-		key_code_to_string_map[SDLK_KP_BACKSPACE]       = "KP_BACKSPACE";
-		key_code_to_string_map[SDLK_KP_A]               = "KP_A";
-		key_code_to_string_map[SDLK_KP_B]               = "KP_B";
-		key_code_to_string_map[SDLK_KP_C]               = "KP_C";
-		key_code_to_string_map[SDLK_KP_D]               = "KP_D";
-		key_code_to_string_map[SDLK_KP_E]               = "KP_E";
-		key_code_to_string_map[SDLK_KP_F]               = "KP_F";
-		key_code_to_string_map[SDLK_KP_XOR]             = "KP_XOR";
-		key_code_to_string_map[SDLK_KP_POWER]           = "KP_POWER";
-		key_code_to_string_map[SDLK_KP_PERCENT]         = "KP_PERCENT";
-		key_code_to_string_map[SDLK_KP_LESS]            = "KP_LESS";
-		key_code_to_string_map[SDLK_KP_GREATER]         = "KP_GREATER";
-		key_code_to_string_map[SDLK_KP_AMPERSAND]       = "KP_AMPERSAND";
-		key_code_to_string_map[SDLK_KP_DBLAMPERSAND]    = "KP_DBLAMPERSAND";
-		key_code_to_string_map[SDLK_KP_VERTICALBAR]     = "KP_VERTICALBAR";
-		key_code_to_string_map[SDLK_KP_DBLVERTICALBAR]  = "KP_DBLVERTICALBAR";
-		key_code_to_string_map[SDLK_KP_COLON]           = "KP_COLON";
-		key_code_to_string_map[SDLK_KP_HASH]            = "KP_HASH";
-		key_code_to_string_map[SDLK_KP_SPACE]           = "KP_SPACE";
-		key_code_to_string_map[SDLK_KP_AT]              = "KP_AT";
-		key_code_to_string_map[SDLK_KP_EXCLAM]          = "KP_EXCLAM";
-		key_code_to_string_map[SDLK_KP_MEMSTORE]        = "KP_MEMSTORE";
-		key_code_to_string_map[SDLK_KP_MEMRECALL]       = "KP_MEMRECALL";
-		key_code_to_string_map[SDLK_KP_MEMCLEAR]        = "KP_MEMCLEAR";
-		key_code_to_string_map[SDLK_KP_MEMADD]          = "KP_MEMADD";
-		key_code_to_string_map[SDLK_KP_MEMSUBTRACT]     = "KP_MEMSUBTRACT";
-		key_code_to_string_map[SDLK_KP_MEMMULTIPLY]     = "KP_MEMMULTIPLY";
-		key_code_to_string_map[SDLK_KP_MEMDIVIDE]       = "KP_MEMDIVIDE";
-		key_code_to_string_map[SDLK_KP_PLUSMINUS]       = "KP_PLUSMINUS";
-		key_code_to_string_map[SDLK_KP_CLEAR]           = "KP_CLEAR";
-		key_code_to_string_map[SDLK_KP_CLEARENTRY]      = "KP_CLEARENTRY";
-		key_code_to_string_map[SDLK_KP_BINARY]          = "KP_BINARY";
-		key_code_to_string_map[SDLK_KP_OCTAL]           = "KP_OCTAL";
-		key_code_to_string_map[SDLK_KP_DECIMAL]         = "KP_DECIMAL";
-		key_code_to_string_map[SDLK_KP_HEXADECIMAL]     = "KP_HEXADECIMAL";
-		key_code_to_string_map[SDLK_LCTRL]              = "LCTRL";
-		key_code_to_string_map[SDLK_LSHIFT]             = "LSHIFT";
-		key_code_to_string_map[SDLK_LALT]               = "LALT";
-		key_code_to_string_map[SDLK_LGUI]               = "LGUI";
-		key_code_to_string_map[SDLK_RCTRL]              = "RCTRL";
-		key_code_to_string_map[SDLK_RSHIFT]             = "RSHIFT";
-		key_code_to_string_map[SDLK_RALT]               = "RALT";
-		key_code_to_string_map[SDLK_RGUI]               = "RGUI";
-		key_code_to_string_map[SDLK_MODE]               = "MODE";
-		key_code_to_string_map[SDLK_AUDIONEXT]          = "AUDIONEXT";
-		key_code_to_string_map[SDLK_AUDIOPREV]          = "AUDIOPREV";
-		key_code_to_string_map[SDLK_AUDIOSTOP]          = "AUDIOSTOP";
-		key_code_to_string_map[SDLK_AUDIOPLAY]          = "AUDIOPLAY";
-		key_code_to_string_map[SDLK_AUDIOMUTE]          = "AUDIOMUTE";
-		key_code_to_string_map[SDLK_MEDIASELECT]        = "MEDIASELECT";
-		key_code_to_string_map[SDLK_WWW]                = "WWW";
-		key_code_to_string_map[SDLK_MAIL]               = "MAIL";
-		key_code_to_string_map[SDLK_CALCULATOR]         = "CALCULATOR";
-		key_code_to_string_map[SDLK_COMPUTER]           = "COMPUTER";
-		key_code_to_string_map[SDLK_AC_SEARCH]          = "AC_SEARCH";
-		key_code_to_string_map[SDLK_AC_HOME]            = "AC_HOME";
-		key_code_to_string_map[SDLK_AC_BACK]            = "AC_BACK";
-		key_code_to_string_map[SDLK_AC_FORWARD]         = "AC_FORWARD";
-		key_code_to_string_map[SDLK_AC_STOP]            = "AC_STOP";
-		key_code_to_string_map[SDLK_AC_REFRESH]         = "AC_REFRESH";
-		key_code_to_string_map[SDLK_AC_BOOKMARKS]       = "AC_BOOKMARKS";
-		key_code_to_string_map[SDLK_BRIGHTNESSDOWN]     = "BRIGHTNESSDOWN";
-		key_code_to_string_map[SDLK_BRIGHTNESSUP]       = "BRIGHTNESSUP";
-		key_code_to_string_map[SDLK_DISPLAYSWITCH]      = "DISPLAYSWITCH";
-		key_code_to_string_map[SDLK_KBDILLUMTOGGLE]     = "KBDILLUMTOGGLE";
-		key_code_to_string_map[SDLK_KBDILLUMDOWN]       = "KBDILLUMDOWN";
-		key_code_to_string_map[SDLK_KBDILLUMUP]         = "KBDILLUMUP";
-		key_code_to_string_map[SDLK_EJECT]              = "EJECT";
-		key_code_to_string_map[SDLK_SLEEP]              = "SLEEP";
-		key_code_to_string_map[SDLK_APP1]               = "APP1";
-		key_code_to_string_map[SDLK_APP2]               = "APP2";
-		key_code_to_string_map[SDLK_AUDIOREWIND]        = "AUDIOREWIND";
-		key_code_to_string_map[SDLK_AUDIOFASTFORWARD]   = "AUDIOFASTFORWARD";
-		key_code_to_string_map[SDLK_SOFTLEFT]           = "SOFTLEFT";
-		key_code_to_string_map[SDLK_SOFTRIGHT]          = "SOFTRIGHT";
-		key_code_to_string_map[SDLK_CALL]               = "CALL";
-		key_code_to_string_map[SDLK_ENDCALL]            = "ENDCALL";
-	}
-
-	return key_code_to_string_map[code];
+const char* InputHandler::scancode_to_string(SDL_Scancode code) {
+	if ((size_t)code >= SDL_NUM_SCANCODES || SCANCODE_NAMES[code] == nullptr) return "UNKNOWN";
+	return SCANCODE_NAMES[code];
 }
 
 std::string InputHandler::direction_to_string(const Direction& direction) {
@@ -365,38 +459,50 @@ Vector2f InputHandler::direction_to_vector(const Direction& direction) {
 }
 
 void InputHandler::update_mouse_states() {
-	for (auto& [button, state] : get()._mouse_states) {
-		switch (state) {
-			case InputState::PRESSED:
-				get()._mouse_states[button] = InputState::DOWN;
-				break;
-			case InputState::RELEASED:
-				get()._mouse_states[button] = InputState::NOT_PRESSED;
-				break;
-			default:
-				break;
-		}
-	}
+	auto& input = get();
+
+	input._pressed_buttons  = (input._buttons & ~input._previous_buttons) | input._hit_buttons;
+	input._released_buttons = (input._previous_buttons | input._hit_buttons) & ~input._buttons;
+	input._previous_buttons = input._buttons;
+	input._hit_buttons      = 0;
+
+	Stats::set_counter(input._stat_mouse_x, (int64_t)input._mouse_position.x);
+	Stats::set_counter(input._stat_mouse_y, (int64_t)input._mouse_position.y);
 }
 
-std::map<MouseButton, InputState> InputHandler::get_mouse_states() {
-	return get()._mouse_states;
+InputState InputHandler::get_mouse_state(MouseButton button) {
+	if (is_mouse_pressed(button)) return InputState::PRESSED;
+	if (is_mouse_released(button)) return InputState::RELEASED;
+	if (is_mouse_down(button)) return InputState::DOWN;
+	return InputState::NOT_PRESSED;
 }
 
 void InputHandler::set_mouse_button_state(const MouseButton& button, InputState new_state) {
-	get()._mouse_states[button] = new_state;
+	if (button == MouseButton::UNKNOWN) return;
+
+	auto& input = get();
+	switch (new_state) {
+		case InputState::PRESSED:
+		case InputState::DOWN:
+			input._buttons |= button_bit(button);
+			input._hit_buttons |= button_bit(button);
+			break;
+		default:
+			input._buttons &= ~button_bit(button);
+			break;
+	}
 }
 
 bool InputHandler::is_mouse_pressed(const MouseButton& button) {
-	return get()._mouse_states[button] == InputState::PRESSED;
+	return get()._pressed_buttons & button_bit(button);
 }
 
 bool InputHandler::is_mouse_down(const MouseButton& button) {
-	return get()._mouse_states[button] == InputState::DOWN;
+	return get()._buttons & button_bit(button);
 }
 
 bool InputHandler::is_mouse_released(const MouseButton& button) {
-	return get()._mouse_states[button] == InputState::RELEASED;
+	return get()._released_buttons & button_bit(button);
 }
 
 Vector2f InputHandler::get_mouse_position() {
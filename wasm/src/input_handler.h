@@ -1,12 +1,25 @@
 #pragma once
 
+#include "stats.h"
 #include "utils.h"
 
+#include <array>
+#include <bitset>
+
+/**
+ * Keyboard and mouse state, one bit per scancode or mouse button.
+ *
+ * Events only set or clear the bit of the key, update_key_states() then
+ * derives the PRESSED and RELEASED transitions of the whole keyboard from the
+ * current and previous bitsets, so a query is a single bit test and nothing is
+ * allocated. A key pressed and released between two frames is still reported
+ * as PRESSED once.
+ */
 class InputHandler {
   public:
 	InputHandler(const InputHandler&) = delete;
 
-	InputHandler()  = default;
+	InputHandler();
 	~InputHandler() = default;
 
 	static InputHandler& get() {
@@ -14,25 +27,41 @@ class InputHandler {
 		return instance;
 	}
 
+	/**
+	 * Computes the transitions of the frame, call it once the events are handled
+	 */
 	static void update_key_states();
 
-	static std::map<SDL_Keycode, InputState> get_key_states();
-	static Vector2f                          get_key_direction();
-	static void                              set_key_state(const SDL_Keycode& code, InputState new_state);
+	static InputState get_key_state(SDL_Scancode code);
+	static Vector2f   get_key_direction();
+	static void       set_key_state(SDL_Scancode code, InputState new_state);
 
 	/**
 	 * Checks wheter a key is PRESSED, DOWN or RELEASED
 	 * You can refer to the InputState enum for more information
-	 * @param code The key code to check
+	 * @param code The scancode of the key, the physical key whatever the layout
 	 * @return true if the key is in the specified state
 	 * @return false if the key is not in the specified state
 	 */
-	static bool is_key_pressed(const SDL_Keycode& code);
-	static bool is_key_down(const SDL_Keycode& code);
-	static bool is_key_released(const SDL_Keycode& code);
+	static bool is_key_pressed(SDL_Scancode code);
+	static bool is_key_down(SDL_Scancode code);
+	static bool is_key_released(SDL_Scancode code);
+
+	/**
+	 * Adds a key to the keys triggering the action
+	 */
+	static void bind_action(InputAction action, SDL_Scancode code);
+	static void unbind_action(InputAction action);
+
+	/**
+	 * Checks whether any key bound to the action is in the state
+	 */
+	static bool is_action_pressed(InputAction action);
+	static bool is_action_down(InputAction action);
+	static bool is_action_released(InputAction action);
 
 	static std::string input_state_to_string(InputState state);
-	static std::string key_code_to_string(int code);
+	static const char* scancode_to_string(SDL_Scancode code);
 	static std::string direction_to_string(const Direction& direction);
 	static Vector2f    direction_to_vector(const Direction& direction);
 	static std::string mouse_button_to_string(MouseButton button);
@@ -40,14 +69,12 @@ class InputHandler {
 	static Direction   vector_to_direction(const Vector2f& vector);
 
 	/**
-	 * Updates the mouse states
-	 * Go from PRESSED to DOWN if the mouse button is still pressed
-	 * Go from RELEASED to NOT_PRESSED if the mouse button is not pressed anymore
+	 * Updates the mouse states, same as update_key_states() for the buttons
 	 */
 	static void update_mouse_states();
 
-	static std::map<MouseButton, InputState> get_mouse_states();
-	static void                              set_mouse_button_state(const MouseButton& button, InputState new_state);
+	static InputState get_mouse_state(MouseButton button);
+	static void       set_mouse_button_state(const MouseButton& button, InputState new_state);
 
 	/**
 	 * Checks wheter a mouse button is in a specific state
@@ -73,51 +100,43 @@ class InputHandler {
 
 	static Vector2f get_mouse_wheel_delta();
 
-	friend std::ostream& operator<<(std::ostream& os, const InputHandler& inputHandler) {
-		os << "{\n";
-		os << "  \"key_states\": {\n";
-		for (auto it = inputHandler._key_states.begin(); it != inputHandler._key_states.end(); ++it) {
-			os << "    \"" << key_code_to_string(it->first) << "\": \"" << input_state_to_string(it->second) << "\",\n";
-		}
-		os << "  },\n";
-		os << "  \"key_direction\": {\n";
-		os << "    \"x\": " << inputHandler._key_direction.x << ",\n";
-		os << "    \"y\": " << inputHandler._key_direction.y << "\n";
-		os << "  },\n";
-		os << "  \"mouse_states\": {\n";
-		for (auto it = inputHandler._mouse_states.begin(); it != inputHandler._mouse_states.end(); ++it) {
-			os << "    \"" << mouse_button_to_string(it->first) << "\": \"" << input_state_to_string(it->second)
-			   << "\",\n";
-		}
-		os << "  },\n";
-		os << "  \"mouse_position\": {\n";
-		os << "    \"x\": " << inputHandler._mouse_position.x << ",\n";
-		os << "    \"y\": " << inputHandler._mouse_position.y << "\n";
-		os << "  },\n";
-		os << "  \"last_mouse_position\": {\n";
-		os << "    \"x\": " << inputHandler._last_mouse_position.x << ",\n";
-		os << "    \"y\": " << inputHandler._last_mouse_position.y << "\n";
-		os << "  },\n";
-		os << "  \"mouse_coords\": {\n";
-		os << "    \"x\": " << inputHandler.get_mouse_coords().x << ",\n";
-		os << "    \"y\": " << inputHandler.get_mouse_coords().y << "\n";
-		os << "  },\n";
-		os << "  \"mouse_wheel\": {\n";
-		os << "    \"x\": " << inputHandler._mouse_wheel.x << ",\n";
-		os << "    \"y\": " << inputHandler._mouse_wheel.y << "\n";
-		os << "  },\n";
-		os << "  \"last_mouse_wheel\": {\n";
-		os << "    \"x\": " << inputHandler._last_mouse_wheel.x << ",\n";
-		os << "    \"y\": " << inputHandler._last_mouse_wheel.y << "\n";
-		os << "  }\n";
-		os << "}";
-		return os;
-	}
-
   private:
-	std::map<SDL_Keycode, InputState> _key_states;
-	std::map<MouseButton, InputState> _mouse_states;
-	Vector2f                          _key_direction = Vector2f(0, 0);
+	using KeySet = std::bitset<SDL_NUM_SCANCODES>;
+
+	static constexpr size_t ACTION_COUNT = (size_t)InputAction::COUNT;
+
+	static uint32_t action_bit(InputAction action) { return 1u << (uint32_t)action; }
+	static uint8_t  button_bit(MouseButton button) { return (uint8_t)(1u << (uint32_t)button); }
+
+	// down now, down at the previous update, went down or up since the previous update
+	KeySet _keys;
+	KeySet _previous_keys;
+	KeySet _pressed_keys;
+	KeySet _released_keys;
+	KeySet _hit_keys; // pressed since the previous update, even if already released
+
+	// keys bound to each action and the action states as one bit per action
+	std::array<KeySet, ACTION_COUNT> _bindings;
+	uint32_t                         _actions_down     = 0;
+	uint32_t                         _actions_pressed  = 0;
+	uint32_t                         _actions_released = 0;
+
+	// same as the keys, one bit per MouseButton
+	uint8_t _buttons          = 0;
+	uint8_t _previous_buttons = 0;
+	uint8_t _pressed_buttons  = 0;
+	uint8_t _released_buttons = 0;
+	uint8_t _hit_buttons      = 0;
+
+	Vector2f _key_direction = Vector2f(0, 0);
+
+	void publish_key_stats();
+
+	StatId _stat_keys;
+	StatId _stat_direction_x;
+	StatId _stat_direction_y;
+	StatId _stat_mouse_x;
+	StatId _stat_mouse_y;
 
 	Vector2f _mouse_position;
 	Vector2f _last_mouse_position;
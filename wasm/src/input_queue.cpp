@@ -0,0 +1,86 @@
+#include "input_queue.h"
+
+namespace {
+	// motion and wheel events are drained too but would drown the key presses
+	bool is_measured(const SDL_Event& event) {
+		switch (event.type) {
+			case SDL_KEYDOWN:
+			case SDL_KEYUP:
+			case SDL_MOUSEBUTTONDOWN:
+			case SDL_MOUSEBUTTONUP:
+				return true;
+			default:
+				return false;
+		}
+	}
+} // namespace
+
+InputQueue::InputQueue() {
+	_stat_p50     = Stats::add_counter("input.latency_p50_ms");
+	_stat_p95     = Stats::add_counter("input.latency_p95_ms");
+	_stat_p99     = Stats::add_counter("input.latency_p99_ms");
+	_stat_max     = Stats::add_counter("input.latency_max_ms");
+	_stat_dropped = Stats::add_counter("input.dropped_events");
+}
+
+bool InputQueue::push(const SDL_Event& event) {
+	auto& queue = get();
+
+	// only the last position matters, keeps the room for the key and button events
+	if (event.type == SDL_MOUSEMOTION && !queue._events.empty() && queue._events.back().type == SDL_MOUSEMOTION) {
+		queue._events.back() = event;
+		return true;
+	}
+
+	if (queue._events.try_push(event)) return true;
+
+	Stats::set_counter(queue._stat_dropped, ++queue._dropped);
+	return false;
+}
+
+bool InputQueue::pop(SDL_Event& event) {
+	auto& queue = get();
+	if (!queue._events.try_pop(event)) return false;
+
+	if (is_measured(event)) {
+		queue._consumed.try_push(event.common.timestamp);
+	}
+	return true;
+}
+
+void InputQueue::present() {
+	auto& queue = get();
+	if (queue._consumed.empty()) return;
+
+	Uint32 now = SDL_GetTicks();
+	Uint32 timestamp;
+	while (queue._consumed.try_pop(timestamp)) {
+		queue._samples.push_overwrite(now - timestamp);
+	}
+
+	queue.update_stats();
+}
+
+void InputQueue::update_stats() {
+	size_t count = _samples.size();
+
+	Uint32 sorted[INPUT_LATENCY_SAMPLES];
+	for (size_t i = 0; i < count; ++i) {
+		sorted[i] = _samples[i];
+	}
+	std::sort(sorted, sorted + count);
+
+	// nearest rank
+	auto percentile = [&](int p) { return sorted[std::min(count - 1, (count * p + 99) / 100 - 1)]; };
+
+	_stats.samples = count;
+	_stats.p50     = percentile(50);
+	_stats.p95     = percentile(95);
+	_stats.p99     = percentile(99);
+	_stats.max     = sorted[count - 1];
+
+	Stats::set_counter(_stat_p50, _stats.p50);
+	Stats::set_counter(_stat_p95, _stats.p95);
+	Stats::set_counter(_stat_p99, _stats.p99);
+	Stats::set_counter(_stat_max, _stats.max);
+}
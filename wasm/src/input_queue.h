@@ -0,0 +1,79 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#pragma once
+
+#include "includes.h"
+#include "ring_buffer.h"
+#include "stats.h"
+
+/**
+ * Percentiles of the input latency over the last INPUT_LATENCY_SAMPLES
+ * events, in milliseconds
+ */
+struct InputLatencyStats {
+	size_t samples = 0;
+	Uint32 p50     = 0;
+	Uint32 p95     = 0;
+	Uint32 p99     = 0;
+	Uint32 max     = 0;
+};
+
+/**
+ * Input events waiting to be applied, with their SDL timestamps.
+ *
+ * Events are queued as they are polled and drained once per frame, right
+ * before the simulation. The timestamps of the drained key and mouse button
+ * events are kept until present() so the time from the event to the frame
+ * showing its effect on screen can be measured.
+ */
+class InputQueue {
+  public:
+	InputQueue();
+	~InputQueue() = default;
+
+	InputQueue(const InputQueue&)            = delete;
+	InputQueue& operator=(const InputQueue&) = delete;
+
+	static InputQueue& get() {
+		static InputQueue instance;
+		return instance;
+	}
+
+	/**
+	 * @return false if the queue is full, the event is dropped
+	 */
+	static bool push(const SDL_Event& event);
+
+	/**
+	 * Pops the oldest event, its latency is measured at the next present()
+	 * @return false once the queue is empty
+	 */
+	static bool pop(SDL_Event& event);
+
+	/**
+	 * Records the latency of the events popped since the previous present,
+	 * call it right after SDL_RenderPresent
+	 */
+	static void present();
+
+	static const InputLatencyStats& get_latency() { return get()._stats; }
+	static size_t                   get_dropped() { return get()._dropped; }
+
+  private:
+	void update_stats();
+
+	RingBuffer<SDL_Event, INPUT_QUEUE_CAPACITY> _events;
+	RingBuffer<Uint32, INPUT_QUEUE_CAPACITY>    _consumed; // timestamps waiting for the present
+	RingBuffer<Uint32, INPUT_LATENCY_SAMPLES>   _samples;
+	InputLatencyStats                           _stats;
+	size_t                                      _dropped = 0;
+
+	StatId _stat_p50;
+	StatId _stat_p95;
+	StatId _stat_p99;
+	StatId _stat_max;
+	StatId _stat_dropped;
+};
+
+#endif
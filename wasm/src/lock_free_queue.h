@@ -0,0 +1,92 @@
+#ifndef LOCK_FREE_QUEUE_H
+#define LOCK_FREE_QUEUE_H
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bounded multi-producer multi-consumer queue (Vyukov's ring buffer).
+ * Each cell carries a sequence number telling whether it is ready to be
+ * written or read, so producers and consumers only contend on one atomic
+ * increment each and never take a lock.
+ * @tparam T The element type, must be default constructible
+ * @tparam Capacity Number of cells, must be a power of two
+ */
+template<typename T, size_t Capacity>
+class LockFreeQueue {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  public:
+	LockFreeQueue() {
+		for (size_t i = 0; i < Capacity; ++i) {
+			_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	LockFreeQueue(const LockFreeQueue&)            = delete;
+	LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+	/**
+	 * @return false if the queue is full
+	 */
+	bool try_push(const T& value) {
+		size_t position = _tail.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell&    cell     = _cells[position & (Capacity - 1)];
+			size_t   sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff     = (intptr_t)sequence - (intptr_t)position;
+
+			if (diff == 0) {
+				if (_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					cell.value = value;
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				position = _tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	 * @return false if the queue is empty
+	 */
+	bool try_pop(T& value) {
+		size_t position = _head.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell&    cell     = _cells[position & (Capacity - 1)];
+			size_t   sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff     = (intptr_t)sequence - (intptr_t)(position + 1);
+
+			if (diff == 0) {
+				if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					value = cell.value;
+					cell.sequence.store(position + Capacity, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				position = _head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+  private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T                   value;
+	};
+
+	// head and tail on their own cache lines, producers and consumers do not share them
+	alignas(64) Cell _cells[Capacity];
+	alignas(64) std::atomic<size_t> _head = {0};
+	alignas(64) std::atomic<size_t> _tail = {0};
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "lz4_block.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+	const size_t MIN_MATCH     = 4;
+	const size_t LAST_LITERALS = 5;  // the block always ends with literals
+	const size_t MATCH_LIMIT   = 12; // no match may start this close to the end
+	const size_t MAX_OFFSET    = 65535;
+	const int    HASH_BITS     = 16;
+
+	inline uint32_t read32(const uint8_t *p) {
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t hash4(uint32_t value) {
+		return (value * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	inline uint8_t *write_length(uint8_t *out, size_t length) {
+		while (length >= 255) {
+			*out++ = 255;
+			length -= 255;
+		}
+		*out++ = (uint8_t)length;
+		return out;
+	}
+
+	uint8_t *write_sequence(uint8_t *out, const uint8_t *literals, size_t literal_count) {
+		uint8_t *token = out++;
+		*token         = (uint8_t)((literal_count < 15 ? literal_count : 15) << 4);
+		if (literal_count >= 15) out = write_length(out, literal_count - 15);
+
+		memcpy(out, literals, literal_count);
+		return out + literal_count;
+	}
+} // namespace
+
+size_t lz4_compress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_capacity) {
+	if (dst_capacity < lz4_compress_bound(size)) return 0;
+
+	std::vector<uint32_t> table(1 << HASH_BITS, 0);
+	const uint8_t        *anchor = src;
+	const uint8_t        *end    = src + size;
+	uint8_t              *out    = dst;
+
+	if (size > MATCH_LIMIT) {
+		const uint8_t *match_limit = end - MATCH_LIMIT;
+		const uint8_t *p           = src + 1;
+
+		while (p < match_limit) {
+			uint32_t       sequence  = read32(p);
+			uint32_t       hash      = hash4(sequence);
+			const uint8_t *candidate = src + table[hash];
+			table[hash]              = (uint32_t)(p - src);
+
+			if (candidate >= p || (size_t)(p - candidate) > MAX_OFFSET || read32(candidate) != sequence) {
+				++p;
+				continue;
+			}
+
+			// extend the match, it must stop LAST_LITERALS before the end
+			const uint8_t *match_end = p + MIN_MATCH;
+			const uint8_t *ref       = candidate + MIN_MATCH;
+			while (match_end < end - LAST_LITERALS && *match_end == *ref) {
+				++match_end;
+				++ref;
+			}
+
+			size_t literal_count = (size_t)(p - anchor);
+			size_t match_length  = (size_t)(match_end - p) - MIN_MATCH;
+			size_t offset        = (size_t)(p - candidate);
+
+			uint8_t *token = out;
+			out            = write_sequence(out, anchor, literal_count);
+
+			*out++ = (uint8_t)(offset & 0xFF);
+			*out++ = (uint8_t)(offset >> 8);
+
+			*token |= (uint8_t)(match_length < 15 ? match_length : 15);
+			if (match_length >= 15) out = write_length(out, match_length - 15);
+
+			p      = match_end;
+			anchor = p;
+		}
+	}
+
+	out = write_sequence(out, anchor, (size_t)(end - anchor));
+	return (size_t)(out - dst);
+}
+
+bool lz4_decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_size) {
+	const uint8_t *in      = src;
+	const uint8_t *in_end  = src + size;
+	uint8_t       *out     = dst;
+	uint8_t       *out_end = dst + dst_size;
+
+	while (in < in_end) {
+		uint8_t token = *in++;
+
+		size_t literal_count = token >> 4;
+		if (literal_count == 15) {
+			uint8_t byte;
+			do {
+				if (in >= in_end) return false;
+				byte = *in++;
+				literal_count += byte;
+			} while (byte == 255);
+		}
+
+		if (literal_count > (size_t)(in_end - in) || literal_count > (size_t)(out_end - out)) return false;
+		memcpy(out, in, literal_count);
+		in += literal_count;
+		out += literal_count;
+
+		// the last sequence has no match
+		if (in == in_end) break;
+
+		if (in_end - in < 2) return false;
+		size_t offset = in[0] | (in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > (size_t)(out - dst)) return false;
+
+		size_t match_length = token & 0x0F;
+		if (match_length == 15) {
+			uint8_t byte;
+			do {
+				if (in >= in_end) return false;
+				byte = *in++;
+				match_length += byte;
+			} while (byte == 255);
+		}
+		match_length += MIN_MATCH;
+		if (match_length > (size_t)(out_end - out)) return false;
+
+		// byte by byte, the match may overlap the bytes it produces
+		const uint8_t *ref = out - offset;
+		if (offset >= match_length) {
+			memcpy(out, ref, match_length);
+			out += match_length;
+		} else {
+			for (size_t i = 0; i < match_length; ++i) *out++ = *ref++;
+		}
+	}
+
+	return out == out_end;
+}
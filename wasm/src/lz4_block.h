@@ -0,0 +1,33 @@
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * LZ4 block format (no frame header), enough to store cooked textures.
+ * The decoder is what runs in the game, the encoder is only used by the
+ * asset packer and trades ratio for simplicity (greedy, single probe).
+ */
+
+/**
+ * @return the largest size lz4_compress() can produce for size input bytes
+ */
+inline size_t lz4_compress_bound(size_t size) {
+	return size + size / 255 + 16;
+}
+
+/**
+ * @return the compressed size, 0 if dst_capacity is too small
+ */
+size_t lz4_compress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_capacity);
+
+/**
+ * Decompresses exactly dst_size bytes
+ * @return false if the block is corrupted or does not match dst_size
+ */
+bool lz4_decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_size);
+
+#endif
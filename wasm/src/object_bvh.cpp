@@ -0,0 +1,291 @@
+#include "object_bvh.h"
+
+namespace {
+	float half_perimeter(const BvhBounds &bounds) {
+		return (bounds.max_x - bounds.min_x) + (bounds.max_y - bounds.min_y);
+	}
+
+	void grow(BvhBounds &bounds, const BvhBounds &other) {
+		bounds.min_x = std::min(bounds.min_x, other.min_x);
+		bounds.min_y = std::min(bounds.min_y, other.min_y);
+		bounds.max_x = std::max(bounds.max_x, other.max_x);
+		bounds.max_y = std::max(bounds.max_y, other.max_y);
+	}
+
+	float centroid(const BvhBounds &bounds, int axis) {
+		return axis == 0 ? (bounds.min_x + bounds.max_x) * 0.5f : (bounds.min_y + bounds.max_y) * 0.5f;
+	}
+
+	/**
+	 * Clips [near, far] to the distances where the ray is between min and max on one axis
+	 * @param inverse 1 / direction, infinite when the ray is parallel to the axis
+	 */
+	bool clip_slab(float origin, float inverse, float min, float max, float &near, float &far) {
+		if (std::isinf(inverse)) return origin >= min && origin <= max;
+
+		float t0 = (min - origin) * inverse;
+		float t1 = (max - origin) * inverse;
+		if (t0 > t1) std::swap(t0, t1);
+
+		near = std::max(near, t0);
+		far  = std::min(far, t1);
+		return near <= far;
+	}
+
+	struct Ray {
+		float x;
+		float y;
+		float inverse_x;
+		float inverse_y;
+
+		/**
+		 * @param distance Where the ray enters the bounds, 0 when it starts in them
+		 */
+		bool hits(const BvhBounds &bounds, float max_distance, float &distance) const {
+			float near = 0;
+			float far  = max_distance;
+			if (!clip_slab(x, inverse_x, bounds.min_x, bounds.max_x, near, far)) return false;
+			if (!clip_slab(y, inverse_y, bounds.min_y, bounds.max_y, near, far)) return false;
+
+			distance = near;
+			return true;
+		}
+	};
+} // namespace
+
+SDL_Rect BvhBounds::to_rect() const {
+	int x = (int)floorf(min_x);
+	int y = (int)floorf(min_y);
+	return {x, y, (int)ceilf(max_x) - x, (int)ceilf(max_y) - y};
+}
+
+BvhBounds ObjectBvh::get_bounds(const MapObject &object) {
+	// corners relative to the position, which is the bottom left corner of a tile object
+	float top     = object.gid != 0 ? -object.height : 0;
+	float xs[4]   = {0, object.width, 0, object.width};
+	float ys[4]   = {top, top, top + object.height, top + object.height};
+	float radians = object.rotation * 0.017453292f;
+	float cosine  = cosf(radians);
+	float sine    = sinf(radians);
+
+	BvhBounds bounds;
+	for (int i = 0; i < 4; ++i) {
+		// clockwise on screen, y goes down
+		float x = object.x + xs[i] * cosine - ys[i] * sine;
+		float y = object.y + xs[i] * sine + ys[i] * cosine;
+		if (i == 0) {
+			bounds = {x, y, x, y};
+		} else {
+			grow(bounds, {x, y, x, y});
+		}
+	}
+	return bounds;
+}
+
+void ObjectBvh::build(const std::vector<MapObject> &objects, const std::string &group) {
+	clear();
+
+	for (size_t i = 0; i < objects.size(); ++i) {
+		if (objects[i].group != group) continue;
+
+		_objects.push_back((Uint32)i);
+		_bounds.push_back(get_bounds(objects[i]));
+	}
+	if (_objects.empty()) return;
+
+	// a binary tree has fewer than 2 nodes per object
+	_nodes.reserve(_objects.size() * 2);
+	build_node(0, (Uint32)_objects.size(), 0);
+}
+
+void ObjectBvh::build_node(Uint32 begin, Uint32 end, int depth) {
+	Uint32 index = (Uint32)_nodes.size();
+	_nodes.push_back(BvhNode());
+
+	BvhBounds bounds    = _bounds[begin];
+	float     x         = centroid(_bounds[begin], 0);
+	float     y         = centroid(_bounds[begin], 1);
+	BvhBounds centroids = {x, y, x, y};
+	for (Uint32 i = begin + 1; i < end; ++i) {
+		x = centroid(_bounds[i], 0);
+		y = centroid(_bounds[i], 1);
+		grow(bounds, _bounds[i]);
+		grow(centroids, {x, y, x, y});
+	}
+
+	Uint32 count         = end - begin;
+	_nodes[index].bounds = bounds;
+	_nodes[index].offset = begin;
+	_nodes[index].count  = count;
+
+	if (count <= OBJECT_BVH_LEAF_SIZE || depth >= OBJECT_BVH_MAX_DEPTH) return;
+
+	// split along the longest side of the centroids
+	int   axis   = centroids.max_x - centroids.min_x >= centroids.max_y - centroids.min_y ? 0 : 1;
+	float low    = axis == 0 ? centroids.min_x : centroids.min_y;
+	float extent = axis == 0 ? centroids.max_x - low : centroids.max_y - low;
+	if (extent <= 0) return;
+
+	struct Bin {
+		BvhBounds bounds;
+		Uint32    count = 0;
+	} bins[OBJECT_BVH_BINS];
+
+	float scale  = OBJECT_BVH_BINS / extent;
+	auto  bin_of = [&](Uint32 i) {
+		return std::min((int)((centroid(_bounds[i], axis) - low) * scale), OBJECT_BVH_BINS - 1);
+	};
+
+	for (Uint32 i = begin; i < end; ++i) {
+		Bin &bin = bins[bin_of(i)];
+		if (bin.count++ == 0) {
+			bin.bounds = _bounds[i];
+		} else {
+			grow(bin.bounds, _bounds[i]);
+		}
+	}
+
+	// cost of the objects right of each split, swept from the right
+	float     right_costs[OBJECT_BVH_BINS] = {};
+	BvhBounds side;
+	Uint32    side_count = 0;
+	for (int i = OBJECT_BVH_BINS - 1; i > 0; --i) {
+		if (bins[i].count > 0) {
+			if (side_count == 0) side = bins[i].bounds;
+			grow(side, bins[i].bounds);
+			side_count += bins[i].count;
+		}
+		right_costs[i] = side_count > 0 ? half_perimeter(side) * side_count : 0;
+	}
+
+	// the best split leaves bins [0, best_split) on the left
+	int   best_split = -1;
+	float best_cost  = 0;
+	side_count       = 0;
+	for (int i = 0; i < OBJECT_BVH_BINS - 1; ++i) {
+		if (bins[i].count > 0) {
+			if (side_count == 0) side = bins[i].bounds;
+			grow(side, bins[i].bounds);
+			side_count += bins[i].count;
+		}
+		if (side_count == 0 || side_count == count) continue;
+
+		float cost = half_perimeter(side) * side_count + right_costs[i + 1];
+		if (best_split < 0 || cost < best_cost) {
+			best_split = i + 1;
+			best_cost  = cost;
+		}
+	}
+
+	// a node costs as much to traverse as an object to test
+	float area = half_perimeter(bounds);
+	if (best_split < 0 || (area > 0 && 1.0f + best_cost / area >= (float)count)) return;
+
+	Uint32 middle = begin;
+	for (Uint32 i = begin; i < end; ++i) {
+		if (bin_of(i) >= best_split) continue;
+
+		std::swap(_objects[i], _objects[middle]);
+		std::swap(_bounds[i], _bounds[middle]);
+		++middle;
+	}
+
+	_nodes[index].count = 0;
+	build_node(begin, middle, depth + 1);
+	_nodes[index].offset = (Uint32)_nodes.size();
+	build_node(middle, end, depth + 1);
+}
+
+void ObjectBvh::clear() {
+	_nodes.clear();
+	_objects.clear();
+	_bounds.clear();
+}
+
+template <typename Test> size_t ObjectBvh::collect(const Test &test, std::vector<Uint32> &out) const {
+	if (_nodes.empty()) return 0;
+
+	Uint32 stack[OBJECT_BVH_MAX_DEPTH + 2];
+	int    top   = 0;
+	size_t found = 0;
+
+	stack[top++] = 0;
+	while (top > 0) {
+		Uint32         index = stack[--top];
+		const BvhNode &node  = _nodes[index];
+		if (!test(node.bounds)) continue;
+
+		if (node.count == 0) {
+			stack[top++] = node.offset;
+			stack[top++] = index + 1;
+			continue;
+		}
+
+		for (Uint32 i = node.offset; i < node.offset + node.count; ++i) {
+			if (!test(_bounds[i])) continue;
+
+			out.push_back(_objects[i]);
+			++found;
+		}
+	}
+	return found;
+}
+
+size_t ObjectBvh::query(const SDL_Rect &rect, std::vector<Uint32> &out) const {
+	BvhBounds bounds = {(float)rect.x, (float)rect.y, (float)(rect.x + rect.w), (float)(rect.y + rect.h)};
+	return collect([&](const BvhBounds &other) { return bounds.overlaps(other); }, out);
+}
+
+size_t ObjectBvh::query(float x, float y, std::vector<Uint32> &out) const {
+	return collect([&](const BvhBounds &bounds) { return bounds.contains(x, y); }, out);
+}
+
+bool ObjectBvh::raycast(float x, float y, float dx, float dy, float max_distance, BvhHit &hit) const {
+	if (_nodes.empty()) return false;
+
+	Ray   ray      = {x, y, 1.0f / dx, 1.0f / dy};
+	float closest  = max_distance;
+	bool  found    = false;
+	float distance = 0;
+	if (!ray.hits(_nodes[0].bounds, closest, distance)) return false;
+
+	Uint32 stack[OBJECT_BVH_MAX_DEPTH + 2];
+	int    top = 0;
+
+	stack[top++] = 0;
+	while (top > 0) {
+		const BvhNode &node = _nodes[stack[--top]];
+
+		if (node.count > 0) {
+			for (Uint32 i = node.offset; i < node.offset + node.count; ++i) {
+				if (!ray.hits(_bounds[i], closest, distance)) continue;
+
+				closest    = distance;
+				hit.object = _objects[i];
+				found      = true;
+			}
+			continue;
+		}
+
+		// the nearest child is visited first, it may cut the ray short for the other one
+		Uint32 first  = (Uint32)(&node - _nodes.data()) + 1;
+		Uint32 second = node.offset;
+		float  first_distance;
+		float  second_distance;
+		bool   first_hit  = ray.hits(_nodes[first].bounds, closest, first_distance);
+		bool   second_hit = ray.hits(_nodes[second].bounds, closest, second_distance);
+
+		if (first_hit && second_hit && second_distance < first_distance) std::swap(first, second);
+		if (first_hit && second_hit) {
+			stack[top++] = second;
+			stack[top++] = first;
+		} else if (first_hit) {
+			stack[top++] = first;
+		} else if (second_hit) {
+			stack[top++] = second;
+		}
+	}
+
+	if (found) hit.distance = closest;
+	return found;
+}
@@ -0,0 +1,102 @@
+#ifndef OBJECT_BVH_H
+#define OBJECT_BVH_H
+
+#pragma once
+
+#include "includes.h"
+#include "tile_map.h"
+
+/**
+ * Static bounding volume hierarchy over the objects of a Tiled object layer,
+ * for the colliders and triggers that do not fit in the tile collision bits.
+ *
+ * Built once per map with binned SAH splits (the half perimeter stands for
+ * the surface area in 2D), then flattened depth first: the first child of a
+ * node follows it, and the objects of a leaf are stored next to each other
+ * with their bounds. Objects are tested by their bounds, rotated ones by the
+ * bounds of their rotated rectangle.
+ */
+
+#define OBJECT_BVH_BINS      16
+#define OBJECT_BVH_LEAF_SIZE 4  // objects under which a node is never split
+#define OBJECT_BVH_MAX_DEPTH 32 // also bounds the traversal stack
+
+struct BvhBounds {
+	float min_x = 0;
+	float min_y = 0;
+	float max_x = 0;
+	float max_y = 0;
+
+	bool overlaps(const BvhBounds &other) const {
+		return min_x < other.max_x && max_x > other.min_x && min_y < other.max_y && max_y > other.min_y;
+	}
+	bool contains(float x, float y) const { return x >= min_x && x < max_x && y >= min_y && y < max_y; }
+
+	SDL_Rect to_rect() const;
+};
+
+struct BvhNode {
+	BvhBounds bounds;
+	Uint32    offset; // first object of a leaf, second child of an inner node
+	Uint32    count;  // objects of a leaf, 0 for an inner node
+};
+
+struct BvhHit {
+	Uint32 object   = 0;
+	float  distance = 0; // along the ray, in lengths of its direction
+};
+
+class ObjectBvh {
+  public:
+	/**
+	 * Builds the hierarchy over the objects of the object layer named group,
+	 * the queries return indices in objects
+	 */
+	void build(const std::vector<MapObject> &objects, const std::string &group);
+
+	void clear();
+
+	/**
+	 * Appends the objects overlapping the rect to out
+	 * @return the number of objects appended
+	 */
+	size_t query(const SDL_Rect &rect, std::vector<Uint32> &out) const;
+
+	/**
+	 * Appends the objects containing the point to out
+	 * @return the number of objects appended
+	 */
+	size_t query(float x, float y, std::vector<Uint32> &out) const;
+
+	/**
+	 * Finds the closest object hit by the ray from (x, y) along (dx, dy)
+	 * @param max_distance In lengths of (dx, dy)
+	 * @return false if no object is hit before max_distance
+	 */
+	bool raycast(float x, float y, float dx, float dy, float max_distance, BvhHit &hit) const;
+
+	size_t get_object_count() const { return _objects.size(); }
+	size_t get_node_count() const { return _nodes.size(); }
+
+	/**
+	 * Bounds of an object in pixels, tile objects grow up from their position
+	 */
+	static BvhBounds get_bounds(const MapObject &object);
+
+  private:
+	/**
+	 * Builds the node of the objects between begin and end, and its children
+	 */
+	void build_node(Uint32 begin, Uint32 end, int depth);
+
+	/**
+	 * Appends the objects whose bounds pass test, the nodes failing it are skipped
+	 */
+	template <typename Test> size_t collect(const Test &test, std::vector<Uint32> &out) const;
+
+	std::vector<BvhNode>   _nodes;
+	std::vector<Uint32>    _objects; // leaf order
+	std::vector<BvhBounds> _bounds;  // of _objects
+};
+
+#endif
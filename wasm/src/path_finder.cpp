@@ -0,0 +1,610 @@
+#include "path_finder.h"
+
+#include "thread_pool.h"
+
+namespace {
+	// costs of a move in thousandths of a tile
+	const Uint32 STRAIGHT_COST = 1000;
+	const Uint32 DIAGONAL_COST = 1414;
+
+	/**
+	 * Cost of the shortest path between two tiles on an empty grid
+	 */
+	Uint32 octile_cost(int dx, int dy) {
+		Uint32 x = (Uint32)abs(dx);
+		Uint32 y = (Uint32)abs(dy);
+		return STRAIGHT_COST * std::max(x, y) + (DIAGONAL_COST - STRAIGHT_COST) * std::min(x, y);
+	}
+
+	int sign(int value) {
+		return (value > 0) - (value < 0);
+	}
+
+	// each worker searches with its own memory, the main thread too when there is no worker
+	thread_local PathScratch scratch;
+
+	// the 8 neighbours of a tile, the diagonals at odd indices
+	const int   NEIGHBOUR_X[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+	const int   NEIGHBOUR_Y[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+	const Uint8 NO_DIRECTION   = 8;
+
+	bool is_open(const TileMap &map, int x, int y) {
+		return x >= 0 && y >= 0 && x < map.get_width() && y < map.get_height() && !map.is_solid(x, y);
+	}
+
+	/**
+	 * Whether a move to a neighbour is allowed, the same both ways
+	 */
+	bool can_step(const TileMap &map, int x, int y, int direction) {
+		int dx = NEIGHBOUR_X[direction];
+		int dy = NEIGHBOUR_Y[direction];
+		if (!is_open(map, x + dx, y + dy)) return false;
+		return (direction & 1) == 0 || (is_open(map, x + dx, y) && is_open(map, x, y + dy));
+	}
+
+	Uint32 step_cost(int direction) {
+		return direction & 1 ? DIAGONAL_COST : STRAIGHT_COST;
+	}
+} // namespace
+
+bool path_crosses(const Path &path, size_t first, SDL_Point tile) {
+	for (size_t i = first; i + 1 < path.size(); ++i) {
+		int x  = path[i].x;
+		int y  = path[i].y;
+		int dx = sign(path[i + 1].x - x);
+		int dy = sign(path[i + 1].y - y);
+
+		// the runs between waypoints are straight or diagonal
+		for (;;) {
+			if (x == tile.x && y == tile.y) return true;
+			if (x == path[i + 1].x && y == path[i + 1].y) break;
+			if (dx != 0 && dy != 0 && ((x + dx == tile.x && y == tile.y) || (x == tile.x && y + dy == tile.y))) {
+				return true;
+			}
+			x += dx;
+			y += dy;
+		}
+	}
+	return first < path.size() && path.back().x == tile.x && path.back().y == tile.y;
+}
+
+PathGrid::PathGrid(const TileMap &map)
+    : _width(map.get_width()), _height(map.get_height()), _collision_stride(map.get_collision_stride()) {
+	if (_height > 0 && _collision_stride > 0) {
+		_collision.assign(map.get_collision_row(0), map.get_collision_row(0) + (size_t)_height * _collision_stride);
+	}
+}
+
+void PathScratch::reset(const PathGrid &grid) {
+	size_t tiles = (size_t)grid.get_width() * grid.get_height();
+
+	_grid = &grid;
+	if (_width != grid.get_width() || _height != grid.get_height() || _stamps.size() != tiles) {
+		_width  = grid.get_width();
+		_height = grid.get_height();
+		_stamps.assign(tiles, 0);
+		_g.resize(tiles);
+		_parents.resize(tiles);
+		_closed.resize(tiles);
+		_open.clear();
+		_open.reserve(tiles);
+		_stamp = 0;
+	}
+
+	// the stamps wrapped around, the oldest ones would look current
+	if (++_stamp == 0) {
+		std::fill(_stamps.begin(), _stamps.end(), 0);
+		_stamp = 1;
+	}
+
+	_open.clear();
+	_expanded = 0;
+}
+
+void PathScratch::push(Uint32 tile, Uint32 parent, Uint32 g) {
+	if (_stamps[tile] != _stamp) {
+		_stamps[tile] = _stamp;
+		_closed[tile] = 0;
+	} else if (_closed[tile] || g >= _g[tile]) {
+		return;
+	}
+
+	// a tile reached again more cheaply is pushed again, the old entry is skipped once closed
+	_g[tile]       = g;
+	_parents[tile] = parent;
+	_open.push_back({g + octile_cost(_goal.x - (int)(tile % _width), _goal.y - (int)(tile / _width)), tile});
+	std::push_heap(_open.begin(), _open.end());
+	++_expanded;
+}
+
+bool PathScratch::jump(int x, int y, int dx, int dy, int &jump_x, int &jump_y) const {
+	for (;;) {
+		x += dx;
+		y += dy;
+		if (!is_open(x, y)) return false;
+		if (x == _goal.x && y == _goal.y) break;
+
+		if (dx != 0 && dy != 0) {
+			// a diagonal turns where one of its straight runs would
+			int run_x, run_y;
+			if (jump(x, y, dx, 0, run_x, run_y) || jump(x, y, 0, dy, run_x, run_y)) break;
+
+			// no corner cutting, both sides of the next step must be open
+			if (!is_open(x + dx, y) || !is_open(x, y + dy)) return false;
+		} else if (dx != 0) {
+			// a wall beside the run that just ended opens a way around it
+			if ((is_open(x, y - 1) && !is_open(x - dx, y - 1)) || (is_open(x, y + 1) && !is_open(x - dx, y + 1))) break;
+		} else {
+			if ((is_open(x - 1, y) && !is_open(x - 1, y - dy)) || (is_open(x + 1, y) && !is_open(x + 1, y - dy))) break;
+		}
+	}
+
+	jump_x = x;
+	jump_y = y;
+	return true;
+}
+
+bool PathScratch::find_path(const PathGrid &grid, SDL_Point start, SDL_Point goal, Path &path) {
+	path.clear();
+	reset(grid);
+
+	_goal = goal;
+	if (!is_open(goal.x, goal.y)) return false;
+	if (start.x < 0 || start.y < 0 || start.x >= _width || start.y >= _height) return false;
+
+	Uint32 start_tile = (Uint32)(start.y * _width + start.x);
+	push(start_tile, start_tile, 0);
+
+	while (!_open.empty()) {
+		std::pop_heap(_open.begin(), _open.end());
+		Uint32 tile = _open.back().tile;
+		_open.pop_back();
+
+		if (_closed[tile]) continue;
+		_closed[tile] = 1;
+
+		int x = (int)(tile % _width);
+		int y = (int)(tile / _width);
+		if (x == goal.x && y == goal.y) {
+			for (;;) {
+				path.push_back({(int)(tile % _width), (int)(tile / _width)});
+				if (tile == start_tile) break;
+				tile = _parents[tile];
+			}
+			std::reverse(path.begin(), path.end());
+			return true;
+		}
+
+		// the directions the path can go on in, pruned by the one it came from
+		Uint32 parent = _parents[tile];
+		int    dx     = sign(x - (int)(parent % _width));
+		int    dy     = sign(y - (int)(parent / _width));
+
+		int directions[8][2];
+		int count = 0;
+		auto add  = [&](int direction_x, int direction_y) {
+			directions[count][0] = direction_x;
+			directions[count][1] = direction_y;
+			++count;
+		};
+
+		if (dx == 0 && dy == 0) {
+			for (int ny = -1; ny <= 1; ++ny) {
+				for (int nx = -1; nx <= 1; ++nx) {
+					if (nx == 0 && ny == 0) continue;
+					if (nx != 0 && ny != 0 && (!is_open(x + nx, y) || !is_open(x, y + ny))) continue;
+					add(nx, ny);
+				}
+			}
+		} else if (dx != 0 && dy != 0) {
+			bool horizontal = is_open(x + dx, y);
+			bool vertical   = is_open(x, y + dy);
+			if (vertical) add(0, dy);
+			if (horizontal) add(dx, 0);
+			if (horizontal && vertical) add(dx, dy);
+		} else if (dx != 0) {
+			bool up   = is_open(x, y - 1);
+			bool down = is_open(x, y + 1);
+			if (is_open(x + dx, y)) {
+				add(dx, 0);
+				if (up) add(dx, -1);
+				if (down) add(dx, 1);
+			}
+			if (up) add(0, -1);
+			if (down) add(0, 1);
+		} else {
+			bool left  = is_open(x - 1, y);
+			bool right = is_open(x + 1, y);
+			if (is_open(x, y + dy)) {
+				add(0, dy);
+				if (left) add(-1, dy);
+				if (right) add(1, dy);
+			}
+			if (left) add(-1, 0);
+			if (right) add(1, 0);
+		}
+
+		for (int i = 0; i < count; ++i) {
+			int jump_x, jump_y;
+			if (!jump(x, y, directions[i][0], directions[i][1], jump_x, jump_y)) continue;
+
+			Uint32 g = _g[tile] + octile_cost(jump_x - x, jump_y - y);
+			push((Uint32)(jump_y * _width + jump_x), tile, g);
+		}
+	}
+	return false;
+}
+
+void PathFinder::set_map(const TileMap *map) {
+	auto &finder = PathFinder::get();
+
+	finder._map = map;
+	finder._grid.reset();
+	if (map != nullptr) finder._grid = std::make_shared<const PathGrid>(*map);
+	finder._generation++;
+	finder._cache.clear();
+	finder._cache_lookup.clear();
+
+	// nothing waits forever, the queued requests fail
+	for (const Query &query : finder._queued) {
+		finder._answered.push_back({query.ticket, false, nullptr});
+	}
+	finder._queued.clear();
+}
+
+PathTicket PathFinder::request(SDL_Point start, SDL_Point goal) {
+	auto &finder = PathFinder::get();
+
+	PathTicket ticket = finder._next++;
+	finder._stats.requests++;
+
+	SharedPath path;
+	if (finder.find_cached(cache_key(start, goal), path)) {
+		finder._stats.cache_hits++;
+		finder._answered.push_back({ticket, path != nullptr, path});
+		return ticket;
+	}
+
+	if (finder._grid == nullptr) {
+		finder._answered.push_back({ticket, false, nullptr});
+		return ticket;
+	}
+
+	finder._queued.push_back({ticket, start, goal});
+	return ticket;
+}
+
+void PathFinder::run_batch(Batch &batch) {
+	Path path;
+	for (const Query &query : batch.queries) {
+		PathResult result;
+		result.ticket = query.ticket;
+		result.found  = scratch.find_path(*batch.grid, query.start, query.goal, path);
+		if (result.found) result.path = std::make_shared<const Path>(path);
+		batch.results.push_back(result);
+	}
+}
+
+void PathFinder::finish_batch(std::unique_ptr<Batch> batch, std::vector<PathResult> &results) {
+	_stats.searches += batch->queries.size();
+
+	for (size_t i = 0; i < batch->results.size(); ++i) {
+		PathResult &result = batch->results[i];
+
+		// searched on a map that was replaced since
+		if (batch->generation != _generation) {
+			results.push_back({result.ticket, false, nullptr});
+			continue;
+		}
+
+		const Query &query = batch->queries[i];
+		add_cached(cache_key(query.start, query.goal), result.path);
+		results.push_back(result);
+	}
+
+	batch->grid.reset();
+	batch->queries.clear();
+	batch->results.clear();
+	_spare_batches.push_back(std::move(batch));
+}
+
+void PathFinder::pump(double budget_ms, std::vector<PathResult> &results) {
+	auto        &finder    = PathFinder::get();
+	const Uint64 start     = SDL_GetPerformanceCounter();
+	const double frequency = (double)SDL_GetPerformanceFrequency();
+	auto         elapsed   = [&]() { return (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency; };
+
+	results.insert(results.end(), finder._answered.begin(), finder._answered.end());
+	finder._answered.clear();
+
+	Batch *finished;
+	while (finder._finished.try_pop(finished)) {
+		finder._batches_in_flight--;
+		finder.finish_batch(std::unique_ptr<Batch>(finished), results);
+	}
+
+	// a couple of batches per worker keeps them busy without queueing ahead of the other jobs
+	ThreadPool &pool          = ThreadPool::get();
+	size_t      max_in_flight = std::min(pool.get_thread_count() * 2, (size_t)64);
+
+	size_t next = 0;
+	while (next < finder._queued.size()) {
+		if (pool.has_workers() ? finder._batches_in_flight >= max_in_flight : elapsed() >= budget_ms) break;
+
+		std::unique_ptr<Batch> batch;
+		if (finder._spare_batches.empty()) {
+			batch = std::make_unique<Batch>();
+		} else {
+			batch = std::move(finder._spare_batches.back());
+			finder._spare_batches.pop_back();
+		}
+
+		size_t count      = std::min(finder._queued.size() - next, (size_t)PATH_BATCH_SIZE);
+		batch->grid       = finder._grid;
+		batch->generation = finder._generation;
+		batch->queries.assign(finder._queued.begin() + next, finder._queued.begin() + next + count);
+		next += count;
+
+		if (!pool.has_workers()) {
+			run_batch(*batch);
+			finder.finish_batch(std::move(batch), results);
+			continue;
+		}
+
+		Batch *raw = batch.release();
+		finder._batches_in_flight++;
+		pool.submit([raw]() {
+			run_batch(*raw);
+			while (!PathFinder::get()._finished.try_push(raw)) {
+				std::this_thread::yield();
+			}
+		});
+	}
+	finder._queued.erase(finder._queued.begin(), finder._queued.begin() + next);
+}
+
+void PathFinder::invalidate() {
+	auto &finder = PathFinder::get();
+
+	// the batches still running keep the previous copy alive
+	if (finder._map != nullptr) finder._grid = std::make_shared<const PathGrid>(*finder._map);
+	finder._generation++;
+	finder._cache.clear();
+	finder._cache_lookup.clear();
+}
+
+const PathStats &PathFinder::get_stats() {
+	auto &finder = PathFinder::get();
+
+	finder._stats.queued    = finder._queued.size();
+	finder._stats.in_flight = finder._batches_in_flight;
+	finder._stats.cached    = finder._cache.size();
+	return finder._stats;
+}
+
+bool PathFinder::find_cached(Uint64 key, SharedPath &path) {
+	auto it = _cache_lookup.find(key);
+	if (it == _cache_lookup.end()) return false;
+
+	_cache.splice(_cache.begin(), _cache, it->second);
+	path = it->second->second;
+	return true;
+}
+
+void PathFinder::add_cached(Uint64 key, const SharedPath &path) {
+	auto it = _cache_lookup.find(key);
+	if (it != _cache_lookup.end()) {
+		it->second->second = path;
+		_cache.splice(_cache.begin(), _cache, it->second);
+		return;
+	}
+
+	_cache.emplace_front(key, path);
+	_cache_lookup[key] = _cache.begin();
+
+	if (_cache.size() > PATH_CACHE_SIZE) {
+		_cache_lookup.erase(_cache.back().first);
+		_cache.pop_back();
+	}
+}
+
+void FlowField::build(const TileMap &map, SDL_Point goal) {
+	_width  = map.get_width();
+	_height = map.get_height();
+	_goal   = goal;
+	_costs.assign((size_t)_width * _height, UNREACHABLE);
+	_directions.assign((size_t)_width * _height, NO_DIRECTION);
+
+	_open.clear();
+	if (is_open(map, goal.x, goal.y)) {
+		Uint32 tile  = (Uint32)(goal.y * _width + goal.x);
+		_costs[tile] = 0;
+		_open.push_back({0, tile});
+	}
+	propagate(map, nullptr);
+
+	for (Uint32 tile = 0; tile < _costs.size(); ++tile) {
+		update_direction(map, tile);
+	}
+}
+
+void FlowField::propagate(const TileMap &map, std::vector<Uint32> *changed) {
+	while (!_open.empty()) {
+		std::pop_heap(_open.begin(), _open.end());
+		OpenEntry entry = _open.back();
+		_open.pop_back();
+
+		// a cheaper entry of the tile was already handled
+		if (entry.cost != _costs[entry.tile]) continue;
+
+		int x = (int)(entry.tile % _width);
+		int y = (int)(entry.tile / _width);
+		for (int direction = 0; direction < 8; ++direction) {
+			if (!can_step(map, x, y, direction)) continue;
+
+			Uint32 neighbour = (Uint32)((y + NEIGHBOUR_Y[direction]) * _width + x + NEIGHBOUR_X[direction]);
+			Uint32 cost      = entry.cost + step_cost(direction);
+			if (cost >= _costs[neighbour]) continue;
+
+			_costs[neighbour] = cost;
+			_open.push_back({cost, neighbour});
+			std::push_heap(_open.begin(), _open.end());
+			if (changed != nullptr) changed->push_back(neighbour);
+		}
+	}
+}
+
+Uint32 FlowField::best_cost(const TileMap &map, int x, int y) const {
+	if (x == _goal.x && y == _goal.y) return is_open(map, x, y) ? 0 : UNREACHABLE;
+	if (!is_open(map, x, y)) return UNREACHABLE;
+
+	Uint32 best = UNREACHABLE;
+	for (int direction = 0; direction < 8; ++direction) {
+		if (!can_step(map, x, y, direction)) continue;
+
+		Uint32 cost = _costs[(size_t)(y + NEIGHBOUR_Y[direction]) * _width + x + NEIGHBOUR_X[direction]];
+		if (cost != UNREACHABLE) best = std::min(best, cost + step_cost(direction));
+	}
+	return best;
+}
+
+void FlowField::update_direction(const TileMap &map, Uint32 tile) {
+	int x = (int)(tile % _width);
+	int y = (int)(tile / _width);
+
+	_directions[tile] = NO_DIRECTION;
+	if (_costs[tile] == UNREACHABLE || _costs[tile] == 0) return;
+
+	// the neighbour the distance of the tile comes from
+	for (int direction = 0; direction < 8; ++direction) {
+		if (!can_step(map, x, y, direction)) continue;
+
+		Uint32 cost = _costs[(size_t)(y + NEIGHBOUR_Y[direction]) * _width + x + NEIGHBOUR_X[direction]];
+		if (cost != UNREACHABLE && cost + step_cost(direction) == _costs[tile]) {
+			_directions[tile] = (Uint8)direction;
+			return;
+		}
+	}
+}
+
+size_t FlowField::update_tile(const TileMap &map, int x, int y) {
+	if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+
+	// tiles whose move to the next one went through the changed tile or past its corner
+	_raised.clear();
+	auto raise = [&](Uint32 tile) {
+		_costs[tile]      = UNREACHABLE;
+		_directions[tile] = NO_DIRECTION;
+		_raised.push_back(tile);
+	};
+
+	for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, _height - 1); ++ny) {
+		for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, _width - 1); ++nx) {
+			Uint32 tile      = (Uint32)(ny * _width + nx);
+			Uint8  direction = _directions[tile];
+			bool   broken    = direction != NO_DIRECTION && !can_step(map, nx, ny, direction);
+			if (broken || (nx == x && ny == y && map.is_solid(x, y) && _costs[tile] != UNREACHABLE)) raise(tile);
+		}
+	}
+
+	// then every tile that was moving into a raised one, and so on
+	for (size_t i = 0; i < _raised.size(); ++i) {
+		int rx = (int)(_raised[i] % _width);
+		int ry = (int)(_raised[i] / _width);
+
+		for (int direction = 0; direction < 8; ++direction) {
+			int nx = rx + NEIGHBOUR_X[direction];
+			int ny = ry + NEIGHBOUR_Y[direction];
+			if (nx < 0 || ny < 0 || nx >= _width || ny >= _height) continue;
+
+			Uint32 tile = (Uint32)(ny * _width + nx);
+			Uint8  next = _directions[tile];
+			if (next != NO_DIRECTION && nx + NEIGHBOUR_X[next] == rx && ny + NEIGHBOUR_Y[next] == ry) raise(tile);
+		}
+	}
+
+	// the raised tiles start again from their neighbours that kept their distance
+	std::vector<Uint32> changed = _raised;
+	_open.clear();
+	for (Uint32 tile : _raised) {
+		Uint32 cost = best_cost(map, (int)(tile % _width), (int)(tile / _width));
+		if (cost == UNREACHABLE) continue;
+
+		_costs[tile] = cost;
+		_open.push_back({cost, tile});
+	}
+
+	// an opened tile, or the diagonals it unblocked, may shorten the way of its neighbours
+	Uint32 center = (Uint32)(y * _width + x);
+	if (!map.is_solid(x, y)) {
+		Uint32 cost = best_cost(map, x, y);
+		if (cost < _costs[center]) {
+			_costs[center] = cost;
+			changed.push_back(center);
+		}
+
+		for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, _height - 1); ++ny) {
+			for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, _width - 1); ++nx) {
+				Uint32 tile = (Uint32)(ny * _width + nx);
+				if (_costs[tile] != UNREACHABLE) _open.push_back({_costs[tile], tile});
+			}
+		}
+	}
+	std::make_heap(_open.begin(), _open.end());
+	propagate(map, &changed);
+
+	// a changed distance can change the direction of the tile and of its neighbours
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+	for (Uint32 tile : changed) {
+		int tx = (int)(tile % _width);
+		int ty = (int)(tile / _width);
+		for (int ny = std::max(ty - 1, 0); ny <= std::min(ty + 1, _height - 1); ++ny) {
+			for (int nx = std::max(tx - 1, 0); nx <= std::min(tx + 1, _width - 1); ++nx) {
+				update_direction(map, (Uint32)(ny * _width + nx));
+			}
+		}
+	}
+	return changed.size();
+}
+
+bool FlowField::get_next(int x, int y, SDL_Point &next) const {
+	if (x < 0 || y < 0 || x >= _width || y >= _height) return false;
+
+	Uint8 direction = _directions[(size_t)y * _width + x];
+	if (direction == NO_DIRECTION) return false;
+
+	next = {x + NEIGHBOUR_X[direction], y + NEIGHBOUR_Y[direction]};
+	return true;
+}
+
+const FlowField &FlowFieldCache::get(const TileMap &map, SDL_Point goal) {
+	for (auto it = _fields.begin(); it != _fields.end(); ++it) {
+		SDL_Point field_goal = (*it)->get_goal();
+		if (field_goal.x != goal.x || field_goal.y != goal.y) continue;
+
+		_fields.splice(_fields.begin(), _fields, it);
+		return *_fields.front();
+	}
+
+	std::unique_ptr<FlowField> field;
+	if (_fields.size() >= FLOW_FIELD_CACHE_SIZE) {
+		field = std::move(_fields.back());
+		_fields.pop_back();
+	} else {
+		field = std::make_unique<FlowField>();
+	}
+
+	field->build(map, goal);
+	_builds++;
+	_fields.push_front(std::move(field));
+	return *_fields.front();
+}
+
+size_t FlowFieldCache::update_tile(const TileMap &map, int x, int y) {
+	size_t changed = 0;
+	for (auto &field : _fields) {
+		changed += field->update_tile(map, x, y);
+	}
+	return changed;
+}
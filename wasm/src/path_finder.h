@@ -0,0 +1,299 @@
+#ifndef PATH_FINDER_H
+#define PATH_FINDER_H
+
+#pragma once
+
+#include "includes.h"
+#include "lock_free_queue.h"
+#include "tile_map.h"
+
+#include <list>
+#include <unordered_map>
+
+/**
+ * Paths on the tile grid of a map, between the tiles that are not solid.
+ *
+ * Searches are A* with jump point search: straight and diagonal runs are
+ * scanned without being added to the open list, only the tiles where the
+ * path may turn are. Diagonal moves never cut the corner of a solid tile.
+ *
+ * Crowds heading to the same tile share a flow field instead: the distance
+ * of every tile to the goal, and the neighbour each tile should move to.
+ */
+
+typedef std::vector<SDL_Point>      Path; // tiles where the path turns, the start and the goal included
+typedef std::shared_ptr<const Path> SharedPath;
+typedef Uint32                      PathTicket;
+
+/**
+ * Whether the moves of the path from its waypoint first on go through the
+ * tile, or cut its corner diagonally
+ */
+bool path_crosses(const Path &path, size_t first, SDL_Point tile);
+
+/**
+ * Solid tiles of a map copied for the searches, which the game can change
+ * while the workers read the copy
+ */
+class PathGrid {
+  public:
+	explicit PathGrid(const TileMap &map);
+
+	int get_width() const { return _width; }
+	int get_height() const { return _height; }
+
+	bool is_solid(int x, int y) const {
+		if (_collision.empty()) return false;
+		return (_collision[(size_t)y * _collision_stride + x / 64] >> (x % 64)) & 1;
+	}
+
+  private:
+	int                 _width            = 0;
+	int                 _height           = 0;
+	int                 _collision_stride = 0;
+	std::vector<Uint64> _collision;
+};
+
+/**
+ * Memory of one search, sized to the map and reused by the next searches of
+ * the same thread. A tile's entries are only valid when its stamp is the one
+ * of the current search, so nothing is cleared between searches.
+ */
+class PathScratch {
+  public:
+	/**
+	 * Finds a path from start to goal on the tiles of the grid that are not solid
+	 * @return false if the goal is solid, outside of the grid or cannot be reached
+	 */
+	bool find_path(const PathGrid &grid, SDL_Point start, SDL_Point goal, Path &path);
+
+	/**
+	 * Tiles added to the open list by the last search
+	 */
+	size_t get_expanded() const { return _expanded; }
+
+  private:
+	struct OpenEntry {
+		Uint32 f;
+		Uint32 tile;
+
+		bool operator<(const OpenEntry &other) const { return f > other.f; } // smallest f on top
+	};
+
+	void reset(const PathGrid &grid);
+	void push(Uint32 tile, Uint32 parent, Uint32 g);
+
+	bool is_open(int x, int y) const { return x >= 0 && y >= 0 && x < _width && y < _height && !_grid->is_solid(x, y); }
+
+	/**
+	 * Runs from (x, y) towards (dx, dy) until a tile where the path may turn
+	 * @return false if the run ends against a solid tile or the map edge
+	 */
+	bool jump(int x, int y, int dx, int dy, int &jump_x, int &jump_y) const;
+
+	const PathGrid *_grid   = nullptr;
+	int             _width  = 0;
+	int             _height = 0;
+	SDL_Point       _goal   = {0, 0};
+
+	std::vector<Uint32>    _stamps;
+	std::vector<Uint32>    _g;
+	std::vector<Uint32>    _parents;
+	std::vector<Uint8>     _closed;
+	std::vector<OpenEntry> _open; // binary heap, reserved once per map size
+	Uint32                 _stamp    = 0;
+	size_t                 _expanded = 0;
+};
+
+struct PathResult {
+	PathTicket ticket = 0;
+	bool       found  = false;
+	SharedPath path; // null when not found
+};
+
+struct PathStats {
+	Uint64 requests   = 0;
+	Uint64 cache_hits = 0;
+	Uint64 searches   = 0;
+	size_t queued     = 0;
+	size_t in_flight  = 0; // batches handed to the workers
+	size_t cached     = 0;
+};
+
+/**
+ * Serves path requests of the game: answered at once from an LRU cache of
+ * recent paths keyed by their start and goal, searched otherwise. Searches
+ * are grouped in batches of PATH_BATCH_SIZE run by the thread pool, each
+ * worker with its own scratch. Without workers the batches run on the main
+ * thread in pump(), within its time budget.
+ */
+class PathFinder {
+  public:
+	static PathFinder &get() {
+		static PathFinder instance;
+		return instance;
+	}
+
+	/**
+	 * Sets the map of the next searches and empties the cache, the searches
+	 * still running for the previous map are dropped. The searches read a
+	 * copy of its solid tiles.
+	 */
+	static void set_map(const TileMap *map);
+
+	/**
+	 * Call after changing tiles of the map: copies its solid tiles again and
+	 * empties the cache, the searches still running are answered as not found
+	 */
+	static void invalidate();
+
+	/**
+	 * Queues a search between two tiles, its result comes out of pump()
+	 */
+	static PathTicket request(SDL_Point start, SDL_Point goal);
+
+	/**
+	 * Collects the finished searches into results, then hands the queued
+	 * ones to the workers, or runs them until budget_ms is spent without
+	 * workers
+	 */
+	static void pump(double budget_ms, std::vector<PathResult> &results);
+
+	static const PathStats &get_stats();
+
+  private:
+	struct Query {
+		PathTicket ticket;
+		SDL_Point  start;
+		SDL_Point  goal;
+	};
+
+	struct Batch {
+		std::shared_ptr<const PathGrid> grid;
+		Uint32                          generation;
+		std::vector<Query>              queries;
+		std::vector<PathResult>         results;
+	};
+
+	static Uint64 cache_key(SDL_Point start, SDL_Point goal) {
+		return (Uint64)(Uint16)start.x | (Uint64)(Uint16)start.y << 16 | (Uint64)(Uint16)goal.x << 32 |
+		       (Uint64)(Uint16)goal.y << 48;
+	}
+
+	static void run_batch(Batch &batch);
+	void        finish_batch(std::unique_ptr<Batch> batch, std::vector<PathResult> &results);
+
+	bool find_cached(Uint64 key, SharedPath &path);
+	void add_cached(Uint64 key, const SharedPath &path);
+
+	const TileMap                  *_map = nullptr;
+	std::shared_ptr<const PathGrid> _grid; // shared with the batches searching it
+	Uint32                          _generation = 0;
+	PathTicket                      _next       = 1;
+
+	std::vector<Query>                  _queued;
+	std::vector<PathResult>             _answered; // without a search, handed out by the next pump()
+	LockFreeQueue<Batch *, 64>          _finished;
+	size_t                              _batches_in_flight = 0;
+	std::vector<std::unique_ptr<Batch>> _spare_batches;
+
+	// most recently used first, a null path for a goal that cannot be reached
+	typedef std::list<std::pair<Uint64, SharedPath>> CacheList;
+	CacheList                                        _cache;
+	std::unordered_map<Uint64, CacheList::iterator>  _cache_lookup;
+
+	PathStats _stats;
+};
+
+/**
+ * Distances to a goal tile integrated over the whole map with Dijkstra, and
+ * the next tile towards the goal for each tile, read in O(1) by any number
+ * of agents. A tile that changes is repaired in place: the tiles that went
+ * through it are raised, then the distances are propagated again from their
+ * edges, leaving the rest of the field untouched.
+ */
+class FlowField {
+  public:
+	static constexpr Uint32 UNREACHABLE = 0xFFFFFFFFu;
+
+	void build(const TileMap &map, SDL_Point goal);
+
+	/**
+	 * Repairs the field after the tile at (x, y) became solid or open
+	 * @return the number of tiles whose distance changed
+	 */
+	size_t update_tile(const TileMap &map, int x, int y);
+
+	/**
+	 * @return false at the goal and on the tiles that cannot reach it
+	 */
+	bool get_next(int x, int y, SDL_Point &next) const;
+
+	/**
+	 * @return the distance to the goal in thousandths of a tile, UNREACHABLE if it cannot be reached
+	 */
+	Uint32 get_cost(int x, int y) const { return _costs[(size_t)y * _width + x]; }
+
+	SDL_Point get_goal() const { return _goal; }
+
+  private:
+	struct OpenEntry {
+		Uint32 cost;
+		Uint32 tile;
+
+		bool operator<(const OpenEntry &other) const { return cost > other.cost; }
+	};
+
+	/**
+	 * Runs Dijkstra from the tiles in the open list
+	 */
+	void propagate(const TileMap &map, std::vector<Uint32> *changed);
+
+	/**
+	 * Points the tile to the neighbour it is the closest to the goal through
+	 */
+	void update_direction(const TileMap &map, Uint32 tile);
+
+	/**
+	 * @return the cheapest cost of the tile through its neighbours
+	 */
+	Uint32 best_cost(const TileMap &map, int x, int y) const;
+
+	int       _width  = 0;
+	int       _height = 0;
+	SDL_Point _goal   = {0, 0};
+
+	std::vector<Uint32>    _costs;
+	std::vector<Uint8>     _directions; // index of the neighbour to move to, 8 for none
+	std::vector<OpenEntry> _open;
+	std::vector<Uint32>    _raised;
+};
+
+/**
+ * Flow fields of the last FLOW_FIELD_CACHE_SIZE goals, the least recently
+ * used one is dropped for a new goal
+ */
+class FlowFieldCache {
+  public:
+	/**
+	 * @return the field towards goal, integrated the first time, valid until
+	 * the next call
+	 */
+	const FlowField &get(const TileMap &map, SDL_Point goal);
+
+	/**
+	 * Repairs every field after the tile at (x, y) became solid or open
+	 * @return the number of tiles whose distance changed, in all the fields
+	 */
+	size_t update_tile(const TileMap &map, int x, int y);
+
+	void clear() { _fields.clear(); }
+
+	Uint64 get_builds() const { return _builds; }
+
+  private:
+	std::list<std::unique_ptr<FlowField>> _fields; // most recently used first
+	Uint64                                _builds = 0;
+};
+
+#endif
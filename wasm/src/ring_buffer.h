@@ -0,0 +1,69 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Fixed capacity FIFO for a single thread, nothing is allocated once it is
+ * constructed. See LockFreeQueue when producers and consumers are threads.
+ * @tparam T The element type, must be default constructible
+ * @tparam Capacity Number of elements, must be a power of two
+ */
+template<typename T, size_t Capacity>
+class RingBuffer {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  public:
+	/**
+	 * @return false if the buffer is full, the value is dropped
+	 */
+	bool try_push(const T& value) {
+		if (full()) return false;
+		_items[_tail++ & (Capacity - 1)] = value;
+		return true;
+	}
+
+	/**
+	 * Pushes the value, dropping the oldest one if the buffer is full
+	 */
+	void push_overwrite(const T& value) {
+		if (full()) ++_head;
+		_items[_tail++ & (Capacity - 1)] = value;
+	}
+
+	/**
+	 * @return false if the buffer is empty
+	 */
+	bool try_pop(T& value) {
+		if (empty()) return false;
+		value = _items[_head++ & (Capacity - 1)];
+		return true;
+	}
+
+	/**
+	 * @param index 0 is the oldest element
+	 */
+	const T& operator[](size_t index) const { return _items[(_head + index) & (Capacity - 1)]; }
+
+	/**
+	 * The newest element, the buffer must not be empty
+	 */
+	T& back() { return _items[(_tail - 1) & (Capacity - 1)]; }
+
+	void clear() { _head = _tail = 0; }
+
+	size_t size() const { return _tail - _head; }
+	bool   empty() const { return _head == _tail; }
+	bool   full() const { return size() == Capacity; }
+
+	static constexpr size_t capacity() { return Capacity; }
+
+  private:
+	T      _items[Capacity];
+	size_t _head = 0;
+	size_t _tail = 0;
+};
+
+#endif
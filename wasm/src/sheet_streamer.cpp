@@ -0,0 +1,175 @@
+#include "sheet_streamer.h"
+
+SheetStreamer::SheetStreamer() {}
+
+SheetStreamer::~SheetStreamer() {
+	for (auto &[path, sheet] : _sheets) {
+		for (Tile &tile : sheet.tiles) SDL_FreeSurface(tile.surface);
+		for (auto &[variant, palette] : sheet.palettes) SDL_FreePalette(palette);
+	}
+}
+
+SheetStreamer::Sheet &SheetStreamer::get_sheet(const std::string &path, std::string &variant) {
+	std::string file;
+	AssetManager::split_variant(path, file, variant);
+
+	// tiles of an indexed sheet are shared by its variants, anything else
+	// is decoded with the variant applied
+	const CookedTextureHeader *cooked = AssetManager::find_cooked_texture(file);
+	const Uint32               flags  = cooked != nullptr ? cooked->flags : 0;
+	bool                       shared = (flags & COOKED_TILED) && (flags & COOKED_INDEXED);
+	if (!shared) variant.clear();
+
+	const std::string &key = shared ? file : path;
+	auto               it  = _sheets.find(key);
+	if (it != _sheets.end()) return it->second;
+
+	Sheet sheet;
+	if (cooked != nullptr) sheet.premultiplied = (cooked->flags & COOKED_PREMULTIPLIED) != 0;
+	if (cooked != nullptr && (cooked->flags & COOKED_TILED)) {
+		sheet.cooked  = cooked;
+		sheet.columns = (int)AssetManager::get_cooked_columns(cooked);
+		sheet.rows    = (int)AssetManager::get_cooked_rows(cooked);
+	}
+	sheet.tiles.resize(sheet.columns * sheet.rows);
+
+	return _sheets.emplace(key, std::move(sheet)).first->second;
+}
+
+SDL_Palette *SheetStreamer::get_palette(Sheet &sheet, const std::string &variant) {
+	if (sheet.cooked == nullptr || !(sheet.cooked->flags & COOKED_INDEXED)) return nullptr;
+
+	auto it = sheet.palettes.find(variant);
+	if (it != sheet.palettes.end()) return it->second;
+
+	const CookedPalette *colors = AssetManager::find_cooked_palette(sheet.cooked, variant);
+	if (colors == nullptr) {
+		printf("SheetStreamer::get_palette() - Unknown variant: %s\n", variant.c_str());
+		colors = AssetManager::find_cooked_palette(sheet.cooked, "");
+	}
+
+	SDL_Palette *palette = SDL_AllocPalette(256);
+	if (palette != nullptr) SDL_SetPaletteColors(palette, (const SDL_Color *)colors->colors, 0, 256);
+
+	sheet.palettes[variant] = palette;
+	return palette;
+}
+
+void SheetStreamer::get_tile_range(const Sheet &sheet, const SDL_Rect &rect, SDL_Rect &range) {
+	if (sheet.cooked == nullptr) {
+		range = {0, 0, 1, 1};
+		return;
+	}
+
+	int size = (int)sheet.cooked->tile_size;
+	int x0   = std::max(rect.x, 0) / size;
+	int y0   = std::max(rect.y, 0) / size;
+	int x1   = std::min((rect.x + rect.w - 1) / size, sheet.columns - 1);
+	int y1   = std::min((rect.y + rect.h - 1) / size, sheet.rows - 1);
+	range    = {x0, y0, std::max(x1 - x0 + 1, 0), std::max(y1 - y0 + 1, 0)};
+}
+
+SDL_Surface *SheetStreamer::load_tile(const std::string &path, Sheet &sheet, int column, int row) {
+	Tile &tile = sheet.tiles[row * sheet.columns + column];
+	if (tile.surface != nullptr) return tile.surface;
+
+	if (sheet.cooked != nullptr) {
+		tile.surface = AssetManager::load_cooked_tile(sheet.cooked, column, row);
+	} else {
+		tile.surface = AssetManager::load_surface(path, SDL_PIXELFORMAT_RGBA32, &sheet.premultiplied);
+	}
+	if (tile.surface == nullptr) {
+		printf("SheetStreamer::load_tile() - Failed to load tile %d,%d of %s\n", column, row, path.c_str());
+		return nullptr;
+	}
+
+	SDL_SetSurfaceBlendMode(tile.surface, SDL_BLENDMODE_NONE);
+	_resident_tiles++;
+	_resident_bytes += (size_t)tile.surface->pitch * tile.surface->h;
+
+	return tile.surface;
+}
+
+void SheetStreamer::unload_tile(Tile &tile) {
+	if (tile.surface == nullptr) return;
+
+	_resident_tiles--;
+	_resident_bytes -= (size_t)tile.surface->pitch * tile.surface->h;
+	SDL_FreeSurface(tile.surface);
+	tile.surface = nullptr;
+}
+
+void SheetStreamer::retain(const std::string &path, const SDL_Rect &rect) {
+	auto       &streamer = get();
+	std::string variant;
+	Sheet      &sheet = streamer.get_sheet(path, variant);
+
+	SDL_Rect range;
+	get_tile_range(sheet, rect, range);
+	for (int row = range.y; row < range.y + range.h; ++row) {
+		for (int column = range.x; column < range.x + range.w; ++column) {
+			sheet.tiles[row * sheet.columns + column].ref_count++;
+		}
+	}
+}
+
+void SheetStreamer::release(const std::string &path, const SDL_Rect &rect) {
+	auto       &streamer = get();
+	std::string variant;
+	Sheet      &sheet = streamer.get_sheet(path, variant);
+
+	SDL_Rect range;
+	get_tile_range(sheet, rect, range);
+	for (int row = range.y; row < range.y + range.h; ++row) {
+		for (int column = range.x; column < range.x + range.w; ++column) {
+			Tile &tile = sheet.tiles[row * sheet.columns + column];
+			if (tile.ref_count > 0 && --tile.ref_count == 0) streamer.unload_tile(tile);
+		}
+	}
+}
+
+bool SheetStreamer::is_premultiplied(const std::string &path) {
+	std::string variant;
+	return get().get_sheet(path, variant).premultiplied;
+}
+
+SDL_Surface *SheetStreamer::read(const std::string &path, const SDL_Rect &rect) {
+	auto        &streamer = get();
+	std::string  variant;
+	Sheet       &sheet    = streamer.get_sheet(path, variant);
+	SDL_Palette *palette  = streamer.get_palette(sheet, variant);
+
+	SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, rect.w, rect.h, 32, SDL_PIXELFORMAT_RGBA32);
+	if (surface == nullptr) return nullptr;
+
+	int      tile_size = sheet.cooked != nullptr ? (int)sheet.cooked->tile_size : 0;
+	SDL_Rect range;
+	get_tile_range(sheet, rect, range);
+
+	for (int row = range.y; row < range.y + range.h; ++row) {
+		for (int column = range.x; column < range.x + range.w; ++column) {
+			SDL_Surface *tile = streamer.load_tile(path, sheet, column, row);
+			if (tile == nullptr) {
+				SDL_FreeSurface(surface);
+				return nullptr;
+			}
+
+			// copy the part of the tile inside rect, in sheet coordinates first
+			SDL_Rect tile_rect = {column * tile_size, row * tile_size, tile->w, tile->h};
+			SDL_Rect overlap;
+			if (SDL_IntersectRect(&tile_rect, &rect, &overlap)) {
+				SDL_Rect src = {overlap.x - tile_rect.x, overlap.y - tile_rect.y, overlap.w, overlap.h};
+				SDL_Rect dst = {overlap.x - rect.x, overlap.y - rect.y, overlap.w, overlap.h};
+				if (palette != nullptr) SDL_SetSurfacePalette(tile, palette);
+				SDL_BlitSurface(tile, &src, surface, &dst);
+			}
+
+			// read without being retained, nobody keeps the tile around
+			if (sheet.tiles[row * sheet.columns + column].ref_count == 0) {
+				streamer.unload_tile(sheet.tiles[row * sheet.columns + column]);
+			}
+		}
+	}
+
+	return surface;
+}
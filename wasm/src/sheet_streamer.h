@@ -0,0 +1,88 @@
+#ifndef SHEET_STREAMER_H
+#define SHEET_STREAMER_H
+
+#pragma once
+
+#include "asset_manager.h"
+
+/**
+ * Gives access to parts of large spritesheets without decoding them whole.
+ *
+ * Sheets cooked with "tiles=N" are decoded one tile at a time, a tile stays
+ * in memory while a region retaining it is alive. Any other image behaves
+ * as a sheet made of a single tile.
+ *
+ * Paths may name a palette variant ("<sheet>#shiny"), the variants of an
+ * indexed sheet share its tiles and only differ by the palette they are
+ * read with.
+ */
+class SheetStreamer {
+  public:
+	SheetStreamer();
+	~SheetStreamer();
+
+	SheetStreamer(const SheetStreamer &)            = delete;
+	SheetStreamer &operator=(const SheetStreamer &) = delete;
+
+	static SheetStreamer &get() {
+		static SheetStreamer instance;
+		return instance;
+	}
+
+	/**
+	 * Keeps the tiles covered by rect in memory until release() is called
+	 * with the same rect
+	 */
+	static void retain(const std::string &path, const SDL_Rect &rect);
+	static void release(const std::string &path, const SDL_Rect &rect);
+
+	/**
+	 * Copies rect out of the sheet, decoding the tiles it covers.
+	 * Texels outside of the sheet are transparent.
+	 * @return an RGBA32 surface the caller frees, nullptr on failure
+	 */
+	static SDL_Surface *read(const std::string &path, const SDL_Rect &rect);
+
+	/**
+	 * Only known for certain once a part of the sheet was read
+	 */
+	static bool is_premultiplied(const std::string &path);
+
+	static size_t get_resident_tiles() { return get()._resident_tiles; }
+	static size_t get_resident_bytes() { return get()._resident_bytes; }
+
+  private:
+	struct Tile {
+		SDL_Surface *surface   = nullptr;
+		int          ref_count = 0;
+	};
+
+	struct Sheet {
+		const CookedTextureHeader *cooked = nullptr; // nullptr when not tiled
+		int                        columns       = 1;
+		int                        rows          = 1;
+		bool                       premultiplied = false;
+		std::vector<Tile>          tiles;
+
+		std::map<std::string, SDL_Palette *> palettes; // per variant, indexed sheets only
+	};
+
+	/**
+	 * @param variant Set to the palette variant the path names, if the sheet has palettes
+	 */
+	Sheet       &get_sheet(const std::string &path, std::string &variant);
+	SDL_Palette *get_palette(Sheet &sheet, const std::string &variant);
+	SDL_Surface *load_tile(const std::string &path, Sheet &sheet, int column, int row);
+	void         unload_tile(Tile &tile);
+
+	/**
+	 * Tiles overlapping rect, as a column and row range
+	 */
+	static void get_tile_range(const Sheet &sheet, const SDL_Rect &rect, SDL_Rect &range);
+
+	std::map<std::string, Sheet> _sheets;
+	size_t                       _resident_tiles = 0;
+	size_t                       _resident_bytes = 0;
+};
+
+#endif
@@ -2,10 +2,10 @@
 
 #include <SDL_render.h>
 
-Sprite::Sprite(SDL_Texture& texture, const SDL_Rect& frame_rect, const SDL_Rect& world_rect)
+Sprite::Sprite(TextureHandle texture, const SDL_Rect& frame_rect, const SDL_Rect& world_rect)
     : _texture(texture), _frame_rect(frame_rect), _bounding_rect(world_rect) {}
 
-Sprite::Sprite(SDL_Texture& texture, const SDL_Rect& frame_rect, int x, int y, int w, int h)
+Sprite::Sprite(TextureHandle texture, const SDL_Rect& frame_rect, int x, int y, int w, int h)
     : _texture(texture), _frame_rect(frame_rect) {
 	_bounding_rect.x = x;
 	_bounding_rect.y = y;
@@ -14,19 +14,42 @@ Sprite::Sprite(SDL_Texture& texture, const SDL_Rect& frame_rect, int x, int y, i
 }
 
 Sprite::Sprite(const Sprite& other)
-    : _texture(other._texture), _frame_rect(other._frame_rect), _bounding_rect(other._bounding_rect),
-      _animation_controller(other._animation_controller), _direction(other._direction) {}
+    : _texture(other._texture), _frame_texture(other._frame_texture), _frame_rect(other._frame_rect),
+      _frame_trim(other._frame_trim), _frame_flipped(other._frame_flipped), _bounding_rect(other._bounding_rect),
+      _hitbox(other._hitbox), _subpixel(other._subpixel), _animation_controller(other._animation_controller),
+      _direction(other._direction) {}
 
 void Sprite::render(SDL_Renderer* renderer) {
 	if (renderer == NULL) return;
 
-	SDL_RenderCopy(renderer, &_texture, &_frame_rect, &_bounding_rect);
+	SDL_Texture* texture = _frame_texture ? _frame_texture : AssetManager::get_texture(_texture);
+	if (texture == NULL) return;
+
+	// trimmed frames only cover part of the bounding rect, mirrored with the frame
+	SDL_Rect destination = _bounding_rect;
+	if (_frame_trim.w > 0 && _frame_trim.h > 0) {
+		int offset_x = _frame_flipped ? _frame_trim.w - _frame_trim.x - _frame_rect.w : _frame_trim.x;
+		destination.x += offset_x * _bounding_rect.w / _frame_trim.w;
+		destination.y += _frame_trim.y * _bounding_rect.h / _frame_trim.h;
+		destination.w = _frame_rect.w * _bounding_rect.w / _frame_trim.w;
+		destination.h = _frame_rect.h * _bounding_rect.h / _frame_trim.h;
+	}
+
+	if (_frame_flipped) {
+		SDL_RenderCopyEx(renderer, texture, &_frame_rect, &destination, 0.0, nullptr, SDL_FLIP_HORIZONTAL);
+	} else {
+		SDL_RenderCopy(renderer, texture, &_frame_rect, &destination);
+	}
 }
 
 void Sprite::update(float delta_time) {
 	if (_animation_controller.has_animations()) {
 		_animation_controller.update(delta_time);
-		_frame_rect = _animation_controller.get_current_frame().rect;
+		const AnimationFrame& frame = _animation_controller.get_current_frame();
+		_frame_rect                 = frame.rect;
+		_frame_texture              = frame.texture;
+		_frame_trim                 = frame.trim;
+		_frame_flipped              = frame.is_flipped;
 	}
 }
 
@@ -35,9 +58,24 @@ void Sprite::move(int x, int y) {
 	_bounding_rect.y += y;
 }
 
+bool Sprite::slide(float x, float y, const TileMap& map) {
+	SDL_Rect  hitbox = get_hitbox();
+	SDL_FRect box    = {hitbox.x + _subpixel.x, hitbox.y + _subpixel.y, (float)hitbox.w, (float)hitbox.h};
+	TileSweep sweep  = map.sweep(box, x, y);
+
+	float moved_x = floorf(sweep.x);
+	float moved_y = floorf(sweep.y);
+	_bounding_rect.x += (int)moved_x - hitbox.x;
+	_bounding_rect.y += (int)moved_y - hitbox.y;
+	_subpixel = Vector2f(sweep.x - moved_x, sweep.y - moved_y);
+
+	return sweep.blocked_x || sweep.blocked_y;
+}
+
 void Sprite::set_position(int x, int y) {
 	_bounding_rect.x = x;
 	_bounding_rect.y = y;
+	_subpixel        = Vector2f(0, 0);
 }
 
 void Sprite::set_size(int w, int h) {
@@ -45,14 +83,20 @@ void Sprite::set_size(int w, int h) {
 	_bounding_rect.h = h;
 }
 
+SDL_Rect Sprite::get_hitbox() const {
+	if (_hitbox.w <= 0 || _hitbox.h <= 0) return _bounding_rect;
+	return {_bounding_rect.x + _hitbox.x, _bounding_rect.y + _hitbox.y, _hitbox.w, _hitbox.h};
+}
+
 bool Sprite::is_colliding(const Sprite& other) const {
 	return is_colliding(other._bounding_rect);
 }
 
 bool Sprite::is_colliding(const SDL_Rect& rect) const {
 	// AABB collision detection
-	return _bounding_rect.x < rect.x + rect.w && _bounding_rect.x + _bounding_rect.w > rect.x &&
-	       _bounding_rect.y < rect.y + rect.h && _bounding_rect.y + _bounding_rect.h > rect.y;
+	SDL_Rect hitbox = get_hitbox();
+	return hitbox.x < rect.x + rect.w && hitbox.x + hitbox.w > rect.x && hitbox.y < rect.y + rect.h &&
+	       hitbox.y + hitbox.h > rect.y;
 }
 
 void Sprite::handle_collision(const Sprite& other) {
@@ -60,27 +104,37 @@ void Sprite::handle_collision(const Sprite& other) {
 }
 
 void Sprite::handle_collision(const SDL_Rect& rect) {
+	Vector2i push = get_collision_push(rect);
+	_bounding_rect.x += push.x;
+	_bounding_rect.y += push.y;
+	_subpixel = Vector2f(0, 0);
+}
+
+void Sprite::handle_collision(const SDL_Rect& rect, const TileMap& map) {
+	// swept like any move, the push never ends in a solid tile
+	Vector2i push = get_collision_push(rect);
+	_subpixel     = Vector2f(0, 0);
+	slide((float)push.x, (float)push.y, map);
+}
+
+Vector2i Sprite::get_collision_push(const SDL_Rect& rect) const {
 	// Calculate the minimum translation vector (MTV)
-	int dx = 0, dy = 0;
+	SDL_Rect hitbox = get_hitbox();
+	int      dx = 0, dy = 0;
 
-	if (_bounding_rect.x < rect.x) {
-		dx = rect.x - (_bounding_rect.x + _bounding_rect.w);
+	if (hitbox.x < rect.x) {
+		dx = rect.x - (hitbox.x + hitbox.w);
 	} else {
-		dx = rect.x + rect.w - _bounding_rect.x;
+		dx = rect.x + rect.w - hitbox.x;
 	}
 
-	if (_bounding_rect.y < rect.y) {
-		dy = rect.y - (_bounding_rect.y + _bounding_rect.h);
+	if (hitbox.y < rect.y) {
+		dy = rect.y - (hitbox.y + hitbox.h);
 	} else {
-		dy = rect.y + rect.h - _bounding_rect.y;
+		dy = rect.y + rect.h - hitbox.y;
 	}
 
-	// Move the sprite out of the collision by adjusting its position
-	if (abs(dx) < abs(dy)) {
-		// Adjust horizontally
-		_bounding_rect.x += dx;
-	} else {
-		// Adjust vertically
-		_bounding_rect.y += dy;
-	}
+	// Move the sprite out of the collision along the shortest axis
+	if (abs(dx) < abs(dy)) return Vector2i(dx, 0);
+	return Vector2i(0, dy);
 }
\ No newline at end of file
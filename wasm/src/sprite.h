@@ -1,13 +1,14 @@
 #pragma once
 
 #include "animation_controller.h"
+#include "tile_map.h"
 
 #include <functional>
 
 class Sprite {
   public:
-	Sprite(SDL_Texture& texture, const SDL_Rect& frame_rect, const SDL_Rect& world_rect);
-	Sprite(SDL_Texture& texture, const SDL_Rect& frame_rect, int x, int y, int w, int h);
+	Sprite(TextureHandle texture, const SDL_Rect& frame_rect, const SDL_Rect& world_rect);
+	Sprite(TextureHandle texture, const SDL_Rect& frame_rect, int x, int y, int w, int h);
 	Sprite(const Sprite& other);
 	virtual ~Sprite() = default;
 
@@ -16,6 +17,14 @@ class Sprite {
 
 	virtual void move(int x, int y);
 
+	/**
+	 * Moves the hitbox through the solid tiles of the map, it stops against
+	 * them and slides along them. The fraction of a pixel left is kept for the
+	 * next move.
+	 * @return true if a solid tile or the map edge stopped the move
+	 */
+	bool slide(float x, float y, const TileMap& map);
+
 	void set_position(int x, int y);
 	void set_size(int w, int h);
 
@@ -31,11 +40,20 @@ class Sprite {
 
 	void set_speed(float speed) { _speed = speed; }
 
+	void set_texture(TextureHandle texture) { _texture = texture; }
+
 	void set_is_moving(bool is_moving) { _is_moving = is_moving; }
 	bool get_is_moving() const { return _is_moving; }
 
 	const SDL_Rect& get_frame_rect() const { return _frame_rect; }
 	const SDL_Rect& get_bounding_rect() const { return _bounding_rect; }
+
+	/**
+	 * Part of the bounding rect that collides, with the map and in the
+	 * collision methods, relative to it, the whole rect when empty
+	 */
+	void     set_hitbox(const SDL_Rect& hitbox) { _hitbox = hitbox; }
+	SDL_Rect get_hitbox() const;
 	// TODO: use a variable for the tile size
 	Vector2i get_coords() const { return Vector2i(_bounding_rect.x / TILE_SIZE, _bounding_rect.y / TILE_SIZE); }
 
@@ -44,56 +62,26 @@ class Sprite {
 
 	void handle_collision(const Sprite& other);
 	void handle_collision(const SDL_Rect& rect);
+	/**
+	 * Pushes the hitbox out of the rect through the solid tiles of the map,
+	 * a push blocked by them leaves the hitbox short of the rect's edge
+	 */
+	void handle_collision(const SDL_Rect& rect, const TileMap& map);
 
 	AnimationController& get_animation_controller() { return _animation_controller; }
 
 	Direction get_direction() const { return _direction; }
 	void      set_direction(Direction direction) { _direction = direction; }
 
-	friend std::ostream& operator<<(std::ostream& os, const Sprite& sprite) {
-		os << "{\n";
-		os << "  \"frame_rect\": {\n";
-		os << "    \"x\": " << sprite._frame_rect.x << ",\n";
-		os << "    \"y\": " << sprite._frame_rect.y << ",\n";
-		os << "    \"w\": " << sprite._frame_rect.w << ",\n";
-		os << "    \"h\": " << sprite._frame_rect.h << "\n";
-		os << "  },\n";
-		os << "  \"bounding_rect\": {\n";
-		os << "    \"x\": " << sprite._bounding_rect.x << ",\n";
-		os << "    \"y\": " << sprite._bounding_rect.y << ",\n";
-		os << "    \"w\": " << sprite._bounding_rect.w << ",\n";
-		os << "    \"h\": " << sprite._bounding_rect.h << "\n";
-		os << "  },\n";
-		os << "  \"direction\": ";
-		switch (sprite._direction) {
-			case Direction::UP:
-				os << "\"UP\"";
-				break;
-			case Direction::DOWN:
-				os << "\"DOWN\"";
-				break;
-			case Direction::LEFT:
-				os << "\"LEFT\"";
-				break;
-			case Direction::RIGHT:
-				os << "\"RIGHT\"";
-			case Direction::NONE:
-			default:
-				os << "\"NONE\"";
-				break;
-		}
-		os << ",\n";
-		os << "  \"is_moving\": " << std::boolalpha << sprite._is_moving << ",\n";
-		os << "  \"speed\": " << std::setprecision(2) << std::fixed << sprite._speed << ",\n";
-		os << "  \"animation_controller\": " << sprite._animation_controller << "\n";
-		os << "}";
-		return os;
-	}
-
   protected:
-	SDL_Texture& _texture;
-	SDL_Rect     _frame_rect;
-	SDL_Rect     _bounding_rect;
+	TextureHandle _texture;
+	SDL_Texture*  _frame_texture = nullptr;
+	SDL_Rect      _frame_rect;
+	SDL_Rect      _frame_trim    = {0, 0, 0, 0};
+	bool          _frame_flipped = false;
+	SDL_Rect      _bounding_rect;
+	SDL_Rect      _hitbox = {0, 0, 0, 0};
+	Vector2f      _subpixel;
 
 	Direction _direction = Direction::DOWN;
 
@@ -101,4 +89,10 @@ class Sprite {
 	float _speed     = 0.0f;
 
 	AnimationController _animation_controller;
+
+  private:
+	/**
+	 * Smallest move of the hitbox out of the rect, along one axis
+	 */
+	Vector2i get_collision_push(const SDL_Rect& rect) const;
 };
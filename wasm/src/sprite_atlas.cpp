@@ -0,0 +1,254 @@
+#include "sprite_atlas.h"
+
+#include <tuple>
+
+namespace {
+	const size_t NO_ENTRY = (size_t)-1;
+
+	struct AtlasEntry {
+		int      source;
+		SDL_Rect src;
+		int      page      = -1;
+		SDL_Rect dst       = {0, 0, 0, 0};
+		SDL_Rect trim      = {0, 0, 0, 0};
+		size_t   shared_with = NO_ENTRY; // drawn from that entry instead of being packed
+		bool     mirrored    = false;    // the shared texels are the mirror image of the frame
+	};
+} // namespace
+
+SpriteAtlas::SpriteAtlas() {}
+
+SpriteAtlas::~SpriteAtlas() {
+	//? NOTE: pages are owned by the renderer, SDL_DestroyRenderer frees them
+}
+
+int SpriteAtlas::find_or_add_source(const std::string &source_path) {
+	for (size_t i = 0; i < _sources.size(); ++i) {
+		if (_sources[i] == source_path) return (int)i;
+	}
+	_sources.push_back(source_path);
+	return (int)_sources.size() - 1;
+}
+
+void SpriteAtlas::add_animation(const std::string &source_path, Animation &animation) {
+	auto &atlas  = get();
+	int   source = atlas.find_or_add_source(source_path);
+
+	for (AnimationFrame &frame : animation.frames) {
+		// already packed by a previous build
+		if (frame.texture != nullptr) continue;
+
+		atlas._frames.push_back({source, &frame});
+	}
+}
+
+void SpriteAtlas::add_animations(const std::string &source_path, AnimationController &controller) {
+	for (auto &[name, animation] : controller.get_animations()) {
+		add_animation(source_path, animation);
+	}
+}
+
+bool SpriteAtlas::build(SDL_Renderer *renderer) {
+	auto &atlas = get();
+	if (atlas._frames.empty()) return true;
+
+	// the same rect of the same sheet is only packed once
+	std::vector<AtlasEntry>                               entries;
+	std::vector<size_t>                                   frame_entries(atlas._frames.size());
+	std::map<std::tuple<int, int, int, int, int>, size_t> entry_lookup;
+
+	for (size_t i = 0; i < atlas._frames.size(); ++i) {
+		const FrameRef &ref  = atlas._frames[i];
+		const SDL_Rect &rect = ref.frame->rect;
+		auto            key  = std::make_tuple(ref.source, rect.x, rect.y, rect.w, rect.h);
+
+		auto it = entry_lookup.find(key);
+		if (it == entry_lookup.end()) {
+			it = entry_lookup.emplace(key, entries.size()).first;
+			entries.push_back({ref.source, rect});
+		}
+		frame_entries[i] = it->second;
+	}
+
+	// decode each spritesheet once, blit without blending to keep the alpha
+	std::vector<SDL_Surface *> sources(atlas._sources.size(), nullptr);
+	for (const AtlasEntry &entry : entries) {
+		if (sources[entry.source] != nullptr) continue;
+
+		bool         premultiplied = false;
+		SDL_Surface *surface =
+		    AssetManager::load_surface(atlas._sources[entry.source], SDL_PIXELFORMAT_RGBA32, &premultiplied);
+		if (surface == nullptr) {
+			printf("SpriteAtlas::build() - Failed to load image: %s\n", atlas._sources[entry.source].c_str());
+			for (SDL_Surface *loaded : sources) SDL_FreeSurface(loaded);
+			return false;
+		}
+
+		// pages use straight alpha, the frames of this sheet keep their own texture
+		if (premultiplied) {
+			printf("SpriteAtlas::build() - Skipping premultiplied sheet: %s\n", atlas._sources[entry.source].c_str());
+			SDL_FreeSurface(surface);
+			continue;
+		}
+
+		SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+		sources[entry.source] = surface;
+	}
+
+	// only the visible part of each frame is packed, trim remembers where it was
+	for (AtlasEntry &entry : entries) {
+		if (sources[entry.source] == nullptr) continue;
+
+		SDL_Rect bounds;
+		if (!find_opaque_bounds(sources[entry.source], entry.src, bounds)) continue;
+
+		entry.trim = {bounds.x - entry.src.x, bounds.y - entry.src.y, entry.src.w, entry.src.h};
+		entry.src  = bounds;
+	}
+
+	// texels already packed for another frame, of any sheet, or their mirror
+	// image are drawn from there
+	std::map<std::tuple<Uint64, int, int>, size_t> packed_lookup;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		AtlasEntry &entry = entries[i];
+		if (sources[entry.source] == nullptr) continue;
+
+		SDL_Surface *source    = sources[entry.source];
+		Uint64       hashes[2] = {hash_texels(source, entry.src), hash_texels(source, entry.src, true)};
+
+		for (bool mirrored : {false, true}) {
+			auto it = packed_lookup.find({hashes[mirrored], entry.src.w, entry.src.h});
+			if (it == packed_lookup.end()) continue;
+
+			const AtlasEntry &packed = entries[it->second];
+			if (same_texels(sources[packed.source], packed.src, source, entry.src, mirrored)) {
+				entry.shared_with = it->second;
+				entry.mirrored    = mirrored;
+				break;
+			}
+		}
+
+		if (entry.shared_with == NO_ENTRY) packed_lookup.emplace(std::make_tuple(hashes[0], entry.src.w, entry.src.h), i);
+	}
+
+	int              page_size = ATLAS_PAGE_SIZE;
+	SDL_RendererInfo info;
+	if (SDL_GetRendererInfo(renderer, &info) == 0 && info.max_texture_width > 0) {
+		page_size = std::min({page_size, info.max_texture_width, info.max_texture_height});
+	}
+
+	// pack the tallest frames first, it keeps the free list small
+	std::vector<size_t> order(entries.size());
+	for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::sort(order.begin(), order.end(), [&entries](size_t a, size_t b) {
+		const SDL_Rect &ra = entries[a].src;
+		const SDL_Rect &rb = entries[b].src;
+		if (ra.h != rb.h) return ra.h > rb.h;
+		return ra.w > rb.w;
+	});
+
+	std::vector<MaxRectsPacker> packers;
+	size_t                      shared_count = 0;
+	for (size_t index : order) {
+		AtlasEntry &entry = entries[index];
+		if (sources[entry.source] == nullptr) continue;
+
+		if (entry.shared_with != NO_ENTRY) {
+			shared_count++;
+			continue;
+		}
+
+		int w = entry.src.w + ATLAS_PADDING;
+		int h = entry.src.h + ATLAS_PADDING;
+
+		for (size_t page = 0; page < packers.size() && entry.page < 0; ++page) {
+			if (packers[page].insert(w, h, entry.dst)) entry.page = (int)page;
+		}
+
+		if (entry.page < 0) {
+			packers.emplace_back(page_size, page_size);
+			if (packers.back().insert(w, h, entry.dst)) {
+				entry.page = (int)packers.size() - 1;
+			} else {
+				// bigger than a page, the frame keeps its own spritesheet
+				packers.pop_back();
+				printf("SpriteAtlas::build() - Frame %dx%d does not fit in a %d page\n",
+				       entry.src.w,
+				       entry.src.h,
+				       page_size);
+			}
+		}
+
+		entry.dst.w = entry.src.w;
+		entry.dst.h = entry.src.h;
+	}
+
+	size_t                     first_page = atlas._pages.size();
+	std::vector<SDL_Surface *> pages;
+	for (const MaxRectsPacker &packer : packers) {
+		// shrink the page to what was actually used
+		pages.push_back(SDL_CreateRGBSurfaceWithFormat(
+		    0, packer.get_used_width(), packer.get_used_height(), 32, SDL_PIXELFORMAT_RGBA32));
+	}
+
+	for (const AtlasEntry &entry : entries) {
+		if (entry.shared_with != NO_ENTRY || entry.page < 0 || pages[entry.page] == nullptr) continue;
+
+		SDL_Rect src = entry.src;
+		SDL_Rect dst = entry.dst;
+		SDL_BlitSurface(sources[entry.source], &src, pages[entry.page], &dst);
+	}
+
+	bool success = true;
+	for (SDL_Surface *page : pages) {
+		SDL_Texture *texture = page ? SDL_CreateTextureFromSurface(renderer, page) : nullptr;
+		if (texture == nullptr) {
+			printf("SpriteAtlas::build() - Failed to create page: %s\n", SDL_GetError());
+			success = false;
+		} else {
+			SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		}
+		atlas._pages.push_back(texture);
+		SDL_FreeSurface(page);
+	}
+
+	for (SDL_Surface *surface : sources) SDL_FreeSurface(surface);
+
+	for (size_t i = 0; i < atlas._frames.size(); ++i) {
+		const AtlasEntry &entry   = entries[frame_entries[i]];
+		const AtlasEntry &packed  = entry.shared_with != NO_ENTRY ? entries[entry.shared_with] : entry;
+		SDL_Texture      *texture = packed.page < 0 ? nullptr : atlas._pages[first_page + packed.page];
+		if (texture == nullptr) continue;
+
+		AnimationFrame *frame = atlas._frames[i].frame;
+		frame->rect           = packed.dst;
+		frame->texture        = texture;
+		frame->trim           = entry.trim;
+
+		// the packed texels are the mirror image of the frame, so is their place in it
+		if (entry.mirrored) {
+			if (entry.trim.w > 0) frame->trim.x = entry.trim.w - entry.trim.x - entry.src.w;
+			frame->is_flipped = !frame->is_flipped;
+		}
+	}
+
+	printf("SpriteAtlas: %zu frames packed into %zu page(s), %zu shared\n",
+	       entries.size() - shared_count,
+	       packers.size(),
+	       shared_count);
+
+	atlas._packed_frame_count += entries.size() - shared_count;
+	atlas._frames.clear();
+
+	return success;
+}
+
+void SpriteAtlas::clear() {
+	auto &atlas = get();
+	for (SDL_Texture *page : atlas._pages) {
+		if (page != nullptr) SDL_DestroyTexture(page);
+	}
+	atlas._pages.clear();
+	atlas._frames.clear();
+	atlas._packed_frame_count = 0;
+}
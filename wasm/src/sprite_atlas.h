@@ -0,0 +1,73 @@
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#pragma once
+
+#include "animation_controller.h"
+#include "atlas_packer.h"
+
+/**
+ * Packs the frames used by the registered animations into a few shared pages
+ * so that every sprite can be drawn from the same texture.
+ *
+ * Usage:
+ *   SpriteAtlas::add_animations(ASSET_ROOT "images/characters_no_bg.png", controller);
+ *   SpriteAtlas::build(renderer);
+ *
+ * After build() every registered frame points to its atlas page and its rect
+ * is expressed in page coordinates. Transparent borders are trimmed, the
+ * frame's trim tells where the packed rect sits in the original frame.
+ * Frames are deduplicated by content: a frame with the same texels as
+ * another one, or their mirror image, is drawn from the other one's rect,
+ * flipped if needed.
+ */
+class SpriteAtlas {
+  public:
+	SpriteAtlas();
+	~SpriteAtlas();
+
+	SpriteAtlas(const SpriteAtlas &)            = delete;
+	SpriteAtlas &operator=(const SpriteAtlas &) = delete;
+
+	static SpriteAtlas &get() {
+		static SpriteAtlas instance;
+		return instance;
+	}
+
+	/**
+	 * Registers the frames of an animation, their rects being relative to the
+	 * spritesheet found at source_path
+	 */
+	static void add_animation(const std::string &source_path, Animation &animation);
+	static void add_animations(const std::string &source_path, AnimationController &controller);
+
+	/**
+	 * Packs every frame registered since the last build into new pages and
+	 * remaps them to atlas coordinates
+	 * @return false if a spritesheet or a page could not be created
+	 */
+	static bool build(SDL_Renderer *renderer);
+
+	/**
+	 * Destroys every page, frames still pointing to them must not be rendered
+	 */
+	static void clear();
+
+	static size_t get_page_count() { return get()._pages.size(); }
+	static size_t get_packed_frame_count() { return get()._packed_frame_count; }
+
+  private:
+	struct FrameRef {
+		int             source;
+		AnimationFrame *frame;
+	};
+
+	int find_or_add_source(const std::string &source_path);
+
+	std::vector<std::string>   _sources;
+	std::vector<FrameRef>      _frames;
+	std::vector<SDL_Texture *> _pages;
+	size_t                     _packed_frame_count = 0;
+};
+
+#endif
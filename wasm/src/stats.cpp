@@ -0,0 +1,126 @@
+#include "stats.h"
+
+#include <cstdarg>
+#include <cstring>
+
+Stats::Stats() {
+	_buffer.resize(STATS_BUFFER_SIZE);
+}
+
+StatId Stats::add_counter(const char* name) {
+	return get().add(name, StatType::COUNTER, 0);
+}
+
+StatId Stats::add_gauge(const char* name, int precision) {
+	return get().add(name, StatType::GAUGE, precision);
+}
+
+StatId Stats::add_label(const char* name) {
+	return get().add(name, StatType::LABEL, 0);
+}
+
+StatId Stats::add(const char* name, StatType type, int precision) {
+	if (_count >= STATS_CAPACITY) {
+		printf("Too many stats, %s is not tracked\n", name);
+		return STAT_NONE;
+	}
+
+	Stat& stat     = _stats[_count];
+	stat.name      = name;
+	stat.type      = type;
+	stat.precision = precision;
+	stat.count     = 0;
+	stat.gauge     = 0.0;
+	stat.label[0]  = '\0';
+	return _count++;
+}
+
+Stats::Stat* Stats::find(StatId id, StatType type) {
+	if (id >= _count || _stats[id].type != type) return nullptr;
+	return &_stats[id];
+}
+
+void Stats::set_counter(StatId id, int64_t value) {
+	if (Stat* stat = get().find(id, StatType::COUNTER)) stat->count = value;
+}
+
+void Stats::set_gauge(StatId id, double value) {
+	if (Stat* stat = get().find(id, StatType::GAUGE)) stat->gauge = value;
+}
+
+void Stats::set_label(StatId id, const char* text) {
+	Stat* stat = get().find(id, StatType::LABEL);
+	if (stat == nullptr) return;
+
+	strncpy(stat->label, text, STATS_LABEL_SIZE - 1);
+	stat->label[STATS_LABEL_SIZE - 1] = '\0';
+}
+
+void Stats::increment(StatId id, int64_t delta) {
+	if (Stat* stat = get().find(id, StatType::COUNTER)) stat->count += delta;
+}
+
+void Stats::append(const char* format, ...) {
+	size_t room = _buffer.size() - _length;
+	if (room <= 1) return;
+
+	va_list args;
+	va_start(args, format);
+	int written = vsnprintf(_buffer.data() + _length, room, format, args);
+	va_end(args);
+
+	if (written > 0) _length += std::min((size_t)written, room - 1);
+}
+
+void Stats::append_value(const Stat& stat, bool quote_label) {
+	switch (stat.type) {
+		case StatType::COUNTER:
+			append("%lld", (long long)stat.count);
+			break;
+		case StatType::GAUGE:
+			append("%.*f", stat.precision, stat.gauge);
+			break;
+		case StatType::LABEL:
+			if (!quote_label) {
+				append("%s", stat.label);
+				break;
+			}
+
+			append("\"");
+			for (const char* c = stat.label; *c; ++c) {
+				if (*c == '"' || *c == '\\') append("\\");
+				append("%c", *c);
+			}
+			append("\"");
+			break;
+	}
+}
+
+const char* Stats::to_text() {
+	auto& stats      = get();
+	stats._length    = 0;
+	stats._buffer[0] = '\0';
+
+	for (size_t i = 0; i < stats._count; ++i) {
+		stats.append("%s: ", stats._stats[i].name);
+		stats.append_value(stats._stats[i], false);
+		stats.append("\n");
+	}
+
+	return stats._buffer.data();
+}
+
+const char* Stats::to_json() {
+	auto& stats      = get();
+	stats._length    = 0;
+	stats._buffer[0] = '\0';
+
+	stats.append("{");
+	for (size_t i = 0; i < stats._count; ++i) {
+		stats.append("%s\"%s\": ", i > 0 ? ", " : "", stats._stats[i].name);
+		stats.append_value(stats._stats[i], true);
+	}
+	stats.append("}");
+
+	return stats._buffer.data();
+}
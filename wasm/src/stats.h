@@ -0,0 +1,89 @@
+#ifndef STATS_H
+#define STATS_H
+
+#pragma once
+
+#include "includes.h"
+
+#include <cstdint>
+
+using StatId = size_t;
+
+#define STAT_NONE ((StatId)-1)
+
+enum class StatType { COUNTER, GAUGE, LABEL };
+
+/**
+ * Registry of the numbers shown in the overlay.
+ *
+ * Subsystems register their stats once and get an id back, writing a value
+ * each frame is then a store into a preallocated slot. Nothing is formatted
+ * until to_text() or to_json() is called, both write into a buffer allocated
+ * once as well.
+ *
+ * Names must be string literals, they are not copied.
+ */
+class Stats {
+  public:
+	Stats();
+	~Stats() = default;
+
+	Stats(const Stats&)            = delete;
+	Stats& operator=(const Stats&) = delete;
+
+	static Stats& get() {
+		static Stats instance;
+		return instance;
+	}
+
+	/**
+	 * @return the id of the stat, STAT_NONE once STATS_CAPACITY stats are registered
+	 */
+	static StatId add_counter(const char* name);
+	static StatId add_gauge(const char* name, int precision = 2);
+	static StatId add_label(const char* name);
+
+	static void set_counter(StatId id, int64_t value);
+	static void set_gauge(StatId id, double value);
+	static void set_label(StatId id, const char* text);
+	static void increment(StatId id, int64_t delta = 1);
+
+	/**
+	 * One "name: value" line per stat
+	 * @return the text, valid until the next call
+	 */
+	static const char* to_text();
+
+	/**
+	 * Flat object of every stat
+	 * @return the json, valid until the next call
+	 */
+	static const char* to_json();
+
+  private:
+	struct Stat {
+		const char* name;
+		StatType    type;
+		int         precision;
+		int64_t     count;
+		double      gauge;
+		char        label[STATS_LABEL_SIZE];
+	};
+
+	StatId add(const char* name, StatType type, int precision);
+	Stat*  find(StatId id, StatType type);
+
+	/**
+	 * Appends to _buffer, drops what does not fit
+	 */
+	void append(const char* format, ...);
+	void append_value(const Stat& stat, bool quote_label);
+
+	Stat   _stats[STATS_CAPACITY];
+	size_t _count = 0;
+
+	std::vector<char> _buffer;
+	size_t            _length = 0;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t thread_count) {
+	for (size_t i = 0; i < thread_count; ++i) {
+		_workers.emplace_back(&ThreadPool::worker_loop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_condition.notify_all();
+
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+size_t ThreadPool::default_thread_count() {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+	return 0;
+#else
+	// keep one core for the main thread
+	unsigned int cores = std::thread::hardware_concurrency();
+	return std::clamp<size_t>(cores > 1 ? cores - 1 : 1, 1, 4);
+#endif
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(std::move(job));
+	}
+	_condition.notify_one();
+}
+
+bool ThreadPool::run_pending() {
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_jobs.empty()) return false;
+
+		job = std::move(_jobs.front());
+		_jobs.pop_front();
+	}
+
+	job();
+	return true;
+}
+
+void ThreadPool::worker_loop() {
+	for (;;) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+
+			if (_stopping && _jobs.empty()) return;
+
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		job();
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#pragma once
+
+#include "includes.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Fixed set of worker threads running background jobs (decoding, cooking...).
+ *
+ * Builds without threads (wasm without pthreads) get no worker, the jobs
+ * then wait in the queue until the main thread runs them with run_pending().
+ */
+class ThreadPool {
+  public:
+	explicit ThreadPool(size_t thread_count = default_thread_count());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&)            = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	static ThreadPool& get() {
+		static ThreadPool instance;
+		return instance;
+	}
+
+	void submit(std::function<void()> job);
+
+	/**
+	 * Runs at most one queued job on the calling thread
+	 * @return true if a job was run
+	 */
+	bool run_pending();
+
+	size_t get_thread_count() const { return _workers.size(); }
+	bool   has_workers() const { return !_workers.empty(); }
+
+	static size_t default_thread_count();
+
+  private:
+	void worker_loop();
+
+	std::vector<std::thread>          _workers;
+	std::deque<std::function<void()>> _jobs;
+	std::mutex                        _mutex;
+	std::condition_variable           _condition;
+	bool                              _stopping = false;
+};
+
+#endif
@@ -0,0 +1,1316 @@
+#include "tile_map.h"
+
+#include "cooked_map_format.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <zlib.h>
+
+#ifdef TILE_MAP_ZSTD
+#include <zstd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TILE_MAP_SSE2
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#define TILE_MAP_WASM_SIMD
+#include <wasm_simd128.h>
+#endif
+
+namespace {
+	inline bool is_digit(char c) {
+		return (unsigned)(c - '0') < 10;
+	}
+
+	inline int count_trailing_zeros(Uint32 value) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_ctz(value);
+#else
+		int count = 0;
+		while (!(value & 1)) {
+			value >>= 1;
+			++count;
+		}
+		return count;
+#endif
+	}
+
+#if defined(TILE_MAP_SSE2) || defined(TILE_MAP_WASM_SIMD)
+	// one bit per byte of p[0..15], set for the digits
+	inline Uint32 digit_mask(const char *p) {
+#if defined(TILE_MAP_SSE2)
+		__m128i c = _mm_loadu_si128((const __m128i *)p);
+		__m128i digits =
+		    _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+		return (Uint32)_mm_movemask_epi8(digits);
+#else
+		v128_t c = wasm_v128_load(p);
+		v128_t digits =
+		    wasm_v128_and(wasm_i8x16_gt(c, wasm_i8x16_splat('0' - 1)), wasm_i8x16_lt(c, wasm_i8x16_splat('9' + 1)));
+		return (Uint32)wasm_i8x16_bitmask(digits);
+#endif
+	}
+#endif
+
+	/**
+	 * Converts the length <= 8 digits at p, 8 bytes must be readable
+	 */
+	inline Uint32 parse_8_digits(const char *p, int length) {
+		Uint64 chunk;
+		memcpy(&chunk, p, 8);
+
+		// little endian, the first digit is the low byte. The bytes past the
+		// number may borrow from each other but never from a digit, and the
+		// shift drops them while leaving zeros in front of the number.
+		chunk -= 0x3030303030303030ull;
+		chunk <<= (8 - length) * 8;
+
+		chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFull;
+		chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFull;
+		chunk = (chunk * 10000 + (chunk >> 32)) & 0x00000000FFFFFFFFull;
+		return (Uint32)chunk;
+	}
+
+	/**
+	 * Forward-only XML reader, enough for what Tiled writes. Names, attribute
+	 * values and text are spans of the input, nothing is copied.
+	 */
+	class XmlPullParser {
+	  public:
+		enum Token { START, END, TEXT, DONE, ERROR };
+
+		XmlPullParser(const char *begin, const char *end): _begin(begin), _p(begin), _end(end) {}
+
+		/**
+		 * A self-closing element gives a START then an END
+		 */
+		Token next();
+
+		bool is(const char *name) const {
+			size_t length = strlen(name);
+			return (size_t)(_name_end - _name) == length && memcmp(_name, name, length) == 0;
+		}
+
+		/**
+		 * @return the attribute of the current START, entities decoded, fallback if it is missing
+		 */
+		std::string attribute(const char *name, const char *fallback = "") const;
+		int         int_attribute(const char *name, int fallback = 0) const;
+		double      double_attribute(const char *name, double fallback = 0.0) const;
+
+		const char *get_text_begin() const { return _text; }
+		const char *get_text_end() const { return _text_end; }
+
+		const char *get_error() const { return _error; }
+		int         get_line() const;
+
+	  private:
+		struct Attribute {
+			const char *name;
+			const char *name_end;
+			const char *value;
+			const char *value_end;
+		};
+
+		Token fail(const char *error) {
+			_error = error;
+			return ERROR;
+		}
+
+		bool skip_past(const char *terminator);
+		void skip_spaces() {
+			while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r')) ++_p;
+		}
+
+		const Attribute *find_attribute(const char *name) const;
+
+		static const size_t MAX_ATTRIBUTES = 32;
+
+		const char *_begin;
+		const char *_p;
+		const char *_end;
+
+		const char *_name     = nullptr;
+		const char *_name_end = nullptr;
+		const char *_text     = nullptr;
+		const char *_text_end = nullptr;
+		const char *_error    = nullptr;
+
+		bool _pending_end = false; // the START was self-closing
+
+		Attribute _attributes[MAX_ATTRIBUTES];
+		size_t    _attribute_count = 0;
+	};
+
+	XmlPullParser::Token XmlPullParser::next() {
+		if (_pending_end) {
+			_pending_end = false;
+			return END;
+		}
+
+		while (_p < _end) {
+			if (*_p != '<') {
+				_text = _p;
+				while (_p < _end && *_p != '<') ++_p;
+				_text_end = _p;
+				return TEXT;
+			}
+
+			// declarations, comments and doctype carry nothing Tiled needs
+			if (_p + 1 < _end && _p[1] == '?') {
+				if (!skip_past("?>")) return fail("unterminated processing instruction");
+				continue;
+			}
+			if (_end - _p >= 4 && memcmp(_p, "<!--", 4) == 0) {
+				if (!skip_past("-->")) return fail("unterminated comment");
+				continue;
+			}
+			if (_end - _p >= 9 && memcmp(_p, "<![CDATA[", 9) == 0) {
+				_text = _p + 9;
+				if (!skip_past("]]>")) return fail("unterminated CDATA section");
+				_text_end = _p - 3;
+				return TEXT;
+			}
+			if (_p + 1 < _end && _p[1] == '!') {
+				if (!skip_past(">")) return fail("unterminated declaration");
+				continue;
+			}
+
+			bool closing = _p + 1 < _end && _p[1] == '/';
+			_p += closing ? 2 : 1;
+
+			_name = _p;
+			while (_p < _end && !strchr(" \t\r\n/>", *_p)) ++_p;
+			_name_end = _p;
+			if (_name == _name_end) return fail("element without a name");
+
+			if (closing) {
+				skip_spaces();
+				if (_p >= _end || *_p != '>') return fail("malformed end tag");
+				++_p;
+				return END;
+			}
+
+			_attribute_count = 0;
+			for (;;) {
+				skip_spaces();
+				if (_p >= _end) return fail("unterminated start tag");
+
+				if (*_p == '>') {
+					++_p;
+					return START;
+				}
+				if (*_p == '/') {
+					if (_p + 1 >= _end || _p[1] != '>') return fail("malformed start tag");
+					_p += 2;
+					_pending_end = true;
+					return START;
+				}
+
+				Attribute attribute;
+				attribute.name = _p;
+				while (_p < _end && !strchr(" \t\r\n=/>", *_p)) ++_p;
+				attribute.name_end = _p;
+
+				skip_spaces();
+				if (_p >= _end || *_p != '=') return fail("attribute without a value");
+				++_p;
+				skip_spaces();
+				if (_p >= _end || (*_p != '"' && *_p != '\'')) return fail("unquoted attribute value");
+
+				char quote      = *_p++;
+				attribute.value = _p;
+				while (_p < _end && *_p != quote) ++_p;
+				if (_p >= _end) return fail("unterminated attribute value");
+				attribute.value_end = _p++;
+
+				if (_attribute_count == MAX_ATTRIBUTES) return fail("too many attributes");
+				_attributes[_attribute_count++] = attribute;
+			}
+		}
+
+		return DONE;
+	}
+
+	bool XmlPullParser::skip_past(const char *terminator) {
+		size_t length = strlen(terminator);
+		for (; _end - _p >= (ptrdiff_t)length; ++_p) {
+			if (memcmp(_p, terminator, length) == 0) {
+				_p += length;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	const XmlPullParser::Attribute *XmlPullParser::find_attribute(const char *name) const {
+		size_t length = strlen(name);
+		for (size_t i = 0; i < _attribute_count; ++i) {
+			const Attribute &attribute = _attributes[i];
+			if ((size_t)(attribute.name_end - attribute.name) == length && memcmp(attribute.name, name, length) == 0) {
+				return &attribute;
+			}
+		}
+		return nullptr;
+	}
+
+	std::string XmlPullParser::attribute(const char *name, const char *fallback) const {
+		const Attribute *attribute = find_attribute(name);
+		if (attribute == nullptr) return fallback;
+
+		static const struct {
+			const char *entity;
+			char        character;
+		} entities[] = {{"&lt;", '<'}, {"&gt;", '>'}, {"&amp;", '&'}, {"&quot;", '"'}, {"&apos;", '\''}};
+
+		std::string value;
+		value.reserve(attribute->value_end - attribute->value);
+		for (const char *c = attribute->value; c < attribute->value_end; ++c) {
+			bool decoded = false;
+			if (*c == '&') {
+				for (const auto &entity : entities) {
+					size_t length = strlen(entity.entity);
+					if (attribute->value_end - c >= (ptrdiff_t)length && memcmp(c, entity.entity, length) == 0) {
+						value += entity.character;
+						c += length - 1;
+						decoded = true;
+						break;
+					}
+				}
+			}
+			if (!decoded) value += *c;
+		}
+		return value;
+	}
+
+	int XmlPullParser::int_attribute(const char *name, int fallback) const {
+		const Attribute *attribute = find_attribute(name);
+		if (attribute == nullptr) return fallback;
+
+		// the value is followed by its quote, strtol stops there
+		return (int)strtol(attribute->value, nullptr, 10);
+	}
+
+	double XmlPullParser::double_attribute(const char *name, double fallback) const {
+		const Attribute *attribute = find_attribute(name);
+		if (attribute == nullptr) return fallback;
+		return strtod(attribute->value, nullptr);
+	}
+
+	int XmlPullParser::get_line() const {
+		int line = 1;
+		for (const char *c = _begin; c < _p; ++c) {
+			if (*c == '\n') ++line;
+		}
+		return line;
+	}
+
+	const Uint8 BASE64_SPACE   = 0x40;
+	const Uint8 BASE64_INVALID = 0x80;
+
+	constexpr std::array<Uint8, 256> make_base64_table() {
+		std::array<Uint8, 256> table{};
+		for (Uint8 &value : table) value = BASE64_INVALID;
+
+		const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		for (Uint8 i = 0; i < 64; ++i) table[(Uint8)alphabet[i]] = i;
+
+		table[' '] = table['\t'] = table['\n'] = table['\r'] = BASE64_SPACE;
+		return table;
+	}
+
+	// the sextet of each character, or one of the flags above
+	constexpr std::array<Uint8, 256> BASE64_TABLE = make_base64_table();
+
+	// base64 bytes decoded per call to the decompressor
+	const size_t COMPRESSED_CHUNK_SIZE = 4096;
+
+	/**
+	 * Decompresses the data of a layer into its tiles, fed one chunk at a time
+	 */
+	class LayerInflater {
+	  public:
+		enum Compression { ZLIB, ZSTD };
+
+		~LayerInflater();
+
+		/**
+		 * Starts a layer, the output is the whole tile array
+		 * @return false if the compression is not available in this build
+		 */
+		bool begin(Compression compression, Uint8 *out, size_t size);
+
+		/**
+		 * @return false if the data is corrupt or holds more than the layer
+		 */
+		bool write(const Uint8 *data, size_t size);
+
+		/**
+		 * @return true once the stream ended with the layer full
+		 */
+		bool is_complete() const { return _ended && _written == _size; }
+
+		const char *get_error() const { return _error; }
+
+	  private:
+		bool fail(const char *error) {
+			_error = error;
+			return false;
+		}
+
+		Compression _compression = ZLIB;
+		Uint8      *_out         = nullptr;
+		size_t      _size        = 0;
+		size_t      _written     = 0;
+		bool        _ended       = false;
+		const char *_error       = nullptr;
+
+		// created by the first layer that needs them, reset for the next ones
+		z_stream _zlib;
+		bool     _zlib_ready = false;
+#ifdef TILE_MAP_ZSTD
+		ZSTD_DCtx *_zstd = nullptr;
+#endif
+	};
+
+	LayerInflater::~LayerInflater() {
+		if (_zlib_ready) inflateEnd(&_zlib);
+#ifdef TILE_MAP_ZSTD
+		if (_zstd != nullptr) ZSTD_freeDCtx(_zstd);
+#endif
+	}
+
+	bool LayerInflater::begin(Compression compression, Uint8 *out, size_t size) {
+		_compression = compression;
+		_out         = out;
+		_size        = size;
+		_written     = 0;
+		_ended       = false;
+		_error       = nullptr;
+
+		if (compression == ZLIB) {
+			if (!_zlib_ready) {
+				memset(&_zlib, 0, sizeof(_zlib));
+
+				// 32 detects the zlib or gzip header
+				if (inflateInit2(&_zlib, 15 + 32) != Z_OK) return fail("zlib could not be initialised");
+				_zlib_ready = true;
+			} else {
+				inflateReset(&_zlib);
+			}
+			return true;
+		}
+
+#ifdef TILE_MAP_ZSTD
+		if (_zstd == nullptr) _zstd = ZSTD_createDCtx();
+		if (_zstd == nullptr) return fail("zstd could not be initialised");
+		ZSTD_DCtx_reset(_zstd, ZSTD_reset_session_only);
+		return true;
+#else
+		return fail("zstd layer data is not supported by this build");
+#endif
+	}
+
+	bool LayerInflater::write(const Uint8 *data, size_t size) {
+		if (_ended) return size == 0 || fail("data past the end of the compressed stream");
+
+		if (_compression == ZLIB) {
+			_zlib.next_in  = (Bytef *)data;
+			_zlib.avail_in = (uInt)size;
+
+			while (_zlib.avail_in > 0) {
+				_zlib.next_out  = _out + _written;
+				_zlib.avail_out = (uInt)(_size - _written);
+
+				int result = inflate(&_zlib, Z_NO_FLUSH);
+				_written   = _size - _zlib.avail_out;
+
+				if (result == Z_STREAM_END) {
+					_ended = true;
+					return _zlib.avail_in == 0 || fail("data past the end of the compressed stream");
+				}
+				if (result == Z_BUF_ERROR) return fail("layer data does not match the layer size");
+				if (result != Z_OK) return fail(_zlib.msg != nullptr ? _zlib.msg : "corrupt zlib data");
+			}
+			return true;
+		}
+
+#ifdef TILE_MAP_ZSTD
+		ZSTD_inBuffer input = {data, size, 0};
+		while (input.pos < input.size) {
+			ZSTD_outBuffer output = {_out, _size, _written};
+			size_t         read   = input.pos;
+
+			size_t result = ZSTD_decompressStream(_zstd, &output, &input);
+			if (ZSTD_isError(result)) return fail(ZSTD_getErrorName(result));
+
+			// with input left, no progress means the output is full
+			bool stalled = output.pos == _written && input.pos == read;
+			_written     = output.pos;
+
+			if (result == 0) {
+				_ended = true;
+				return input.pos == input.size || fail("data past the end of the compressed stream");
+			}
+			if (stalled) return fail("layer data does not match the layer size");
+		}
+		return true;
+#else
+		return fail("zstd layer data is not supported by this build");
+#endif
+	}
+} // namespace
+
+size_t parse_csv_uints(const char *begin, const char *end, Uint32 *out, size_t capacity, const char **stop) {
+	const char *p     = begin;
+	size_t      count = 0;
+
+	while (count < capacity) {
+		int length = 0;
+
+#if defined(TILE_MAP_SSE2) || defined(TILE_MAP_WASM_SIMD)
+		// skip the separators, the mask of the block holding the number usually gives its length too
+		while (end - p >= 16) {
+			Uint32 digits = digit_mask(p);
+			if (digits == 0) {
+				p += 16;
+				continue;
+			}
+
+			int offset = count_trailing_zeros(digits);
+			p += offset;
+
+			Uint32 separators = ~(digits >> offset) & (0xFFFFu >> offset);
+			if (separators != 0) {
+				length = count_trailing_zeros(separators);
+			} else if (end - p >= 16) {
+				separators = ~digit_mask(p) & 0xFFFF;
+				length     = separators != 0 ? count_trailing_zeros(separators) : 16;
+			}
+			break;
+		}
+#endif
+		while (p < end && !is_digit(*p)) ++p;
+		if (p == end) break;
+
+#if !defined(TILE_MAP_SSE2) && !defined(TILE_MAP_WASM_SIMD)
+		if (end - p >= 9) {
+			while (length < 9 && is_digit(p[length])) ++length;
+		}
+#endif
+
+		if (length > 0 && length <= 8 && end - p >= 8) {
+			out[count++] = parse_8_digits(p, length);
+			p += length;
+			continue;
+		}
+
+		// long numbers and the end of the input, anything past 32 bits wraps
+		Uint32 value = 0;
+		while (p < end && is_digit(*p)) {
+			value = value * 10 + (Uint32)(*p - '0');
+			++p;
+		}
+		out[count++] = value;
+	}
+
+	if (stop != nullptr) *stop = p;
+	return count;
+}
+
+size_t decode_base64(const char *begin, const char *end, Uint8 *out, size_t capacity, const char **stop) {
+	const char *p     = begin;
+	size_t      count = 0;
+
+	for (;;) {
+		if (end - p >= 4 && capacity - count >= 3) {
+			Uint32 a = BASE64_TABLE[(Uint8)p[0]];
+			Uint32 b = BASE64_TABLE[(Uint8)p[1]];
+			Uint32 c = BASE64_TABLE[(Uint8)p[2]];
+			Uint32 d = BASE64_TABLE[(Uint8)p[3]];
+
+			// whitespace, padding and invalid characters all have a flag set
+			if (((a | b | c | d) & (BASE64_SPACE | BASE64_INVALID)) == 0) {
+				Uint32 bits  = a << 18 | b << 12 | c << 6 | d;
+				out[count++] = (Uint8)(bits >> 16);
+				out[count++] = (Uint8)(bits >> 8);
+				out[count++] = (Uint8)bits;
+				p += 4;
+				continue;
+			}
+		}
+
+		// a group split by whitespace, the padding or the end
+		const char *group   = p;
+		Uint32      bits    = 0;
+		int         sextets = 0;
+		while (p < end && sextets < 4) {
+			Uint8 sextet = BASE64_TABLE[(Uint8)*p];
+			if (sextet == BASE64_SPACE) {
+				++p;
+				continue;
+			}
+			if (sextet == BASE64_INVALID) break;
+
+			bits = bits << 6 | sextet;
+			++sextets;
+			++p;
+		}
+
+		if (sextets == 4) {
+			if (capacity - count < 3) {
+				p = group;
+				break;
+			}
+			out[count++] = (Uint8)(bits >> 16);
+			out[count++] = (Uint8)(bits >> 8);
+			out[count++] = (Uint8)bits;
+			continue;
+		}
+
+		// 2 sextets give a byte and 3 give two, then the padding ends the data
+		if (sextets < 2 || (p < end && *p != '=')) {
+			p = group;
+			break;
+		}
+		size_t bytes = (size_t)sextets - 1;
+		if (capacity - count < bytes) {
+			p = group;
+			break;
+		}
+
+		bits <<= 6 * (4 - sextets);
+		out[count++] = (Uint8)(bits >> 16);
+		if (bytes == 2) out[count++] = (Uint8)(bits >> 8);
+
+		while (p < end && (*p == '=' || BASE64_TABLE[(Uint8)*p] == BASE64_SPACE)) ++p;
+		break;
+	}
+
+	if (stop != nullptr) *stop = p;
+	return count;
+}
+
+bool TileMap::parse(const char *xml, size_t size, const std::string &name) {
+	clear();
+	if (!read(xml, size, name, nullptr)) return false;
+
+	build_collision();
+	return true;
+}
+
+bool TileMap::parse_tileset(size_t index, const char *xml, size_t size, const std::string &name) {
+	if (index >= _tilesets.size()) return false;
+	if (!read(xml, size, name, &_tilesets[index])) return false;
+
+	build_collision();
+	return true;
+}
+
+bool TileMap::read(const char *xml, size_t size, const std::string &name, TileSet *external) {
+	XmlPullParser parser(xml, xml + size);
+
+	enum DataFormat { XML, CSV, BASE64, COMPRESSED };
+
+	TileSet    *tileset    = nullptr;
+	int         tile_id    = -1; // <tile> of the tileset being read
+	bool        in_data    = false;
+	DataFormat  format     = XML;
+	size_t      data_index = 0; // tiles already decoded in the current layer, bytes for base64
+	TileLayer  *layer      = nullptr;
+	MapObject  *object     = nullptr;
+	bool        in_group   = false;
+	std::string group; // name of the object layer being read
+
+	LayerInflater inflater;
+	Uint8         chunk[COMPRESSED_CHUNK_SIZE];
+
+	auto fail = [&](const char *error) {
+		printf("TileMap::parse() - %s:%d: %s\n", name.c_str(), parser.get_line(), error);
+		clear();
+		return false;
+	};
+
+	for (;;) {
+		XmlPullParser::Token token = parser.next();
+		if (token == XmlPullParser::DONE) break;
+		if (token == XmlPullParser::ERROR) return fail(parser.get_error());
+
+		if (token == XmlPullParser::START) {
+			if (parser.is("map")) {
+				if (parser.int_attribute("infinite") != 0) return fail("infinite maps are not supported");
+
+				_width       = parser.int_attribute("width");
+				_height      = parser.int_attribute("height");
+				_tile_width  = parser.int_attribute("tilewidth");
+				_tile_height = parser.int_attribute("tileheight");
+			} else if (parser.is("tileset")) {
+				// an external tileset keeps the first gid and the source given by the map
+				if (external == nullptr) {
+					_tilesets.emplace_back();
+					tileset            = &_tilesets.back();
+					tileset->first_gid = (Uint32)parser.int_attribute("firstgid", 1);
+					tileset->source    = parser.attribute("source");
+				} else {
+					tileset = external;
+				}
+				tileset->name        = parser.attribute("name");
+				tileset->tile_width  = parser.int_attribute("tilewidth");
+				tileset->tile_height = parser.int_attribute("tileheight");
+				tileset->tile_count  = parser.int_attribute("tilecount");
+				tileset->columns     = parser.int_attribute("columns");
+			} else if (parser.is("image") && tileset != nullptr && tile_id < 0) {
+				tileset->image        = parser.attribute("source");
+				tileset->image_width  = parser.int_attribute("width");
+				tileset->image_height = parser.int_attribute("height");
+
+				std::string transparent = parser.attribute("trans");
+				if (!transparent.empty()) tileset->transparent = (Sint32)strtol(transparent.c_str(), nullptr, 16);
+			} else if (parser.is("tile") && tileset != nullptr) {
+				tile_id = parser.int_attribute("id");
+			} else if (parser.is("property")) {
+				std::string value    = parser.attribute("value");
+				bool        collides = parser.attribute("name") == "collides" && (value == "true" || value == "1");
+
+				if (collides && tileset != nullptr && tile_id >= 0) {
+					tileset->solid_tiles.push_back((Uint32)tile_id);
+				} else if (collides && layer != nullptr && !in_data) {
+					layer->collides = true;
+				}
+			} else if (parser.is("objectgroup")) {
+				group    = parser.attribute("name");
+				in_group = true;
+			} else if (parser.is("object") && in_group) {
+				_objects.emplace_back();
+				object           = &_objects.back();
+				object->id       = parser.int_attribute("id");
+				object->name     = parser.attribute("name");
+				object->type     = parser.attribute("type", parser.attribute("class").c_str());
+				object->group    = group;
+				object->x        = (float)parser.double_attribute("x");
+				object->y        = (float)parser.double_attribute("y");
+				object->width    = (float)parser.double_attribute("width");
+				object->height   = (float)parser.double_attribute("height");
+				object->rotation = (float)parser.double_attribute("rotation");
+				object->gid      = (Uint32)strtoul(parser.attribute("gid", "0").c_str(), nullptr, 10);
+				object->visible  = parser.int_attribute("visible", 1) != 0;
+			} else if (object != nullptr && parser.is("ellipse")) {
+				object->shape = MapObjectShape::ELLIPSE;
+			} else if (object != nullptr && parser.is("point")) {
+				object->shape = MapObjectShape::POINT;
+			} else if (object != nullptr && (parser.is("polygon") || parser.is("polyline"))) {
+				object->shape = MapObjectShape::POLYGON;
+			} else if (parser.is("layer")) {
+				_layers.emplace_back();
+				layer          = &_layers.back();
+				layer->id      = parser.int_attribute("id");
+				layer->name    = parser.attribute("name");
+				layer->width   = parser.int_attribute("width", _width);
+				layer->height  = parser.int_attribute("height", _height);
+				layer->visible = parser.int_attribute("visible", 1) != 0;
+				layer->opacity = (float)parser.double_attribute("opacity", 1.0);
+				if (layer->width <= 0 || layer->height <= 0) return fail("layer without a size");
+
+				// the whole layer is allocated once, the data is decoded in place
+				layer->tiles.assign((size_t)layer->width * layer->height, 0);
+			} else if (parser.is("data") && layer != nullptr) {
+				std::string encoding    = parser.attribute("encoding");
+				std::string compression = parser.attribute("compression");
+
+				if (encoding.empty()) {
+					format = XML;
+				} else if (encoding == "csv") {
+					format = CSV;
+				} else if (encoding == "base64") {
+					format = compression.empty() ? BASE64 : COMPRESSED;
+				} else {
+					return fail("unknown layer data encoding");
+				}
+				if (!compression.empty() && format != COMPRESSED) return fail("only base64 layer data can be compressed");
+
+				if (format == COMPRESSED) {
+					LayerInflater::Compression kind;
+					if (compression == "zlib" || compression == "gzip") {
+						kind = LayerInflater::ZLIB;
+					} else if (compression == "zstd") {
+						kind = LayerInflater::ZSTD;
+					} else {
+						return fail("unknown layer data compression");
+					}
+
+					Uint8 *out = (Uint8 *)layer->tiles.data();
+					if (!inflater.begin(kind, out, layer->tiles.size() * sizeof(Uint32))) {
+						return fail(inflater.get_error());
+					}
+				}
+
+				in_data    = true;
+				data_index = 0;
+			} else if (parser.is("chunk") && in_data) {
+				return fail("chunked layer data is not supported");
+			} else if (parser.is("tile") && in_data && format == XML) {
+				if (data_index < layer->tiles.size()) {
+					layer->tiles[data_index] = (Uint32)strtoul(parser.attribute("gid", "0").c_str(), nullptr, 10);
+				}
+				++data_index;
+			}
+		} else if (token == XmlPullParser::TEXT) {
+			if (!in_data || format == XML) continue;
+
+			const char *text = parser.get_text_begin();
+			const char *end  = parser.get_text_end();
+			const char *stop = text;
+
+			if (format == CSV) {
+				data_index += parse_csv_uints(text,
+				                              end,
+				                              layer->tiles.data() + data_index,
+				                              layer->tiles.size() - data_index,
+				                              &stop);
+
+				// a full layer must not have numbers left
+				for (; stop < end; ++stop) {
+					if (is_digit(*stop)) return fail("layer data does not match the layer size");
+				}
+				continue;
+			}
+
+			if (format == BASE64) {
+				// the tiles are stored as little endian bytes, decoded in place
+				Uint8 *out  = (Uint8 *)layer->tiles.data();
+				size_t size = layer->tiles.size() * sizeof(Uint32);
+				data_index += decode_base64(stop, end, out + data_index, size - data_index, &stop);
+			} else {
+				for (;;) {
+					size_t size = decode_base64(stop, end, chunk, sizeof(chunk), &stop);
+					if (size == 0) break;
+					if (!inflater.write(chunk, size)) return fail(inflater.get_error());
+				}
+			}
+
+			// anything left is past a full layer or is not base64
+			while (stop < end && BASE64_TABLE[(Uint8)*stop] == BASE64_SPACE) ++stop;
+			if (stop < end) {
+				bool full = format == BASE64 && data_index == layer->tiles.size() * sizeof(Uint32);
+				return fail(full ? "layer data does not match the layer size" : "invalid base64 layer data");
+			}
+		} else if (token == XmlPullParser::END) {
+			if (parser.is("tileset") && tileset != nullptr) {
+				std::vector<Uint32> &solid = tileset->solid_tiles;
+				std::sort(solid.begin(), solid.end());
+				solid.erase(std::unique(solid.begin(), solid.end()), solid.end());
+				tileset = nullptr;
+			} else if (parser.is("tile") && tileset != nullptr) {
+				tile_id = -1;
+			} else if (parser.is("objectgroup")) {
+				in_group = false;
+			} else if (parser.is("object")) {
+				object = nullptr;
+			} else if (parser.is("data") && in_data) {
+				in_data = false;
+
+				bool complete = false;
+				switch (format) {
+					case XML:
+					case CSV:
+						complete = data_index == layer->tiles.size();
+						break;
+					case BASE64:
+						complete = data_index == layer->tiles.size() * sizeof(Uint32);
+						break;
+					case COMPRESSED:
+						complete = inflater.is_complete();
+						break;
+				}
+				if (!complete) return fail("layer data does not match the layer size");
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+				if (format == BASE64 || format == COMPRESSED) {
+					for (Uint32 &tile : layer->tiles) tile = SDL_SwapLE32(tile);
+				}
+#endif
+			} else if (parser.is("layer")) {
+				layer = nullptr;
+			}
+		}
+	}
+
+	if (external == nullptr && (_width <= 0 || _height <= 0)) return fail("no map element");
+	return true;
+}
+
+void TileMap::build_collision() {
+	_collision_stride = (_width + 63) / 64;
+	_collision.assign((size_t)_collision_stride * _height, 0);
+
+	_chunk_columns = (_width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+	_chunk_rows    = (_height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+	_chunks.assign((size_t)_chunk_columns * _chunk_rows, MapChunk());
+
+	// solid flag per gid, looked up for every tile
+	std::vector<Uint8> solid_gids;
+	for (const TileSet &tileset : _tilesets) {
+		for (Uint32 local_id : tileset.solid_tiles) {
+			Uint32 gid = tileset.first_gid + local_id;
+			if (gid >= solid_gids.size()) solid_gids.resize(gid + 1, 0);
+			solid_gids[gid] = 1;
+		}
+	}
+
+	for (size_t i = 0; i < _layers.size(); ++i) {
+		const TileLayer &layer = _layers[i];
+		Uint32           bit   = i < 32 ? 1u << i : 0;
+		int              width = std::min(layer.width, _width);
+
+		for (int y = 0; y < std::min(layer.height, _height); ++y) {
+			MapChunk *chunks = &_chunks[(size_t)(y / TILE_CHUNK_SIZE) * _chunk_columns];
+			Uint64   *row    = &_collision[(size_t)y * _collision_stride];
+
+			for (int x = 0; x < width; ++x) {
+				Uint32 gid = layer.get_tile(x, y) & TILE_GID_MASK;
+				if (gid == 0) continue;
+
+				MapChunk &chunk = chunks[x / TILE_CHUNK_SIZE];
+				chunk.layer_mask |= bit;
+
+				bool solid = layer.collides || (gid < solid_gids.size() && solid_gids[gid]);
+				Uint64 mask = 1ull << (x % 64);
+				if (solid && !(row[x / 64] & mask)) {
+					row[x / 64] |= mask;
+					++chunk.solid_count;
+				}
+			}
+		}
+	}
+}
+
+void TileMap::set_solid(int x, int y, bool solid) {
+	if (x < 0 || y < 0 || x >= _width || y >= _height || is_solid(x, y) == solid) return;
+
+	Uint64   &word  = _collision[(size_t)y * _collision_stride + x / 64];
+	MapChunk &chunk = _chunks[(size_t)(y / TILE_CHUNK_SIZE) * _chunk_columns + x / TILE_CHUNK_SIZE];
+	word ^= 1ull << (x % 64);
+	chunk.solid_count += solid ? 1 : -1;
+}
+
+bool TileMap::find_open_tile(int x, int y, SDL_Point &open) const {
+	if (_width <= 0 || _height <= 0) return false;
+
+	x = std::clamp(x, 0, _width - 1);
+	y = std::clamp(y, 0, _height - 1);
+
+	// rings of tiles around (x, y), the closest open tile of the first ring having one
+	int radius_limit = std::max(_width, _height);
+	for (int radius = 0; radius < radius_limit; ++radius) {
+		int best = -1;
+		for (int ty = y - radius; ty <= y + radius; ++ty) {
+			if (ty < 0 || ty >= _height) continue;
+
+			// the rows between the first and the last one only have their two ends in the ring
+			int step = ty == y - radius || ty == y + radius ? 1 : std::max(radius * 2, 1);
+			for (int tx = x - radius; tx <= x + radius; tx += step) {
+				if (tx < 0 || tx >= _width || is_solid(tx, ty)) continue;
+
+				int distance = (tx - x) * (tx - x) + (ty - y) * (ty - y);
+				if (best >= 0 && distance >= best) continue;
+
+				best = distance;
+				open = {tx, ty};
+			}
+		}
+		if (best >= 0) return true;
+	}
+	return false;
+}
+
+bool TileMap::is_row_solid(int y, int x0, int x1) const {
+	if (y < 0 || y >= _height) return true;
+
+	// an empty span covers no tile
+	if (x1 < x0) return false;
+
+	x0 = std::max(x0, 0);
+	x1 = std::min(x1, _width - 1);
+
+	// the whole span is outside of the map
+	if (x1 < x0) return true;
+
+	// whole words of the row at once, masked at both ends
+	const Uint64 *row = get_collision_row(y);
+	for (int word = x0 / 64; word <= x1 / 64; ++word) {
+		Uint64 mask = ~0ull;
+		if (word == x0 / 64) mask &= ~0ull << (x0 % 64);
+		if (word == x1 / 64) mask &= ~0ull >> (63 - x1 % 64);
+		if (row[word] & mask) return true;
+	}
+	return false;
+}
+
+bool TileMap::is_column_solid(int x, int y0, int y1) const {
+	if (x < 0 || x >= _width) return true;
+
+	// an empty span covers no tile
+	if (y1 < y0) return false;
+
+	y0 = std::max(y0, 0);
+	y1 = std::min(y1, _height - 1);
+
+	// the whole span is outside of the map
+	if (y1 < y0) return true;
+
+	const Uint64 *word = _collision.data() + (size_t)y0 * _collision_stride + x / 64;
+	for (int y = y0; y <= y1; ++y, word += _collision_stride) {
+		if ((*word >> (x % 64)) & 1) return true;
+	}
+	return false;
+}
+
+namespace {
+	int first_tile(float start, int tile_size) {
+		return (int)floorf(start / tile_size);
+	}
+
+	// the far edge of a box is excluded, a box ending on a tile border does not cover the next tile
+	int last_tile(float end, int tile_size) {
+		return (int)ceilf(end / tile_size) - 1;
+	}
+
+	/**
+	 * Moves [start, start + size) by delta on an axis, is_blocked(i) tells
+	 * whether the line of tiles i stops it
+	 * @return the new start
+	 */
+	template <typename Blocked>
+	float sweep_axis(float start, float size, float delta, int tile_size, bool &blocked, Blocked is_blocked) {
+		if (delta > 0) {
+			int target = last_tile(start + size + delta, tile_size);
+			for (int i = last_tile(start + size, tile_size) + 1; i <= target; ++i) {
+				if (!is_blocked(i)) continue;
+
+				blocked = true;
+				return (float)i * tile_size - size;
+			}
+		} else if (delta < 0) {
+			int target = first_tile(start + delta, tile_size);
+			for (int i = first_tile(start, tile_size) - 1; i >= target; --i) {
+				if (!is_blocked(i)) continue;
+
+				blocked = true;
+				return (float)(i + 1) * tile_size;
+			}
+		}
+		return start + delta;
+	}
+} // namespace
+
+TileSweep TileMap::sweep(const SDL_FRect &box, float dx, float dy) const {
+	TileSweep result;
+	if (_collision.empty() || _tile_width <= 0 || _tile_height <= 0) {
+		result.x = box.x + dx;
+		result.y = box.y + dy;
+		return result;
+	}
+
+	int y0   = first_tile(box.y, _tile_height);
+	int y1   = last_tile(box.y + box.h, _tile_height);
+	result.x = sweep_axis(box.x, box.w, dx, _tile_width, result.blocked_x, [&](int x) {
+		result.tiles += y1 - y0 + 1;
+		return is_column_solid(x, y0, y1);
+	});
+
+	int x0   = first_tile(result.x, _tile_width);
+	int x1   = last_tile(result.x + box.w, _tile_width);
+	result.y = sweep_axis(box.y, box.h, dy, _tile_height, result.blocked_y, [&](int y) {
+		result.tiles += x1 - x0 + 1;
+		return is_row_solid(y, x0, x1);
+	});
+	return result;
+}
+
+namespace {
+	/**
+	 * Strings of a cooked map, each one stored once
+	 */
+	class StringTable {
+	  public:
+		Uint32 add(const std::string &value) {
+			auto it = _offsets.find(value);
+			if (it != _offsets.end()) return it->second;
+
+			Uint32 offset = (Uint32)_data.size();
+			_data.insert(_data.end(), value.begin(), value.end());
+			_data.push_back('\0');
+			_offsets[value] = offset;
+			return offset;
+		}
+
+		const std::vector<char> &get_data() const { return _data; }
+
+	  private:
+		std::vector<char>                       _data;
+		std::unordered_map<std::string, Uint32> _offsets;
+	};
+
+	template <typename T> void append(std::vector<char> &out, const T *values, size_t count) {
+		const char *bytes = (const char *)values;
+		out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+	}
+} // namespace
+
+void TileMap::cook(std::vector<char> &out, Uint64 source_hash) const {
+	StringTable strings;
+
+	std::vector<CookedTileSet> tilesets;
+	std::vector<Uint32>        solid_ids;
+	for (const TileSet &tileset : _tilesets) {
+		CookedTileSet cooked = {};
+		cooked.first_gid     = tileset.first_gid;
+		cooked.tile_width    = tileset.tile_width;
+		cooked.tile_height   = tileset.tile_height;
+		cooked.tile_count    = tileset.tile_count;
+		cooked.columns       = tileset.columns;
+		cooked.image_width   = tileset.image_width;
+		cooked.image_height  = tileset.image_height;
+		cooked.transparent   = tileset.transparent;
+		cooked.name          = strings.add(tileset.name);
+		cooked.source        = strings.add(tileset.source);
+		cooked.image         = strings.add(tileset.image);
+		cooked.solid_count   = (Uint32)tileset.solid_tiles.size();
+		tilesets.push_back(cooked);
+		solid_ids.insert(solid_ids.end(), tileset.solid_tiles.begin(), tileset.solid_tiles.end());
+	}
+
+	std::vector<CookedLayer> layers;
+	for (const TileLayer &layer : _layers) {
+		CookedLayer cooked = {};
+		cooked.id          = layer.id;
+		cooked.width       = layer.width;
+		cooked.height      = layer.height;
+		cooked.flags       = (layer.visible ? (Uint32)COOKED_LAYER_VISIBLE : 0) |
+		                     (layer.collides ? (Uint32)COOKED_LAYER_COLLIDES : 0);
+		cooked.opacity     = layer.opacity;
+		cooked.name        = strings.add(layer.name);
+		layers.push_back(cooked);
+	}
+
+	std::vector<CookedObject> objects;
+	for (const MapObject &object : _objects) {
+		CookedObject cooked = {};
+		cooked.id           = object.id;
+		cooked.gid          = object.gid;
+		cooked.shape        = (Uint32)object.shape;
+		cooked.visible      = object.visible ? 1 : 0;
+		cooked.name         = strings.add(object.name);
+		cooked.type         = strings.add(object.type);
+		cooked.group        = strings.add(object.group);
+		cooked.x            = object.x;
+		cooked.y            = object.y;
+		cooked.width        = object.width;
+		cooked.height       = object.height;
+		cooked.rotation     = object.rotation;
+		objects.push_back(cooked);
+	}
+
+	CookedMapHeader header  = {};
+	header.magic            = COOKED_MAP_MAGIC;
+	header.version          = COOKED_MAP_VERSION;
+	header.width            = (Uint32)_width;
+	header.height           = (Uint32)_height;
+	header.tile_width       = (Uint32)_tile_width;
+	header.tile_height      = (Uint32)_tile_height;
+	header.tileset_count    = (Uint32)tilesets.size();
+	header.layer_count      = (Uint32)layers.size();
+	header.object_count     = (Uint32)objects.size();
+	header.chunk_columns    = (Uint32)_chunk_columns;
+	header.chunk_rows       = (Uint32)_chunk_rows;
+	header.collision_stride = (Uint32)_collision_stride;
+	header.solid_count      = (Uint32)solid_ids.size();
+	header.strings_size     = (Uint32)strings.get_data().size();
+	header.source_hash      = source_hash;
+
+	out.clear();
+	append(out, &header, 1);
+	append(out, tilesets.data(), tilesets.size());
+	append(out, layers.data(), layers.size());
+	append(out, objects.data(), objects.size());
+	append(out, _chunks.data(), _chunks.size());
+	append(out, _collision.data(), _collision.size());
+	for (const TileLayer &layer : _layers) append(out, layer.tiles.data(), layer.tiles.size());
+	append(out, solid_ids.data(), solid_ids.size());
+	append(out, strings.get_data().data(), strings.get_data().size());
+
+	CookedMapHeader *written = (CookedMapHeader *)out.data();
+	written->data_size       = out.size() - sizeof(CookedMapHeader);
+}
+
+bool TileMap::load_cooked(const void *data, size_t size, const std::string &name) {
+	clear();
+
+	auto fail = [&](const char *error) {
+		printf("TileMap::load_cooked() - %s: %s\n", name.c_str(), error);
+		clear();
+		return false;
+	};
+
+	const CookedMapHeader *header = (const CookedMapHeader *)data;
+	if (size < sizeof(CookedMapHeader) || header->magic != COOKED_MAP_MAGIC) return fail("not a cooked map");
+	if (header->version != COOKED_MAP_VERSION) return fail("cooked by another version");
+	if (header->data_size != size - sizeof(CookedMapHeader)) return fail("truncated");
+
+	// the lookups index the collision and the chunks from the map size
+	if (header->collision_stride != (header->width + 63) / 64 ||
+	    header->chunk_columns != (header->width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE ||
+	    header->chunk_rows != (header->height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE) {
+		return fail("sections do not match the map size");
+	}
+
+	// the sections in order, sizes in 64 bits so that corrupt counts cannot wrap
+	const Uint8 *p    = (const Uint8 *)data + sizeof(CookedMapHeader);
+	const Uint8 *end  = (const Uint8 *)data + size;
+	auto         take = [&](Uint64 bytes) -> const Uint8 * {
+		if (bytes > (Uint64)(end - p)) return nullptr;
+		const Uint8 *section = p;
+		p += bytes;
+		return section;
+	};
+
+	auto tilesets  = (const CookedTileSet *)take((Uint64)header->tileset_count * sizeof(CookedTileSet));
+	auto layers    = (const CookedLayer *)take((Uint64)header->layer_count * sizeof(CookedLayer));
+	auto objects   = (const CookedObject *)take((Uint64)header->object_count * sizeof(CookedObject));
+	auto chunks    = (const MapChunk *)take((Uint64)header->chunk_columns * header->chunk_rows * sizeof(MapChunk));
+	auto collision = (const Uint64 *)take((Uint64)header->collision_stride * header->height * sizeof(Uint64));
+	if (tilesets == nullptr || layers == nullptr || objects == nullptr || chunks == nullptr || collision == nullptr) {
+		return fail("truncated");
+	}
+
+	std::vector<const Uint32 *> tiles(header->layer_count);
+	for (Uint32 i = 0; i < header->layer_count; ++i) {
+		if (layers[i].width <= 0 || layers[i].height <= 0) return fail("layer without a size");
+
+		tiles[i] = (const Uint32 *)take((Uint64)layers[i].width * layers[i].height * sizeof(Uint32));
+		if (tiles[i] == nullptr) return fail("truncated");
+	}
+
+	auto solid_ids = (const Uint32 *)take((Uint64)header->solid_count * sizeof(Uint32));
+	auto strings   = (const char *)take(header->strings_size);
+	if (solid_ids == nullptr || strings == nullptr || p != end) return fail("sections do not match the header");
+
+	if (header->strings_size > 0 && strings[header->strings_size - 1] != '\0') return fail("unterminated strings");
+	auto string = [&](Uint32 offset) {
+		return offset < header->strings_size ? std::string(strings + offset) : std::string();
+	};
+
+	_width       = (int)header->width;
+	_height      = (int)header->height;
+	_tile_width  = (int)header->tile_width;
+	_tile_height = (int)header->tile_height;
+
+	Uint32 solid_left = header->solid_count;
+	for (Uint32 i = 0; i < header->tileset_count; ++i) {
+		const CookedTileSet &cooked = tilesets[i];
+		if (cooked.solid_count > solid_left) return fail("solid tiles do not match the header");
+
+		TileSet tileset;
+		tileset.first_gid    = cooked.first_gid;
+		tileset.name         = string(cooked.name);
+		tileset.source       = string(cooked.source);
+		tileset.tile_width   = cooked.tile_width;
+		tileset.tile_height  = cooked.tile_height;
+		tileset.tile_count   = cooked.tile_count;
+		tileset.columns      = cooked.columns;
+		tileset.image        = string(cooked.image);
+		tileset.image_width  = cooked.image_width;
+		tileset.image_height = cooked.image_height;
+		tileset.transparent  = cooked.transparent;
+		tileset.solid_tiles.assign(solid_ids, solid_ids + cooked.solid_count);
+		_tilesets.push_back(tileset);
+
+		solid_ids += cooked.solid_count;
+		solid_left -= cooked.solid_count;
+	}
+
+	_layers.resize(header->layer_count);
+	for (Uint32 i = 0; i < header->layer_count; ++i) {
+		const CookedLayer &cooked = layers[i];
+		TileLayer         &layer  = _layers[i];
+		layer.id                  = cooked.id;
+		layer.name                = string(cooked.name);
+		layer.width               = cooked.width;
+		layer.height              = cooked.height;
+		layer.visible             = (cooked.flags & COOKED_LAYER_VISIBLE) != 0;
+		layer.collides            = (cooked.flags & COOKED_LAYER_COLLIDES) != 0;
+		layer.opacity             = cooked.opacity;
+		layer.tiles.assign(tiles[i], tiles[i] + (size_t)cooked.width * cooked.height);
+	}
+
+	_objects.resize(header->object_count);
+	for (Uint32 i = 0; i < header->object_count; ++i) {
+		const CookedObject &cooked = objects[i];
+		MapObject          &object = _objects[i];
+		object.id                  = cooked.id;
+		object.name                = string(cooked.name);
+		object.type                = string(cooked.type);
+		object.group               = string(cooked.group);
+		object.shape               = (MapObjectShape)cooked.shape;
+		object.x                   = cooked.x;
+		object.y                   = cooked.y;
+		object.width               = cooked.width;
+		object.height              = cooked.height;
+		object.rotation            = cooked.rotation;
+		object.gid                 = cooked.gid;
+		object.visible             = cooked.visible != 0;
+	}
+
+	_chunk_columns = (int)header->chunk_columns;
+	_chunk_rows    = (int)header->chunk_rows;
+	_chunks.assign(chunks, chunks + (size_t)_chunk_columns * _chunk_rows);
+
+	_collision_stride = (int)header->collision_stride;
+	_collision.assign(collision, collision + (size_t)_collision_stride * _height);
+	return true;
+}
+
+void TileMap::clear() {
+	_width       = 0;
+	_height      = 0;
+	_tile_width  = 0;
+	_tile_height = 0;
+	_layers.clear();
+	_tilesets.clear();
+	_objects.clear();
+
+	_collision.clear();
+	_collision_stride = 0;
+	_chunks.clear();
+	_chunk_columns = 0;
+	_chunk_rows    = 0;
+}
+
+const TileLayer *TileMap::find_layer(const std::string &name) const {
+	for (const TileLayer &layer : _layers) {
+		if (layer.name == name) return &layer;
+	}
+	return nullptr;
+}
+
+bool TileSet::is_solid(Uint32 local_id) const {
+	return std::binary_search(solid_tiles.begin(), solid_tiles.end(), local_id);
+}
+
+const TileSet *TileMap::find_tileset(Uint32 gid) const {
+	gid &= TILE_GID_MASK;
+
+	// tilesets are sorted by first gid, the last one starting before gid holds it
+	const TileSet *found = nullptr;
+	for (const TileSet &tileset : _tilesets) {
+		if (tileset.first_gid > gid) break;
+		found = &tileset;
+	}
+	return found;
+}
@@ -0,0 +1,246 @@
+#ifndef TILE_MAP_H
+#define TILE_MAP_H
+
+#pragma once
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+/**
+ * Tiled maps (.tmx), read by the game and by the tools.
+ *
+ * The file is read in a single pass by a pull parser, no DOM is built: each
+ * layer gets its tile array allocated from its size, then the <data> text is
+ * decoded straight into it from the file memory.
+ *
+ * Layer data can be csv, xml or base64. Base64 data can be compressed with
+ * zlib or gzip, and with zstd when built with TILE_MAP_ZSTD; compressed data
+ * is inflated in small chunks into the tile array, never into a copy.
+ *
+ * A tile is solid when its layer or its tile in the tileset has a "collides"
+ * property set to true. The solid tiles end up in a bitset, and the map is
+ * split in chunks of TILE_CHUNK_SIZE tiles that tell which layers draw in
+ * them. Both are built when the map or a tileset is parsed, or come cooked
+ * with the map.
+ */
+
+// flags Tiled stores in the high bits of a gid
+#define TILE_FLIPPED_HORIZONTALLY 0x80000000u
+#define TILE_FLIPPED_VERTICALLY   0x40000000u
+#define TILE_FLIPPED_DIAGONALLY   0x20000000u
+#define TILE_GID_MASK             0x0FFFFFFFu
+
+// side of a chunk, in tiles
+#define TILE_CHUNK_SIZE 16
+
+struct TileSet {
+	Uint32      first_gid = 1;
+	std::string name;
+	std::string source; // external .tsx, its tiles are not read
+
+	int tile_width  = 0;
+	int tile_height = 0;
+	int tile_count  = 0;
+	int columns     = 0;
+
+	std::string image; // relative to the map
+	int         image_width  = 0;
+	int         image_height = 0;
+	Sint32      transparent  = -1; // 0xRRGGBB, negative for none
+
+	std::vector<Uint32> solid_tiles; // local ids, sorted
+
+	bool is_solid(Uint32 local_id) const;
+};
+
+struct TileLayer {
+	int         id = 0;
+	std::string name;
+
+	int   width    = 0;
+	int   height   = 0;
+	bool  visible  = true;
+	bool  collides = false; // every tile of the layer is solid
+	float opacity  = 1.0f;
+
+	std::vector<Uint32> tiles; // gids row by row, 0 for no tile
+
+	Uint32 get_tile(int x, int y) const { return tiles[(size_t)y * width + x]; }
+};
+
+enum class MapObjectShape : Uint32 { RECTANGLE, ELLIPSE, POINT, POLYGON };
+
+/**
+ * An object of an object layer, in pixels. Polygons only keep their
+ * position, their points are not read.
+ */
+struct MapObject {
+	int            id = 0;
+	std::string    name;
+	std::string    type;  // "type" or "class" in Tiled
+	std::string    group; // name of its object layer
+	MapObjectShape shape = MapObjectShape::RECTANGLE;
+
+	float  x        = 0;
+	float  y        = 0;
+	float  width    = 0;
+	float  height   = 0;
+	float  rotation = 0; // degrees, clockwise
+	Uint32 gid      = 0; // tile objects only
+	bool   visible  = true;
+};
+
+struct MapChunk {
+	Uint32 layer_mask  = 0; // bit i set when layer i has a tile in the chunk, for the first 32 layers
+	Uint32 solid_count = 0;
+};
+
+/**
+ * Where a box swept through the map stopped
+ */
+struct TileSweep {
+	float x         = 0;
+	float y         = 0;
+	bool  blocked_x = false;
+	bool  blocked_y = false;
+	int   tiles     = 0; // tiles tested
+};
+
+class TileMap {
+  public:
+	/**
+	 * Reads a map from memory, the memory is not kept
+	 * @param name Used in error messages
+	 * @return false if the map is malformed or uses an encoding that is not supported
+	 */
+	bool parse(const char *xml, size_t size, const std::string &name = "map");
+
+	/**
+	 * Reads the external tileset (.tsx) of the map's tileset at index, the
+	 * maps referencing one only know its first gid and source until then
+	 */
+	bool parse_tileset(size_t index, const char *xml, size_t size, const std::string &name = "tileset");
+
+	/**
+	 * Loads a map compiled by cook(), the memory is not kept
+	 * @return false if the data is not a cooked map of this version
+	 */
+	bool load_cooked(const void *data, size_t size, const std::string &name = "map");
+
+	/**
+	 * Compiles the map in the format of cooked_map_format.h
+	 * @param source_hash Hash of the files the map comes from
+	 */
+	void cook(std::vector<char> &out, Uint64 source_hash) const;
+
+	void clear();
+
+	int get_width() const { return _width; }
+	int get_height() const { return _height; }
+	int get_tile_width() const { return _tile_width; }
+	int get_tile_height() const { return _tile_height; }
+
+	const std::vector<TileLayer> &get_layers() const { return _layers; }
+	const std::vector<TileSet>   &get_tilesets() const { return _tilesets; }
+	const std::vector<MapObject> &get_objects() const { return _objects; }
+
+	bool is_solid(int x, int y) const {
+		if (x < 0 || y < 0 || x >= _width || y >= _height || _collision.empty()) return false;
+		return (_collision[(size_t)y * _collision_stride + x / 64] >> (x % 64)) & 1;
+	}
+
+	/**
+	 * Makes a tile solid or not while the game runs (a gate, a wall being
+	 * built), the layers are left as they are
+	 */
+	void set_solid(int x, int y, bool solid);
+
+	/**
+	 * Finds a tile that is not solid around (x, y), clamped to the map, in the
+	 * first ring of tiles around it having one
+	 * @return false if every tile is solid
+	 */
+	bool find_open_tile(int x, int y, SDL_Point &open) const;
+
+	/**
+	 * @return the collision bits of a row, bit x % 64 of word x / 64
+	 */
+	const Uint64 *get_collision_row(int y) const { return _collision.data() + (size_t)y * _collision_stride; }
+	int           get_collision_stride() const { return _collision_stride; }
+
+	/**
+	 * Moves a box by dx then by dy, in pixels, and stops it against the first
+	 * solid tile or map edge it meets on each axis. Only the lines of tiles
+	 * its leading edge crosses are tested, so a fast box cannot tunnel through
+	 * a wall and a move costs the tiles crossed. A box that already overlaps
+	 * solid tiles can leave them.
+	 */
+	TileSweep sweep(const SDL_FRect &box, float dx, float dy) const;
+
+	int                          get_chunk_columns() const { return _chunk_columns; }
+	int                          get_chunk_rows() const { return _chunk_rows; }
+	const std::vector<MapChunk> &get_chunks() const { return _chunks; }
+
+	const TileLayer *find_layer(const std::string &name) const;
+
+	/**
+	 * @return the tileset holding the gid, flip flags are ignored
+	 */
+	const TileSet *find_tileset(Uint32 gid) const;
+
+  private:
+	/**
+	 * Reads a .tmx, or a .tsx into external
+	 */
+	bool read(const char *xml, size_t size, const std::string &name, TileSet *external);
+
+	/**
+	 * Builds the collision bitset and the chunks from the layers and the tilesets
+	 */
+	void build_collision();
+
+	/**
+	 * @return true if a tile of the row or column between the given tiles
+	 * included is solid, or if the row, column or whole span is outside of the map
+	 */
+	bool is_row_solid(int y, int x0, int x1) const;
+	bool is_column_solid(int x, int y0, int y1) const;
+
+	int _width       = 0;
+	int _height      = 0;
+	int _tile_width  = 0;
+	int _tile_height = 0;
+
+	std::vector<TileLayer> _layers;
+	std::vector<TileSet>   _tilesets;
+	std::vector<MapObject> _objects;
+
+	std::vector<Uint64>   _collision;
+	int                   _collision_stride = 0; // words per row
+	std::vector<MapChunk> _chunks;
+	int                   _chunk_columns = 0;
+	int                   _chunk_rows    = 0;
+};
+
+/**
+ * Reads the unsigned integers of a comma separated list, any character that is
+ * not a digit separates two numbers. Digits are found 16 bytes at a time with
+ * SSE2 or wasm simd128, numbers of up to 8 digits are converted with a few
+ * 64 bit multiplies.
+ * @param stop Where the parsing stopped, the end unless out is full
+ * @return the number of values written to out, at most capacity
+ */
+size_t parse_csv_uints(const char *begin, const char *end, Uint32 *out, size_t capacity, const char **stop = nullptr);
+
+/**
+ * Decodes base64 text, whitespace is skipped and the padding ends the data.
+ * Groups of 4 characters without whitespace are decoded with one table lookup
+ * per character and no branch.
+ * @param stop Where the decoding stopped: the end, the padding, an invalid
+ * character or the first group that does not fit in out
+ * @return the number of bytes written to out, at most capacity
+ */
+size_t decode_base64(const char *begin, const char *end, Uint8 *out, size_t capacity, const char **stop = nullptr);
+
+#endif
@@ -39,6 +39,14 @@ enum class MouseButton {
  */
 enum class Direction { NONE, UP, DOWN, LEFT, RIGHT };
 
+/**
+ * Enum for the actions keys are bound to.
+ * MOVE_*: Moves the player.
+ * RUN: Runs instead of walking.
+ * COUNT: Number of actions, not an action.
+ */
+enum class InputAction { MOVE_UP, MOVE_DOWN, MOVE_LEFT, MOVE_RIGHT, RUN, COUNT };
+
 /**
  * Enum for animation directions.
  * FORWARD: Animation plays forward once.
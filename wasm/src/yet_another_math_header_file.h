@@ -8,28 +8,65 @@ class Vector2 {
 	T x = 0.0f;
 	T y = 0.0f;
 
-	Vector2<T>() = default;
-	Vector2<T>(T x, T y): x(x), y(y) {}
+	constexpr Vector2<T>() = default;
+	constexpr Vector2<T>(T x, T y): x(x), y(y) {}
 
-	Vector2<T> operator+(const Vector2<T>& other) const { return Vector2<T>(x + other.x, y + other.y); }
-	Vector2<T> operator-(const Vector2<T>& other) const { return Vector2<T>(x - other.x, y - other.y); }
-	Vector2<T> operator*(const Vector2<T>& other) const { return Vector2<T>(x * other.x, y * other.y); }
-	Vector2<T> operator/(const Vector2<T>& other) const { return Vector2<T>(x / other.x, y / other.y); }
+	constexpr Vector2<T> operator+(const Vector2<T>& other) const { return Vector2<T>(x + other.x, y + other.y); }
+	constexpr Vector2<T> operator-(const Vector2<T>& other) const { return Vector2<T>(x - other.x, y - other.y); }
+	constexpr Vector2<T> operator*(const Vector2<T>& other) const { return Vector2<T>(x * other.x, y * other.y); }
+	constexpr Vector2<T> operator/(const Vector2<T>& other) const { return Vector2<T>(x / other.x, y / other.y); }
 
-	Vector2<T> operator+(T scalar) const { return Vector2<T>(x + scalar, y + scalar); }
-	Vector2<T> operator-(T scalar) const { return Vector2<T>(x - scalar, y - scalar); }
-	Vector2<T> operator*(T scalar) const { return Vector2<T>(x * scalar, y * scalar); }
-	Vector2<T> operator/(T scalar) const { return Vector2<T>(x / scalar, y / scalar); }
+	constexpr Vector2<T> operator+(T scalar) const { return Vector2<T>(x + scalar, y + scalar); }
+	constexpr Vector2<T> operator-(T scalar) const { return Vector2<T>(x - scalar, y - scalar); }
+	constexpr Vector2<T> operator*(T scalar) const { return Vector2<T>(x * scalar, y * scalar); }
+	constexpr Vector2<T> operator/(T scalar) const { return Vector2<T>(x / scalar, y / scalar); }
 
-	Vector2<T> operator+=(const Vector2<T>& other) { return *this = *this + other; }
-	Vector2<T> operator-=(const Vector2<T>& other) { return *this = *this - other; }
-	Vector2<T> operator*=(const Vector2<T>& other) { return *this = *this * other; }
-	Vector2<T> operator/=(const Vector2<T>& other) { return *this = *this / other; }
+	constexpr Vector2<T> operator-() const { return Vector2<T>(-x, -y); }
 
-	Vector2<T> operator+=(T scalar) { return *this = *this + scalar; }
-	Vector2<T> operator-=(T scalar) { return *this = *this - scalar; }
-	Vector2<T> operator*=(T scalar) { return *this = *this * scalar; }
-	Vector2<T> operator/=(T scalar) { return *this = *this / scalar; }
+	constexpr Vector2<T>& operator+=(const Vector2<T>& other) {
+		x += other.x;
+		y += other.y;
+		return *this;
+	}
+	constexpr Vector2<T>& operator-=(const Vector2<T>& other) {
+		x -= other.x;
+		y -= other.y;
+		return *this;
+	}
+	constexpr Vector2<T>& operator*=(const Vector2<T>& other) {
+		x *= other.x;
+		y *= other.y;
+		return *this;
+	}
+	constexpr Vector2<T>& operator/=(const Vector2<T>& other) {
+		x /= other.x;
+		y /= other.y;
+		return *this;
+	}
+
+	constexpr Vector2<T>& operator+=(T scalar) {
+		x += scalar;
+		y += scalar;
+		return *this;
+	}
+	constexpr Vector2<T>& operator-=(T scalar) {
+		x -= scalar;
+		y -= scalar;
+		return *this;
+	}
+	constexpr Vector2<T>& operator*=(T scalar) {
+		x *= scalar;
+		y *= scalar;
+		return *this;
+	}
+	constexpr Vector2<T>& operator/=(T scalar) {
+		x /= scalar;
+		y /= scalar;
+		return *this;
+	}
+
+	constexpr bool operator==(const Vector2<T>& other) const { return x == other.x && y == other.y; }
+	constexpr bool operator!=(const Vector2<T>& other) const { return !(*this == other); }
 
 	Vector2<T> normalized() const {
 		T mag = magnitude();
@@ -37,10 +74,10 @@ class Vector2 {
 		return Vector2<T>(x / mag, y / mag);
 	}
 
-	T dot(const Vector2<T>& other) const { return x * other.x + y * other.y; }
-	T cross(const Vector2<T>& other) const { return x * other.y - y * other.x; }
+	constexpr T dot(const Vector2<T>& other) const { return x * other.x + y * other.y; }
+	constexpr T cross(const Vector2<T>& other) const { return x * other.y - y * other.x; }
 
-	Vector2<T> lerp(const Vector2<T>& other, float t) const {
+	constexpr Vector2<T> lerp(const Vector2<T>& other, float t) const {
 		return Vector2<T>(x + t * (other.x - x), y + t * (other.y - y));
 	}
 	Vector2<T> slerp(const Vector2<T>& other, float t) const {
@@ -70,14 +107,15 @@ class Vector2 {
 		return result;
 	}
 
-	T magnitude() const { return std::sqrt(x * x + y * y); }
+	T           magnitude() const { return std::sqrt(x * x + y * y); }
+	constexpr T magnitude_squared() const { return x * x + y * y; }
 
-	static Vector2<T> zero() { return Vector2<T>(0, 0); }
-	static Vector2<T> one() { return Vector2<T>(1, 1); }
-	static Vector2<T> up() { return Vector2<T>(0, 1); }
-	static Vector2<T> down() { return Vector2<T>(0, -1); }
-	static Vector2<T> left() { return Vector2<T>(-1, 0); }
-	static Vector2<T> right() { return Vector2<T>(1, 0); }
+	static constexpr Vector2<T> zero() { return Vector2<T>(0, 0); }
+	static constexpr Vector2<T> one() { return Vector2<T>(1, 1); }
+	static constexpr Vector2<T> up() { return Vector2<T>(0, 1); }
+	static constexpr Vector2<T> down() { return Vector2<T>(0, -1); }
+	static constexpr Vector2<T> left() { return Vector2<T>(-1, 0); }
+	static constexpr Vector2<T> right() { return Vector2<T>(1, 0); }
 };
 
 typedef Vector2<int>          Vector2i;
@@ -86,6 +124,6 @@ typedef Vector2<float>        Vector2f;
 typedef Vector2<double>       Vector2d;
 
 template<typename T>
-T lerp(T a, T b, float t) {
+constexpr T lerp(T a, T b, float t) {
 	return a + t * (b - a);
 }
\ No newline at end of file
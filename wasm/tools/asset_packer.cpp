@@ -0,0 +1,394 @@
+#include "../src/asset_archive_format.h"
+#include "../src/cooked_map_format.h"
+#include "../src/cooked_texture_format.h"
+#include "../src/image_pipeline.h"
+#include "../src/lz4_block.h"
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Packs the assets listed in the manifest into a single archive.
+ * Usage: asset_packer <assets directory> <manifest> <output> [cooked maps directory]
+ *
+ * PNG images are cooked: decoded, run through the image pipeline and stored
+ * as "<path>.tex" instead of the image, so the game never inflates them.
+ * A manifest line may list pipeline options (see parse_image_option):
+ *   images/characters_bg.png key=ff00ff premultiply
+ *
+ * Indexed images get one palette table per variant, built from the color
+ * swaps of "<image>.<variant>.pal" next to the image.
+ *
+ * Maps are cooked by tools/mapcook into the cooked maps directory, mirroring
+ * the assets directory; "<path>.cmap" is stored next to the .tmx, which is
+ * kept for the game to fall back to.
+ */
+
+namespace {
+	struct PackedAsset {
+		std::string       path;
+		std::vector<char> data;
+		ArchiveEntry      entry;
+	};
+
+	bool read_file(const std::string &path, std::vector<char> &data) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	bool ends_with(const std::string &value, const std::string &suffix) {
+		return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	/**
+	 * Appends the pixels, LZ4 compressed when it pays off; raw pixels are
+	 * uploaded in place so they are kept when compression saves little
+	 * @return the compression used
+	 */
+	uint32_t append_pixels(std::vector<char> &out, const uint8_t *pixels, size_t size) {
+		std::vector<uint8_t> compressed(lz4_compress_bound(size));
+		size_t               compressed_size = lz4_compress(pixels, size, compressed.data(), compressed.size());
+
+		if (compressed_size > 0 && compressed_size < size - size / 4) {
+			out.insert(out.end(), compressed.begin(), compressed.begin() + compressed_size);
+			return COOKED_LZ4;
+		}
+
+		out.insert(out.end(), pixels, pixels + size);
+		return COOKED_RAW;
+	}
+
+	/**
+	 * Tile table followed by the tiles, each one aligned for in place uploads.
+	 * Identical tiles, empty ones first of all, are stored once.
+	 * @param bytes Bytes per texel, 1 for palette indices
+	 */
+	std::vector<char> cook_tiles(const uint8_t *texels, size_t pitch, uint32_t bytes, const CookedTextureHeader &header) {
+		uint32_t columns = (header.width + header.tile_size - 1) / header.tile_size;
+		uint32_t rows    = (header.height + header.tile_size - 1) / header.tile_size;
+
+		std::vector<CookedTile> tiles(columns * rows);
+		std::vector<char>       blobs;
+		std::vector<uint8_t>    pixels;
+
+		std::map<uint64_t, std::pair<CookedTile, std::vector<uint8_t>>> stored;
+		size_t                                                          shared = 0;
+
+		for (uint32_t row = 0; row < rows; ++row) {
+			for (uint32_t column = 0; column < columns; ++column) {
+				uint32_t x = column * header.tile_size;
+				uint32_t y = row * header.tile_size;
+				uint32_t w = std::min(header.tile_size, header.width - x);
+				uint32_t h = std::min(header.tile_size, header.height - y);
+
+				// rows of 8-bit surfaces are padded to 4 bytes by SDL
+				size_t tile_pitch = bytes == 1 ? (w + 3) & ~3u : (size_t)w * bytes;
+				pixels.assign(tile_pitch * h, 0);
+				for (uint32_t line = 0; line < h; ++line) {
+					memcpy(pixels.data() + line * tile_pitch,
+					       texels + (size_t)(y + line) * pitch + (size_t)x * bytes,
+					       (size_t)w * bytes);
+				}
+
+				CookedTile &tile = tiles[row * columns + column];
+				uint64_t    hash = archive_hash(pixels.data(), pixels.size());
+
+				auto it = stored.find(hash);
+				if (it != stored.end() && it->second.second == pixels) {
+					tile = it->second.first;
+					shared++;
+					continue;
+				}
+
+				blobs.resize((blobs.size() + ARCHIVE_ALIGNMENT - 1) & ~(size_t)(ARCHIVE_ALIGNMENT - 1));
+
+				tile.offset      = blobs.size();
+				tile.compression = append_pixels(blobs, pixels.data(), pixels.size());
+				tile.size        = blobs.size() - tile.offset;
+				stored.emplace(hash, std::make_pair(tile, pixels));
+			}
+		}
+
+		if (shared > 0) printf("%zu of %zu tiles are duplicates, stored once\n", shared, tiles.size());
+
+		std::vector<char> data(tiles.size() * sizeof(CookedTile));
+		memcpy(data.data(), tiles.data(), data.size());
+		data.insert(data.end(), blobs.begin(), blobs.end());
+		return data;
+	}
+
+	/**
+	 * Palette tables of an indexed image, its own colors then one table per variant
+	 */
+	bool cook_palettes(const std::string         &root,
+	                   const std::string         &path,
+	                   const std::vector<Uint32> &colors,
+	                   const ImageOptions        &options,
+	                   std::vector<char>         &out,
+	                   uint64_t                  &source_hash) {
+		std::vector<CookedPalette> palettes(1 + options.palettes.size());
+		std::copy(colors.begin(), colors.end(), palettes[0].colors);
+
+		for (size_t i = 0; i < options.palettes.size(); ++i) {
+			const std::string &variant    = options.palettes[i];
+			std::string        swaps_path = get_palette_path(path, variant);
+
+			std::vector<char>      text;
+			std::vector<ColorSwap> swaps;
+			if (variant.size() >= sizeof(palettes[i + 1].name) || !read_file(root + swaps_path, text) ||
+			    !parse_color_swaps(std::string(text.begin(), text.end()), swaps)) {
+				printf("Failed to read palette %s of %s\n", swaps_path.c_str(), path.c_str());
+				return false;
+			}
+
+			// an edited palette makes the texture stale like an edited image
+			source_hash = archive_hash(text.data(), text.size(), source_hash);
+
+			for (const ColorSwap &swap : swaps) {
+				Uint32 texel = ((swap.from >> 16) & 0xFF) | (swap.from & 0xFF00) | ((swap.from & 0xFF) << 16);
+				bool   found = false;
+				for (Uint32 color : colors) found |= (color & 0x00FFFFFF) == texel;
+				if (!found) printf("%s: %06x is not a color of %s\n", swaps_path.c_str(), swap.from, path.c_str());
+			}
+
+			CookedPalette &palette = palettes[i + 1];
+			memcpy(palette.colors, palettes[0].colors, sizeof(palette.colors));
+			strncpy(palette.name, variant.c_str(), sizeof(palette.name));
+			apply_color_swaps((Uint8 *)palette.colors, 256, swaps);
+		}
+
+		out.resize(palettes.size() * sizeof(CookedPalette));
+		memcpy(out.data(), palettes.data(), out.size());
+		return true;
+	}
+
+	/**
+	 * Decodes the image and replaces its data with the cooked texture
+	 */
+	bool cook_texture(PackedAsset &asset, const ImageOptions &options, const std::string &root) {
+		SDL_RWops   *rw      = SDL_RWFromConstMem(asset.data.data(), (int)asset.data.size());
+		SDL_Surface *decoded = IMG_Load_RW(rw, 1);
+		if (decoded == nullptr) {
+			printf("Failed to decode %s: %s\n", asset.path.c_str(), IMG_GetError());
+			return false;
+		}
+
+		SDL_Surface *surface = process_image(decoded, options);
+		if (surface == nullptr) return false;
+
+		CookedTextureHeader header = {};
+		header.magic               = COOKED_TEXTURE_MAGIC;
+		header.version             = COOKED_TEXTURE_VERSION;
+		header.format              = SDL_PIXELFORMAT_RGBA32;
+		header.width               = (uint32_t)surface->w;
+		header.height              = (uint32_t)surface->h;
+		header.pitch               = (uint32_t)surface->pitch;
+		header.flags               = options.premultiply ? (uint32_t)COOKED_PREMULTIPLIED : 0u;
+		header.source_hash         = asset.entry.content_hash;
+
+		// palette indices instead of colors, padded like SDL pads 8-bit surfaces
+		std::vector<Uint8>  indices;
+		std::vector<Uint32> colors;
+		const uint8_t      *texels = (const uint8_t *)surface->pixels;
+		size_t              pitch  = (size_t)surface->pitch;
+		uint32_t            bytes  = 4;
+		std::vector<char>   data;
+
+		if (options.indexed && options.premultiply) {
+			printf("%s: indexed images cannot be premultiplied\n", asset.path.c_str());
+			SDL_FreeSurface(surface);
+			return false;
+		}
+
+		if (options.indexed && !index_image(surface, indices, colors)) {
+			printf("%s: more than 256 colors, cooked without a palette\n", asset.path.c_str());
+		} else if (options.indexed) {
+			if (!cook_palettes(root, asset.path, colors, options, data, header.source_hash)) {
+				SDL_FreeSurface(surface);
+				return false;
+			}
+
+			pitch = (header.width + 3) & ~3u;
+			std::vector<Uint8> padded(pitch * header.height, 0);
+			for (uint32_t y = 0; y < header.height; ++y) {
+				memcpy(padded.data() + y * pitch, indices.data() + (size_t)y * header.width, header.width);
+			}
+			indices.swap(padded);
+
+			texels               = indices.data();
+			bytes                = 1;
+			header.format        = SDL_PIXELFORMAT_INDEX8;
+			header.pitch         = (uint32_t)pitch;
+			header.flags        |= COOKED_INDEXED;
+			header.palette_count = (uint32_t)(1 + options.palettes.size());
+		}
+
+		if (options.tile_size > 0) {
+			header.flags |= COOKED_TILED;
+			header.tile_size = options.tile_size;
+
+			std::vector<char> tiles = cook_tiles(texels, pitch, bytes, header);
+			data.insert(data.end(), tiles.begin(), tiles.end());
+		} else {
+			header.compression = append_pixels(data, texels, pitch * header.height);
+		}
+		header.data_size = data.size();
+		SDL_FreeSurface(surface);
+
+		std::vector<char> cooked(sizeof(header));
+		memcpy(cooked.data(), &header, sizeof(header));
+		cooked.insert(cooked.end(), data.begin(), data.end());
+
+		printf("Cooked %s: %ux%u, %s%s, %zu -> %zu bytes\n",
+		       asset.path.c_str(),
+		       header.width,
+		       header.height,
+		       header.tile_size > 0 ? "tiled" : header.compression == COOKED_LZ4 ? "lz4" : "raw",
+		       header.palette_count > 0 ? ", indexed" : "",
+		       asset.data.size(),
+		       cooked.size());
+
+		asset.path += COOKED_TEXTURE_EXTENSION;
+		asset.data.swap(cooked);
+		return true;
+	}
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc != 4 && argc != 5) {
+		printf("Usage: %s <assets directory> <manifest> <output> [cooked maps directory]\n", argv[0]);
+		return 1;
+	}
+
+	std::string root = argv[1];
+	if (!root.empty() && root.back() != '/') root += '/';
+
+	std::string cooked_root = argc == 5 ? argv[4] : "";
+	if (!cooked_root.empty() && cooked_root.back() != '/') cooked_root += '/';
+
+	std::ifstream manifest(argv[2]);
+	if (!manifest) {
+		printf("Failed to open manifest: %s\n", argv[2]);
+		return 1;
+	}
+
+	std::vector<PackedAsset> assets;
+	std::string              line;
+	while (std::getline(manifest, line)) {
+		std::istringstream tokens(line);
+		std::string        path, option;
+		if (!(tokens >> path) || path[0] == '#') continue;
+
+		ImageOptions options;
+		while (tokens >> option) {
+			if (!parse_image_option(option, options)) {
+				printf("Unknown or invalid option for %s: %s\n", path.c_str(), option.c_str());
+				return 1;
+			}
+		}
+
+		PackedAsset asset;
+		asset.path = path;
+		if (!read_file(root + path, asset.data)) {
+			printf("Failed to read asset: %s%s\n", root.c_str(), path.c_str());
+			return 1;
+		}
+
+		// the cooked texture records the hash of the image it comes from
+		asset.entry.content_hash = archive_hash(asset.data.data(), asset.data.size());
+		if (ends_with(path, ".png") && !cook_texture(asset, options, root)) return 1;
+
+		asset.entry.path_hash = archive_hash(asset.path.data(), asset.path.size());
+		asset.entry.size      = asset.data.size();
+		assets.push_back(std::move(asset));
+
+		if (ends_with(path, ".tmx") && !cooked_root.empty()) {
+			PackedAsset map;
+			map.path = path + COOKED_MAP_EXTENSION;
+
+			const CookedMapHeader *header = nullptr;
+			if (read_file(cooked_root + map.path, map.data) && map.data.size() >= sizeof(CookedMapHeader)) {
+				header = (const CookedMapHeader *)map.data.data();
+			}
+			if (header == nullptr || header->magic != COOKED_MAP_MAGIC || header->version != COOKED_MAP_VERSION) {
+				printf("No cooked map for %s, the game will parse it\n", path.c_str());
+				continue;
+			}
+
+			map.entry.content_hash = archive_hash(map.data.data(), map.data.size());
+			map.entry.path_hash    = archive_hash(map.path.data(), map.path.size());
+			map.entry.size         = map.data.size();
+			assets.push_back(std::move(map));
+		}
+	}
+
+	// the game binary searches the index by path hash
+	std::sort(assets.begin(), assets.end(), [](const PackedAsset &a, const PackedAsset &b) {
+		return a.entry.path_hash < b.entry.path_hash;
+	});
+
+	for (size_t i = 1; i < assets.size(); ++i) {
+		if (assets[i].entry.path_hash != assets[i - 1].entry.path_hash) continue;
+
+		printf("Duplicate or colliding paths: %s, %s\n", assets[i - 1].path.c_str(), assets[i].path.c_str());
+		return 1;
+	}
+
+	auto align = [](uint64_t offset) { return (offset + ARCHIVE_ALIGNMENT - 1) & ~(uint64_t)(ARCHIVE_ALIGNMENT - 1); };
+
+	// the paths follow the index, the blobs come after them
+	uint64_t offset = sizeof(ArchiveHeader) + assets.size() * sizeof(ArchiveEntry);
+	for (PackedAsset &asset : assets) {
+		asset.entry.path_offset = (uint32_t)offset;
+		asset.entry.path_size   = (uint32_t)asset.path.size();
+		offset += asset.path.size();
+	}
+
+	offset = align(offset);
+	for (PackedAsset &asset : assets) {
+		asset.entry.offset = offset;
+		offset             = align(offset + asset.entry.size);
+	}
+
+	std::ofstream output(argv[3], std::ios::binary | std::ios::trunc);
+	if (!output) {
+		printf("Failed to create archive: %s\n", argv[3]);
+		return 1;
+	}
+
+	ArchiveHeader header = {ARCHIVE_MAGIC, ARCHIVE_VERSION, (uint32_t)assets.size(), 0};
+	output.write((const char *)&header, sizeof(header));
+	for (const PackedAsset &asset : assets) {
+		output.write((const char *)&asset.entry, sizeof(asset.entry));
+	}
+	for (const PackedAsset &asset : assets) {
+		output.write(asset.path.data(), asset.path.size());
+	}
+
+	static const char padding[ARCHIVE_ALIGNMENT] = {};
+	for (const PackedAsset &asset : assets) {
+		output.write(padding, asset.entry.offset - (uint64_t)output.tellp());
+		output.write(asset.data.data(), asset.data.size());
+	}
+	output.write(padding, offset - (uint64_t)output.tellp());
+
+	if (!output) {
+		printf("Failed to write archive: %s\n", argv[3]);
+		return 1;
+	}
+
+	printf("Packed %zu assets into %s (%llu bytes)\n", assets.size(), argv[3], (unsigned long long)offset);
+	return 0;
+}
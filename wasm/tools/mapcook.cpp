@@ -0,0 +1,83 @@
+#include "../src/asset_archive_format.h"
+#include "../src/cooked_map_format.h"
+#include "../src/tile_map.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/**
+ * Compiles a Tiled map and its external tilesets into a cooked map (see
+ * cooked_map_format.h), which the asset packer stores next to the map.
+ * Usage: mapcook <map.tmx> <output>
+ *
+ * The cooked map records the hash of the files it comes from, the game
+ * parses the .tmx instead when it finds an edited one next to the archive.
+ */
+
+namespace {
+	bool read_file(const std::string &path, std::vector<char> &data) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		printf("Usage: %s <map.tmx> <output>\n", argv[0]);
+		return 1;
+	}
+
+	std::string path      = argv[1];
+	std::string directory = path.substr(0, path.find_last_of('/') + 1);
+
+	std::vector<char> text;
+	if (!read_file(path, text)) {
+		printf("Failed to read map: %s\n", path.c_str());
+		return 1;
+	}
+
+	TileMap map;
+	if (!map.parse(text.data(), text.size(), path)) return 1;
+
+	Uint64 source_hash = archive_hash(text.data(), text.size());
+	for (size_t i = 0; i < map.get_tilesets().size(); ++i) {
+		std::string source = map.get_tilesets()[i].source;
+		if (source.empty()) continue;
+
+		if (!read_file(directory + source, text)) {
+			printf("Failed to read tileset: %s%s\n", directory.c_str(), source.c_str());
+			return 1;
+		}
+		if (!map.parse_tileset(i, text.data(), text.size(), directory + source)) return 1;
+		source_hash = archive_hash(text.data(), text.size(), source_hash);
+	}
+
+	std::vector<char> cooked;
+	map.cook(cooked, source_hash);
+
+	std::ofstream output(argv[2], std::ios::binary | std::ios::trunc);
+	output.write(cooked.data(), cooked.size());
+	if (!output) {
+		printf("Failed to write cooked map: %s\n", argv[2]);
+		return 1;
+	}
+
+	Uint32 solid = 0;
+	for (const MapChunk &chunk : map.get_chunks()) solid += chunk.solid_count;
+
+	printf("Cooked %s: %dx%d, %zu layers, %zu objects, %u solid tiles (%zu bytes)\n",
+	       path.c_str(),
+	       map.get_width(),
+	       map.get_height(),
+	       map.get_layers().size(),
+	       map.get_objects().size(),
+	       solid,
+	       cooked.size());
+	return 0;
+}
@@ -0,0 +1,264 @@
+#include "../src/tile_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <tinyxml2.h>
+#include <vector>
+
+/**
+ * Compares the ways a map can be read: tinyxml2 copying the text into its own
+ * buffer, tinyxml2 tokenizing the loaded text in place, the same with an arena
+ * kept between loads, and the TileMap pull parser. Every mode reads the same
+ * text already in memory, the time, the peak heap and the heap allocations
+ * only cover the parse; the tinyxml2 modes stop at the DOM while TileMap also
+ * decodes the layers.
+ * Usage: xml_benchmark [map.tmx ...] [--small <file.xml>]
+ *
+ * Synthetic csv maps of 6 layers are measured after the given maps. A file
+ * given with --small is loaded 50 times in a row, like the animation files of
+ * a scene, each time in a new document with and without a shared arena.
+ */
+
+namespace {
+	size_t heap_current     = 0;
+	size_t heap_peak        = 0;
+	size_t heap_allocations = 0;
+
+	void reset_heap_peak() {
+		heap_peak = heap_current;
+	}
+
+	bool read_file(const std::string &path, std::vector<char> &data) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) return false;
+
+		data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	/**
+	 * A map of 6 csv layers with a few distinct gids, laid out like Tiled does
+	 */
+	std::vector<char> make_map(int width, int height) {
+		std::string text = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+		char        line[256];
+
+		snprintf(line,
+		         sizeof(line),
+		         "<map version=\"1.10\" orientation=\"orthogonal\" width=\"%d\" height=\"%d\" tilewidth=\"16\" "
+		         "tileheight=\"16\" infinite=\"0\">\n",
+		         width,
+		         height);
+		text += line;
+		text += " <tileset firstgid=\"1\" name=\"buildings_1\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"864\" "
+		        "columns=\"16\">\n  <image source=\"buildings_1.png\" trans=\"ff00ff\" width=\"256\" height=\"864\"/>\n"
+		        " </tileset>\n";
+
+		Uint32 seed = 1;
+		for (int layer = 1; layer <= 6; ++layer) {
+			snprintf(line,
+			         sizeof(line),
+			         " <layer id=\"%d\" name=\"layer_%d\" width=\"%d\" height=\"%d\">\n",
+			         layer,
+			         layer,
+			         width,
+			         height);
+			text += line;
+			text += "  <data encoding=\"csv\">\n";
+
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
+					seed = seed * 1664525u + 1013904223u;
+
+					// mostly empty, like the upper layers of a real map
+					Uint32 gid = (seed >> 24) < 160 ? 0 : 1 + (seed >> 8) % 864;
+					snprintf(line, sizeof(line), "%u", gid);
+					text += line;
+					if (x + 1 < width || y + 1 < height) text += ',';
+				}
+				text += '\n';
+			}
+			text += "</data>\n </layer>\n";
+		}
+		text += "</map>\n";
+
+		return std::vector<char>(text.begin(), text.end());
+	}
+
+	struct Result {
+		double best_ms     = 0;
+		size_t peak_bytes  = 0;
+		size_t allocations = 0; // of the last run
+		bool   ok          = true;
+	};
+
+	/**
+	 * @param prepare Runs before each parse, outside of the time and the peak
+	 */
+	template <typename Prepare, typename Parse> Result measure(int runs, Prepare prepare, Parse parse) {
+		Result result;
+		result.best_ms = 1e30;
+
+		for (int i = 0; i < runs; ++i) {
+			prepare();
+
+			reset_heap_peak();
+			size_t before      = heap_current;
+			size_t allocations = heap_allocations;
+
+			auto start = std::chrono::steady_clock::now();
+			result.ok &= parse();
+			auto end = std::chrono::steady_clock::now();
+
+			result.best_ms     = std::min(result.best_ms, std::chrono::duration<double, std::milli>(end - start).count());
+			result.peak_bytes  = std::max(result.peak_bytes, heap_peak - before);
+			result.allocations = heap_allocations - allocations;
+		}
+		return result;
+	}
+
+	void print_result(const char *mode, const Result &result) {
+		const char *status = result.ok ? "" : "  FAILED";
+		printf("  %-22s %9.3f ms %10.1f KB %7zu allocations%s\n",
+		       mode,
+		       result.best_ms,
+		       result.peak_bytes / 1024.0,
+		       result.allocations,
+		       status);
+	}
+
+	void benchmark(const std::string &name, const std::vector<char> &text, int runs) {
+		printf("%s: %.1f KB of text\n", name.c_str(), text.size() / 1024.0);
+
+		auto nothing = []() {};
+
+		print_result("tinyxml2 Parse", measure(runs, nothing, [&]() {
+			             tinyxml2::XMLDocument document;
+			             return document.Parse(text.data(), text.size()) == tinyxml2::XML_SUCCESS;
+		             }));
+
+		// ParseInSitu changes the text, each run tokenizes a fresh copy of it like a freshly loaded file
+		std::vector<char> buffer;
+		buffer.reserve(text.size() + 1);
+		auto reload = [&]() {
+			buffer.assign(text.begin(), text.end());
+			buffer.push_back(0);
+		};
+
+		print_result("tinyxml2 ParseInSitu", measure(runs, reload, [&]() {
+			             tinyxml2::XMLDocument document;
+			             return document.ParseInSitu(buffer.data(), text.size()) == tinyxml2::XML_SUCCESS;
+		             }));
+
+		// the arena outlives the documents, the first run fills it and the others reuse it
+		tinyxml2::XMLArena arena;
+		print_result("tinyxml2 shared arena", measure(runs, reload, [&]() {
+			             tinyxml2::XMLDocument document(true, tinyxml2::PRESERVE_WHITESPACE, &arena);
+			             return document.ParseInSitu(buffer.data(), text.size()) == tinyxml2::XML_SUCCESS;
+		             }));
+
+		tinyxml2::XMLArenaStats stats = arena.Stats();
+		printf("  %-22s %d nodes at most, %.1f KB held in %d heap allocations\n",
+		       "arena",
+		       stats.peakNodes,
+		       stats.bytesHeld / 1024.0,
+		       stats.heapAllocs);
+
+		print_result("TileMap::parse", measure(runs, nothing, [&]() {
+			             TileMap map;
+			             return map.parse(text.data(), text.size(), name);
+		             }));
+	}
+
+	void benchmark_small(const std::string &name, const std::vector<char> &text, int runs) {
+		const int count = 50;
+		printf("%s: %.1f KB of text, loaded %d times\n", name.c_str(), text.size() / 1024.0, count);
+
+		std::vector<char> buffer;
+		buffer.reserve(text.size() + 1);
+		auto nothing = []() {};
+
+		print_result("tinyxml2 own arenas", measure(runs, nothing, [&]() {
+			             bool ok = true;
+			             for (int i = 0; i < count; ++i) {
+				             buffer.assign(text.begin(), text.end());
+				             buffer.push_back(0);
+
+				             tinyxml2::XMLDocument document;
+				             ok &= document.ParseInSitu(buffer.data(), text.size()) == tinyxml2::XML_SUCCESS;
+			             }
+			             return ok;
+		             }));
+
+		tinyxml2::XMLArena arena;
+		print_result("tinyxml2 shared arena", measure(runs, nothing, [&]() {
+			             bool ok = true;
+			             for (int i = 0; i < count; ++i) {
+				             buffer.assign(text.begin(), text.end());
+				             buffer.push_back(0);
+
+				             tinyxml2::XMLDocument document(true, tinyxml2::PRESERVE_WHITESPACE, &arena);
+				             ok &= document.ParseInSitu(buffer.data(), text.size()) == tinyxml2::XML_SUCCESS;
+			             }
+			             return ok;
+		             }));
+	}
+} // namespace
+
+void *operator new(size_t size) {
+	size_t *block = (size_t *)malloc(size + sizeof(size_t) * 2);
+	if (block == nullptr) throw std::bad_alloc();
+
+	block[0] = size;
+	heap_current += size;
+	++heap_allocations;
+	heap_peak = std::max(heap_peak, heap_current);
+	return block + 2;
+}
+
+void operator delete(void *pointer) noexcept {
+	if (pointer == nullptr) return;
+
+	size_t *block = (size_t *)pointer - 2;
+	heap_current -= block[0];
+	free(block);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+	operator delete(pointer);
+}
+
+int main(int argc, char **argv) {
+	const int runs = 5;
+
+	for (int i = 1; i < argc; ++i) {
+		bool        small = strcmp(argv[i], "--small") == 0 && i + 1 < argc;
+		const char *path  = small ? argv[++i] : argv[i];
+
+		std::vector<char> text;
+		if (!read_file(path, text)) {
+			printf("xml_benchmark - cannot read %s\n", path);
+			return 1;
+		}
+
+		if (small) {
+			benchmark_small(path, text, runs);
+		} else {
+			benchmark(path, text, runs);
+		}
+	}
+
+	const int sizes[][2] = {{256, 256}, {1024, 1024}};
+	for (const auto &size : sizes) {
+		std::string name = "synthetic " + std::to_string(size[0]) + "x" + std::to_string(size[1]);
+		benchmark(name, make_map(size[0], size[1]), runs);
+	}
+	return 0;
+}